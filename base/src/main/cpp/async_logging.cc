@@ -0,0 +1,469 @@
+#include "async_logging.h"
+
+#include <string.h>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "logging.h"
+#include "string/string_builder.h"
+#include "structured_log.h"
+#include "synchronization/waitable_event.h"
+
+namespace base {
+
+namespace {
+
+constexpr size_t kMinBufferSize = 4096;
+
+// Each message is stored behind a RecordHeader, NUL-terminated and padded so
+// that the next header is aligned. A header with size kWrapMarker fills the
+// end of the ring that was too short for the following record. The size of
+// an encoded BASE_SLOG record has kBinaryFlag set.
+struct RecordHeader {
+  uint32_t size;
+  int32_t severity;
+};
+
+constexpr uint32_t kWrapMarker = UINT32_MAX;
+constexpr uint32_t kBinaryFlag = 1u << 31;
+
+// A record in a ring, as the drainer sees it.
+struct QueuedRecord {
+  LogSeverity severity;
+  bool binary;
+  std::string_view data;
+};
+
+size_t RecordSpace(size_t message_size) {
+  const size_t space = sizeof(RecordHeader) + message_size + 1;
+  return (space + sizeof(RecordHeader) - 1) & ~(sizeof(RecordHeader) - 1);
+}
+
+size_t RoundUpToPowerOfTwo(size_t size) {
+  size_t result = kMinBufferSize;
+  while (result < size) {
+    result *= 2;
+  }
+  return result;
+}
+
+// Single-producer, single-consumer byte ring. The producer is the thread the
+// ring belongs to and the consumer is whoever holds the drain lock. Positions
+// only grow; they are masked when used as offsets.
+class Ring {
+ public:
+  explicit Ring(size_t capacity)
+      : data_(new char[capacity]), capacity_(capacity) {}
+
+  size_t capacity() const { return capacity_; }
+
+  // Producer side. Returns false, and counts a drop, if the ring is full.
+  // Sets |*filling| once the ring is more than half full.
+  bool TryWrite(LogSeverity severity,
+                std::string_view data,
+                bool binary,
+                bool* filling) {
+    const size_t size = data.size();
+    const size_t space = RecordSpace(size);
+    size_t head = head_.load(std::memory_order_relaxed);
+    const size_t tail = tail_.load(std::memory_order_acquire);
+    size_t offset = head & (capacity_ - 1);
+    const size_t to_end = capacity_ - offset;
+    const size_t skip = to_end < space ? to_end : 0;
+    if (capacity_ - (head - tail) < skip + space) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      *filling = true;
+      return false;
+    }
+    if (skip != 0) {
+      const RecordHeader wrap = {kWrapMarker, 0};
+      memcpy(data_.get() + offset, &wrap, sizeof(wrap));
+      head += skip;
+      offset = 0;
+    }
+    const RecordHeader header = {
+        static_cast<uint32_t>(size) | (binary ? kBinaryFlag : 0),
+        static_cast<int32_t>(severity)};
+    char* out = data_.get() + offset;
+    memcpy(out, &header, sizeof(header));
+    memcpy(out + sizeof(header), data.data(), size);
+    out[sizeof(header) + size] = '\0';
+    head += space;
+    head_.store(head, std::memory_order_release);
+    *filling = head - tail > capacity_ / 2;
+    return true;
+  }
+
+  // Consumer side. Appends the queued records to |records| and returns the
+  // position to pass to Release() once they have been sent; until then they
+  // point into the ring.
+  size_t Collect(std::vector<QueuedRecord>* records) const {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    const size_t head = head_.load(std::memory_order_acquire);
+    while (tail != head) {
+      const size_t offset = tail & (capacity_ - 1);
+      RecordHeader header;
+      memcpy(&header, data_.get() + offset, sizeof(header));
+      if (header.size == kWrapMarker) {
+        tail += capacity_ - offset;
+        continue;
+      }
+      const size_t size = header.size & ~kBinaryFlag;
+      records->push_back(
+          {header.severity, (header.size & kBinaryFlag) != 0,
+           std::string_view(data_.get() + offset + sizeof(header), size)});
+      tail += RecordSpace(size);
+    }
+    return tail;
+  }
+
+  void Release(size_t tail) { tail_.store(tail, std::memory_order_release); }
+
+  bool IsEmpty() const {
+    return tail_.load(std::memory_order_relaxed) ==
+           head_.load(std::memory_order_acquire);
+  }
+
+  std::atomic<uint64_t> dropped{0};
+  // Set when the owning thread exits; the drainer frees the ring once it is
+  // empty.
+  std::atomic<bool> retired{false};
+  // Sends in progress on the owning thread, which alone changes it; more
+  // than one if a sink logs. Stop() waits for it to drop to zero.
+  std::atomic<uint32_t> writers{0};
+
+ private:
+  const std::unique_ptr<char[]> data_;
+  const size_t capacity_;
+  // On separate cache lines, so that the producer and the consumer do not
+  // invalidate each other's line on every record.
+  alignas(64) std::atomic<size_t> head_{0};
+  alignas(64) std::atomic<size_t> tail_{0};
+};
+
+// The calling thread's ring. These are trivially destructible, so they stay
+// usable while other thread-locals are destroyed at thread exit.
+thread_local Ring* t_ring = nullptr;
+thread_local bool t_exiting = false;
+// Set on the thread that is draining, whose own logging must not drain again.
+thread_local bool t_draining = false;
+
+struct RingRetirer {
+  ~RingRetirer() {
+    if (t_ring != nullptr) {
+      t_ring->retired.store(true, std::memory_order_release);
+    }
+    t_ring = nullptr;
+    t_exiting = true;
+  }
+};
+
+thread_local RingRetirer t_retirer;
+
+class AsyncLogger {
+ public:
+  static AsyncLogger& Get() {
+    // Leaked, so that threads logging during exit never see it destroyed.
+    static AsyncLogger* logger = new AsyncLogger();
+    return *logger;
+  }
+
+  bool Start(const AsyncLoggingOptions& options) {
+    std::scoped_lock lock(control_mutex_);
+    if (drainer_.joinable()) {
+      return false;
+    }
+    sink_.store(options.sink, std::memory_order_relaxed);
+    binary_sink_.store(options.binary_sink, std::memory_order_relaxed);
+    buffer_size_.store(RoundUpToPowerOfTwo(options.buffer_size),
+                       std::memory_order_relaxed);
+    flush_interval_ = options.flush_interval;
+    stopping_.store(false, std::memory_order_relaxed);
+    drainer_ = std::thread([this] { DrainerMain(); });
+    running_.store(true, std::memory_order_release);
+    return true;
+  }
+
+  void Stop() {
+    std::scoped_lock lock(control_mutex_);
+    if (!drainer_.joinable()) {
+      return;
+    }
+    running_.store(false, std::memory_order_seq_cst);
+    WaitForWriters();
+    stopping_.store(true, std::memory_order_relaxed);
+    wake_.Signal();
+    drainer_.join();
+    // Picks up messages queued by threads that saw running_ just before it
+    // was cleared.
+    Flush();
+  }
+
+  void Flush() {
+    if (t_draining) {
+      return;
+    }
+    std::scoped_lock lock(drain_mutex_);
+    DrainAll();
+  }
+
+  bool Send(const LogRecord& record) {
+    Ring* ring = BeginWrite();
+    if (ring == nullptr) {
+      return false;
+    }
+    if (RecordSpace(record.message.size()) > ring->capacity() / 2) {
+      // Sent after this thread's queued messages, to keep them in order.
+      Flush();
+      sink()->Send(record);
+    } else {
+      Queue(ring, record.severity, record.message, false);
+    }
+    EndWrite(ring);
+    return true;
+  }
+
+  bool SendBinary(LogSeverity severity, std::string_view record) {
+    Ring* ring = BeginWrite();
+    if (ring == nullptr) {
+      return false;
+    }
+    const bool fits = RecordSpace(record.size()) <= ring->capacity() / 2;
+    if (fits) {
+      Queue(ring, severity, record, true);
+    }
+    EndWrite(ring);
+    return fits;
+  }
+
+  LogSink* sink() const { return sink_.load(std::memory_order_relaxed); }
+
+  bool running() const { return running_.load(std::memory_order_acquire); }
+
+  uint64_t dropped() const {
+    return total_dropped_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  AsyncLogger() = default;
+
+  // Returns the calling thread's ring, registered as being written to, or
+  // null if async logging is off. The write must end with EndWrite().
+  Ring* BeginWrite() {
+    if (!running_.load(std::memory_order_acquire)) {
+      return nullptr;
+    }
+    Ring* ring = GetThreadRing();
+    if (ring == nullptr) {
+      return nullptr;
+    }
+    // Sequentially consistent, like the accesses in Stop(): either Stop()
+    // sees this writer and waits for it, or this sees running_ cleared.
+    ring->writers.store(ring->writers.load(std::memory_order_relaxed) + 1,
+                        std::memory_order_seq_cst);
+    if (!running_.load(std::memory_order_seq_cst)) {
+      EndWrite(ring);
+      return nullptr;
+    }
+    return ring;
+  }
+
+  void EndWrite(Ring* ring) {
+    ring->writers.store(ring->writers.load(std::memory_order_relaxed) - 1,
+                        std::memory_order_release);
+  }
+
+  // Waits out the writes that began before running_ was cleared, so that the
+  // final drain in Stop() sees what they queue.
+  void WaitForWriters() {
+    while (true) {
+      {
+        // Not held while waiting: a writer may be flushing, which takes it.
+        std::scoped_lock lock(rings_mutex_);
+        bool busy = false;
+        for (const auto& ring : rings_) {
+          busy |= ring->writers.load(std::memory_order_seq_cst) != 0;
+        }
+        if (!busy) {
+          return;
+        }
+      }
+      std::this_thread::yield();
+    }
+  }
+
+  void Queue(Ring* ring,
+             LogSeverity severity,
+             std::string_view data,
+             bool binary) {
+    bool filling = false;
+    ring->TryWrite(severity, data, binary, &filling);
+    if (filling && !wake_pending_.exchange(true, std::memory_order_relaxed)) {
+      wake_.Signal();
+    }
+  }
+
+  Ring* GetThreadRing() {
+    if (t_ring != nullptr || t_exiting) {
+      return t_ring;
+    }
+    // Constructs the retirer, whose destructor hands the ring back.
+    static_cast<void>(&t_retirer);
+    auto ring =
+        std::make_unique<Ring>(buffer_size_.load(std::memory_order_relaxed));
+    t_ring = ring.get();
+    std::scoped_lock lock(rings_mutex_);
+    rings_.push_back(std::move(ring));
+    return t_ring;
+  }
+
+  void DrainerMain() {
+    while (!stopping_.load(std::memory_order_relaxed)) {
+      wake_.WaitWithTimeout(flush_interval_);
+      wake_pending_.store(false, std::memory_order_relaxed);
+      Flush();
+    }
+  }
+
+  // Requires drain_mutex_.
+  void DrainAll() {
+    t_draining = true;
+    std::vector<Ring*> rings;
+    {
+      std::scoped_lock lock(rings_mutex_);
+      rings.reserve(rings_.size());
+      for (const auto& ring : rings_) {
+        rings.push_back(ring.get());
+      }
+    }
+
+    queued_.clear();
+    std::vector<size_t> tails;
+    tails.reserve(rings.size());
+    uint64_t dropped = 0;
+    for (Ring* ring : rings) {
+      tails.push_back(ring->Collect(&queued_));
+      dropped += ring->dropped.exchange(0, std::memory_order_relaxed);
+    }
+    LogSink* sink = this->sink();
+    BinaryLogSink* binary_sink =
+        binary_sink_.load(std::memory_order_relaxed);
+    text_.clear();
+    binary_.clear();
+    // Holds the text of formatted BASE_SLOG records until they are sent.
+    std::deque<std::string> formatted;
+    for (const QueuedRecord& record : queued_) {
+      if (!record.binary) {
+        text_.push_back({record.severity, record.data});
+      } else if (binary_sink != nullptr) {
+        binary_.push_back(record.data);
+      } else {
+        string::StringBuilder message;
+        FormatStructuredRecord(record.data, &message);
+        message.push_back('\0');
+        formatted.push_back(message.ToString());
+        const std::string& text = formatted.back();
+        text_.push_back({record.severity,
+                         std::string_view(text.data(), text.size() - 1)});
+      }
+    }
+    if (!text_.empty()) {
+      sink->SendBatch(text_.data(), text_.size());
+    }
+    if (!binary_.empty()) {
+      binary_sink->SendBatch(binary_.data(), binary_.size());
+    }
+    bool any_retired = false;
+    for (size_t i = 0; i < rings.size(); i++) {
+      rings[i]->Release(tails[i]);
+      any_retired |= rings[i]->retired.load(std::memory_order_acquire);
+    }
+
+    if (dropped != 0) {
+      total_dropped_.fetch_add(dropped, std::memory_order_relaxed);
+      string::StringBuilder message;
+      AppendLogPrefix(kLogWarning, __FILE__, __LINE__, &message);
+      message.Append("Dropped ", dropped, " log messages\n");
+      message.push_back('\0');
+      sink->Send({kLogWarning,
+                  std::string_view(message.data(), message.size() - 1)});
+    }
+
+    if (any_retired) {
+      std::scoped_lock lock(rings_mutex_);
+      for (auto it = rings_.begin(); it != rings_.end();) {
+        if ((*it)->retired.load(std::memory_order_acquire) &&
+            (*it)->IsEmpty()) {
+          it = rings_.erase(it);
+        } else {
+          ++it;
+        }
+      }
+    }
+    t_draining = false;
+  }
+
+  std::atomic<bool> running_{false};
+  std::atomic<LogSink*> sink_{nullptr};
+  std::atomic<BinaryLogSink*> binary_sink_{nullptr};
+  std::atomic<size_t> buffer_size_{0};
+  std::atomic<uint64_t> total_dropped_{0};
+
+  // Serializes Start() and Stop().
+  std::mutex control_mutex_;
+  std::thread drainer_;
+  TimeDelta flush_interval_;
+  std::atomic<bool> stopping_{false};
+  AutoResetWaitableEvent wake_;
+  // Keeps producers from signaling |wake_| again before the drainer ran.
+  std::atomic<bool> wake_pending_{false};
+
+  // Held by whoever consumes from the rings.
+  std::mutex drain_mutex_;
+  std::vector<QueuedRecord> queued_;
+  std::vector<LogRecord> text_;
+  std::vector<std::string_view> binary_;
+
+  std::mutex rings_mutex_;
+  std::vector<std::unique_ptr<Ring>> rings_;
+};
+
+}  // namespace
+
+bool StartAsyncLogging(const AsyncLoggingOptions& options) {
+  return AsyncLogger::Get().Start(options);
+}
+
+void StopAsyncLogging() {
+  AsyncLogger::Get().Stop();
+}
+
+void FlushAsyncLogging() {
+  AsyncLogger::Get().Flush();
+}
+
+uint64_t GetDroppedLogMessageCount() {
+  return AsyncLogger::Get().dropped();
+}
+
+bool SendToAsyncLog(const LogRecord& record) {
+  return AsyncLogger::Get().Send(record);
+}
+
+bool SendBinaryToAsyncLog(LogSeverity severity, std::string_view record) {
+  return AsyncLogger::Get().SendBinary(severity, record);
+}
+
+LogSink* GetActiveLogSink() {
+  AsyncLogger& logger = AsyncLogger::Get();
+  return logger.running() ? logger.sink() : GetSystemLogSink();
+}
+
+}  // namespace base
@@ -0,0 +1,67 @@
+#ifndef ASYNC_LOGGING_H_
+#define ASYNC_LOGGING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string_view>
+
+#include "log_level.h"
+#include "log_sink.h"
+#include "time/time_delta.h"
+
+namespace base {
+
+struct AsyncLoggingOptions {
+  // Where the drainer sends messages. Must outlive the async backend.
+  LogSink* sink = GetSystemLogSink();
+  // Where the drainer sends BASE_SLOG records (see structured_log.h). If
+  // null, they are formatted and sent to |sink| instead.
+  BinaryLogSink* binary_sink = nullptr;
+  // Size of the ring buffer of each logging thread, rounded up to a power of
+  // two. A message that does not fit in half of it is written synchronously.
+  size_t buffer_size = 64 * 1024;
+  // How long the drainer sleeps when no buffer is filling up.
+  TimeDelta flush_interval = TimeDelta::FromMilliseconds(20);
+};
+
+// While async logging runs, BASE_LOG hands each formatted message to a ring
+// buffer owned by the logging thread, without taking a lock, and a background
+// drainer sends them to the sink in batches. Messages from one thread keep
+// their order; messages from different threads may be interleaved
+// differently than they were logged.
+//
+// A message that finds its thread's buffer full is dropped. The drainer
+// reports drops as a WARNING message of its own, and
+// GetDroppedLogMessageCount() counts them.
+//
+// FATAL messages drain every buffer and are then written on the calling
+// thread, before the process is killed.
+
+// Starts the drainer. Returns false if async logging is already running.
+bool StartAsyncLogging(const AsyncLoggingOptions& options = {});
+
+// Stops the drainer after it has sent everything logged before the call.
+// Logging is synchronous again afterwards.
+void StopAsyncLogging();
+
+// Sends everything logged so far, on the calling thread.
+void FlushAsyncLogging();
+
+// Number of dropped messages the drainer has reported so far.
+uint64_t GetDroppedLogMessageCount();
+
+// Queues |record| if async logging is running and returns false otherwise,
+// in which case the caller sends it itself. For LogMessage.
+bool SendToAsyncLog(const LogRecord& record);
+
+// Like SendToAsyncLog(), for an encoded BASE_SLOG record. Records that do not
+// fit in half a ring buffer are refused as well.
+bool SendBinaryToAsyncLog(LogSeverity severity, std::string_view record);
+
+// The sink messages currently go to.
+LogSink* GetActiveLogSink();
+
+}  // namespace base
+
+#endif  // ASYNC_LOGGING_H_
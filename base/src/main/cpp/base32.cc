@@ -1,72 +1,150 @@
 #include "base32.h"
 
-#include <cstdint>  // uint8_t
+#include <cstring>
 #include <limits>
-#include <string>
 
 namespace base {
 
-static constexpr char kEncoding[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ234567";
+namespace {
 
-std::pair<bool, std::string> Base32Encode(std::string_view input) {
-  if (input.empty()) {
-    return {true, ""};
+constexpr char kEncoding[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ234567";
+
+constexpr uint8_t kInvalid = 0xFF;
+
+// Both characters for every 10-bit value, in output order, so that a 5 byte
+// group takes four lookups.
+struct EncodePairs {
+  char pairs[1024][2];
+};
+
+constexpr EncodePairs MakeEncodePairs() {
+  EncodePairs table{};
+  for (int i = 0; i < 1024; i++) {
+    table.pairs[i][0] = kEncoding[i >> 5];
+    table.pairs[i][1] = kEncoding[i & 0x1F];
   }
+  return table;
+}
 
-  if (input.size() > std::numeric_limits<size_t>::max() / 8) {
-    return {false, ""};
+// The 5-bit value of each character, or kInvalid.
+struct DecodeTable {
+  uint8_t values[256];
+};
+
+constexpr DecodeTable MakeDecodeTable() {
+  DecodeTable table{};
+  for (int i = 0; i < 256; i++) {
+    table.values[i] = kInvalid;
   }
+  for (int i = 0; i < 32; i++) {
+    table.values[static_cast<uint8_t>(kEncoding[i])] = static_cast<uint8_t>(i);
+  }
+  return table;
+}
 
-  std::string output;
-  const size_t encoded_length = (input.size() * 8 + 4) / 5;
-  output.reserve(encoded_length);
+constexpr EncodePairs kEncodePairs = MakeEncodePairs();
+constexpr DecodeTable kDecodeTable = MakeDecodeTable();
 
-  Base32EncodeConverter converter;
-  converter.Append(static_cast<uint8_t>(input[0]));
-  size_t next_byte_index = 1;
+}  // namespace
 
-  while (converter.CanExtract()) {
-    output.push_back(kEncoding[converter.Extract()]);
-    if (converter.CanAppend() && next_byte_index < input.size()) {
-      converter.Append(static_cast<uint8_t>(input[next_byte_index++]));
-    }
+size_t Base32EncodeTo(std::string_view input, char* output) {
+  const uint8_t* src = reinterpret_cast<const uint8_t*>(input.data());
+  const size_t size = input.size();
+  char* dst = output;
+  size_t i = 0;
+  for (; size - i >= 5; i += 5) {
+    const uint64_t v = static_cast<uint64_t>(src[i]) << 32 |
+                       static_cast<uint64_t>(src[i + 1]) << 24 |
+                       static_cast<uint64_t>(src[i + 2]) << 16 |
+                       static_cast<uint64_t>(src[i + 3]) << 8 | src[i + 4];
+    memcpy(dst, kEncodePairs.pairs[v >> 30], 2);
+    memcpy(dst + 2, kEncodePairs.pairs[(v >> 20) & 0x3FF], 2);
+    memcpy(dst + 4, kEncodePairs.pairs[(v >> 10) & 0x3FF], 2);
+    memcpy(dst + 6, kEncodePairs.pairs[v & 0x3FF], 2);
+    dst += 8;
   }
-
-  if (converter.BitsAvailable() > 0) {
-    output.push_back(kEncoding[converter.Peek()]);
+  // The last 1 to 4 bytes, zero-extended to a full group.
+  const size_t remaining = size - i;
+  if (remaining > 0) {
+    uint64_t v = 0;
+    for (size_t k = 0; k < remaining; k++) {
+      v |= static_cast<uint64_t>(src[i + k]) << (32 - 8 * k);
+    }
+    const size_t chars = (remaining * 8 + 4) / 5;
+    for (size_t k = 0; k < chars; k++) {
+      *dst++ = kEncoding[(v >> (35 - 5 * k)) & 0x1F];
+    }
   }
-
-  return {true, output};
+  return dst - output;
 }
 
-static constexpr signed char kDecodeMap[] = {
-    // starting from ASCII 50 '2'
-    26, 27, 28, 29, 30, 31, -1, -1, -1, -1, -1, -1, -1, -1,
-    -1, 0,  1,  2,  3,  4,  5,  6,  7,  8,  9,  10, 11, 12,
-    13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25};
-
-static constexpr int kDecodeMapSize =
-    sizeof(kDecodeMap) / sizeof(kDecodeMap[0]);
-
-std::pair<bool, std::string> Base32Decode(const std::string& input) {
-  std::string result;
-  Base32DecodeConverter converter;
-  for (char c : input) {
-    int map_index = c - '2';
-    if (map_index < 0 || map_index >= kDecodeMapSize ||
-        kDecodeMap[map_index] == -1) {
-      return {false, result};
+bool Base32DecodeTo(std::string_view input, uint8_t* output, size_t* written) {
+  const uint8_t* src = reinterpret_cast<const uint8_t*>(input.data());
+  const uint8_t* values = kDecodeTable.values;
+  const size_t size = input.size();
+  uint8_t* dst = output;
+  size_t i = 0;
+  for (; size - i >= 8; i += 8) {
+    const uint32_t a[8] = {values[src[i]],     values[src[i + 1]],
+                           values[src[i + 2]], values[src[i + 3]],
+                           values[src[i + 4]], values[src[i + 5]],
+                           values[src[i + 6]], values[src[i + 7]]};
+    if ((a[0] | a[1] | a[2] | a[3] | a[4] | a[5] | a[6] | a[7]) & 0xE0) {
+      break;
+    }
+    // Two independent 20-bit halves.
+    const uint32_t high = a[0] << 15 | a[1] << 10 | a[2] << 5 | a[3];
+    const uint32_t low = a[4] << 15 | a[5] << 10 | a[6] << 5 | a[7];
+    const uint64_t v = static_cast<uint64_t>(high) << 20 | low;
+    dst[0] = static_cast<uint8_t>(v >> 32);
+    dst[1] = static_cast<uint8_t>(v >> 24);
+    dst[2] = static_cast<uint8_t>(v >> 16);
+    dst[3] = static_cast<uint8_t>(v >> 8);
+    dst[4] = static_cast<uint8_t>(v);
+    dst += 5;
+  }
+  // The last partial group, or the group holding a bad character.
+  uint32_t buffer = 0;
+  int bits = 0;
+  for (; i < size; i++) {
+    const uint8_t value = values[src[i]];
+    if (value == kInvalid) {
+      *written = dst - output;
+      return false;
     }
-    converter.Append(kDecodeMap[map_index]);
-    if (converter.CanExtract()) {
-      result.push_back(converter.Extract());
+    buffer = buffer << 5 | value;
+    bits += 5;
+    if (bits >= 8) {
+      bits -= 8;
+      *dst++ = static_cast<uint8_t>(buffer >> bits);
     }
   }
-  if (converter.Peek() != 0) {
-    // The padding should always be zero. Return false if not.
-    return {false, result};
+  *written = dst - output;
+  // The padding should always be zero. Return false if not.
+  return (buffer & ((1u << bits) - 1)) == 0;
+}
+
+std::pair<bool, std::string> Base32Encode(std::string_view input) {
+  if (input.empty()) {
+    return {true, ""};
   }
-  return {true, result};
+
+  if (input.size() > std::numeric_limits<size_t>::max() / 8) {
+    return {false, ""};
+  }
+
+  std::string output(Base32EncodedSize(input.size()), '\0');
+  Base32EncodeTo(input, &output[0]);
+  return {true, std::move(output)};
+}
+
+std::pair<bool, std::string> Base32Decode(std::string_view input) {
+  std::string result(Base32DecodedSize(input.size()), '\0');
+  size_t written = 0;
+  const bool ok = Base32DecodeTo(
+      input, reinterpret_cast<uint8_t*>(&result[0]), &written);
+  result.resize(written);
+  return {ok, std::move(result)};
 }
 
 }  // namespace base
@@ -5,6 +5,9 @@
 #ifndef BASE_BASE32_H_
 #define BASE_BASE32_H_
 
+#include <cstddef>
+#include <cstdint>
+#include <string>
 #include <string_view>
 #include <utility>
 
@@ -49,8 +52,32 @@ class BitConverter {
 using Base32DecodeConverter = BitConverter<5, 8, 16>;
 using Base32EncodeConverter = BitConverter<8, 5, 16>;
 
+// Base32 (RFC 4648 alphabet, unpadded) conversions. Whole 5 byte / 8
+// character groups are converted at once through lookup tables, and the
+// output is allocated once at its exact size.
 std::pair<bool, std::string> Base32Encode(std::string_view input);
-std::pair<bool, std::string> Base32Decode(const std::string& input);
+std::pair<bool, std::string> Base32Decode(std::string_view input);
+
+// Number of characters Base32Encode() produces for |size| bytes.
+constexpr size_t Base32EncodedSize(size_t size) {
+  return size / 5 * 8 + (size % 5 * 8 + 4) / 5;
+}
+
+// Number of bytes Base32Decode() produces for |size| characters.
+constexpr size_t Base32DecodedSize(size_t size) {
+  return size / 8 * 5 + size % 8 * 5 / 8;
+}
+
+// Encodes |input| into |output|, which must have room for
+// Base32EncodedSize(input.size()) characters. Returns the number written.
+size_t Base32EncodeTo(std::string_view input, char* output);
+
+// Decodes |input| into |output|, which must have room for
+// Base32DecodedSize(input.size()) bytes, and sets |written| to the number of
+// bytes decoded. Returns false on a character outside the alphabet or
+// non-zero trailing bits; |written| then counts the bytes decoded before the
+// error.
+bool Base32DecodeTo(std::string_view input, uint8_t* output, size_t* written);
 
 }  // namespace base
 
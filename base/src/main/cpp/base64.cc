@@ -3,154 +3,712 @@
 #include "logging.h"
 
 #include <cstdint>
+#include <cstring>
 
-#define DecodePad -2
-#define EncodePad 64
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BASE64_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define BASE64_NEON 1
+#endif
 
-static const char kDefaultEncode[] =
-    "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-    "abcdefghijklmnopqrstuvwxyz"
-    "0123456789+/=";
+namespace base {
 
-static const signed char kDecodeData[] = {
-    62, -1, -1,        -1, 63, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -1,
-    -1, -1, DecodePad, -1, -1, -1, 0,  1,  2,  3,  4,  5,  6,  7,  8,  9,
-    10, 11, 12,        13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25,
-    -1, -1, -1,        -1, -1, -1, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35,
-    36, 37, 38,        39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51};
+namespace {
 
-namespace base {
+constexpr uint8_t kInvalid = 0xFF;
+
+struct AlphabetTables {
+  char encode[64];
+  // The 6-bit value of each character, or kInvalid if it is not part of the
+  // alphabet. Padding and whitespace are invalid here; only the slow path
+  // handles them.
+  uint8_t decode[256];
+  char c62;
+  char c63;
+};
+
+constexpr AlphabetTables MakeTables(char c62, char c63) {
+  AlphabetTables tables{};
+  for (int i = 0; i < 26; i++) {
+    tables.encode[i] = static_cast<char>('A' + i);
+    tables.encode[26 + i] = static_cast<char>('a' + i);
+  }
+  for (int i = 0; i < 10; i++) {
+    tables.encode[52 + i] = static_cast<char>('0' + i);
+  }
+  tables.encode[62] = c62;
+  tables.encode[63] = c63;
+  for (int i = 0; i < 256; i++) {
+    tables.decode[i] = kInvalid;
+  }
+  for (int i = 0; i < 64; i++) {
+    tables.decode[static_cast<uint8_t>(tables.encode[i])] =
+        static_cast<uint8_t>(i);
+  }
+  tables.c62 = c62;
+  tables.c63 = c63;
+  return tables;
+}
+
+constexpr AlphabetTables kStandardTables = MakeTables('+', '/');
+constexpr AlphabetTables kUrlSafeTables = MakeTables('-', '_');
+
+const AlphabetTables& GetTables(Base64::Alphabet alphabet) {
+  return alphabet == Base64::Alphabet::kUrlSafe ? kUrlSafeTables
+                                                : kStandardTables;
+}
+
+// Kernels encode whole 3 byte groups and decode whole 4 character groups made
+// only of alphabet characters. They return the number of input bytes they
+// consumed, and may stop early to leave the rest to the scalar kernels.
+typedef size_t (*Kernel)(const uint8_t* src,
+                         size_t length,
+                         uint8_t* dst,
+                         const AlphabetTables& tables);
+
+size_t EncodeScalar(const uint8_t* src,
+                    size_t length,
+                    uint8_t* dst,
+                    const AlphabetTables& tables) {
+  const char* encode = tables.encode;
+  size_t done = 0;
+  for (; length - done >= 3; done += 3) {
+    const uint32_t v = static_cast<uint32_t>(src[done]) << 16 |
+                       static_cast<uint32_t>(src[done + 1]) << 8 |
+                       src[done + 2];
+    *dst++ = encode[v >> 18];
+    *dst++ = encode[(v >> 12) & 0x3F];
+    *dst++ = encode[(v >> 6) & 0x3F];
+    *dst++ = encode[v & 0x3F];
+  }
+  return done;
+}
+
+size_t DecodeScalar(const uint8_t* src,
+                    size_t length,
+                    uint8_t* dst,
+                    const AlphabetTables& tables) {
+  const uint8_t* decode = tables.decode;
+  size_t done = 0;
+  for (; length - done >= 4; done += 4) {
+    const uint32_t a = decode[src[done]];
+    const uint32_t b = decode[src[done + 1]];
+    const uint32_t c = decode[src[done + 2]];
+    const uint32_t d = decode[src[done + 3]];
+    if ((a | b | c | d) > 63) {
+      break;
+    }
+    const uint32_t v = a << 18 | b << 12 | c << 6 | d;
+    *dst++ = static_cast<uint8_t>(v >> 16);
+    *dst++ = static_cast<uint8_t>(v >> 8);
+    *dst++ = static_cast<uint8_t>(v);
+  }
+  return done;
+}
+
+#if defined(BASE64_X86)
+
+// The x86 kernels follow Wojciech Muła's pshufb based encoding and
+// multiply-add based packing. Decoding validates with range compares, which
+// works for both alphabets.
+
+// Per 6-bit index class, the offset that turns an index into its character.
+// EncodeSelector() picks the class: 0..25 select 13 ('A'), 26..51 select 0,
+// 52..61 select 1..10 and 62, 63 select 11, 12.
+__attribute__((target("sse4.1"))) inline __m128i EncodeOffsets(
+    const AlphabetTables& tables) {
+  const char digit = '0' - 52;
+  return _mm_setr_epi8('a' - 26, digit, digit, digit, digit, digit, digit,
+                       digit, digit, digit, digit,
+                       static_cast<char>(tables.c62 - 62),
+                       static_cast<char>(tables.c63 - 63), 'A', 0, 0);
+}
+
+__attribute__((target("sse4.1"))) inline __m128i EncodeSelector(
+    __m128i indices) {
+  const __m128i selector = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+  const __m128i upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+  return _mm_or_si128(selector, _mm_and_si128(upper, _mm_set1_epi8(13)));
+}
+
+__attribute__((target("avx2"))) inline __m256i EncodeSelector(
+    __m256i indices) {
+  const __m256i selector = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+  const __m256i upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+  return _mm256_or_si256(selector,
+                         _mm256_and_si256(upper, _mm256_set1_epi8(13)));
+}
+
+// Mask of the bytes in [low, high]. Bytes above 0x7F compare as negative and
+// are never in range.
+__attribute__((target("sse4.1"))) inline __m128i InRange(__m128i in,
+                                                          char low,
+                                                          char high) {
+  return _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8(low - 1)),
+                       _mm_cmpgt_epi8(_mm_set1_epi8(high + 1), in));
+}
+
+__attribute__((target("avx2"))) inline __m256i InRange(__m256i in,
+                                                        char low,
+                                                        char high) {
+  return _mm256_and_si256(_mm256_cmpgt_epi8(in, _mm256_set1_epi8(low - 1)),
+                          _mm256_cmpgt_epi8(_mm256_set1_epi8(high + 1), in));
+}
+
+__attribute__((target("sse4.1"))) size_t EncodeSse(
+    const uint8_t* src,
+    size_t length,
+    uint8_t* dst,
+    const AlphabetTables& tables) {
+  const __m128i spread =
+      _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+  const __m128i offsets = EncodeOffsets(tables);
+  size_t done = 0;
+  // Each step loads 16 bytes and encodes the first 12.
+  for (; length - done >= 16; done += 12) {
+    __m128i in =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + done));
+    in = _mm_shuffle_epi8(in, spread);
+    const __m128i ac = _mm_mulhi_epu16(
+        _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)),
+        _mm_set1_epi32(0x04000040));
+    const __m128i bd = _mm_mullo_epi16(
+        _mm_and_si128(in, _mm_set1_epi32(0x003f03f0)),
+        _mm_set1_epi32(0x01000010));
+    const __m128i indices = _mm_or_si128(ac, bd);
+    const __m128i out = _mm_add_epi8(
+        _mm_shuffle_epi8(offsets, EncodeSelector(indices)), indices);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), out);
+    dst += 16;
+  }
+  return done;
+}
+
+__attribute__((target("sse4.1"))) size_t DecodeSse(
+    const uint8_t* src,
+    size_t length,
+    uint8_t* dst,
+    const AlphabetTables& tables) {
+  const __m128i c62 = _mm_set1_epi8(tables.c62);
+  const __m128i c63 = _mm_set1_epi8(tables.c63);
+  const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12,
+                                     -1, -1, -1, -1);
+  size_t done = 0;
+  for (; length - done >= 16; done += 16) {
+    const __m128i in =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + done));
+    const __m128i upper = InRange(in, 'A', 'Z');
+    const __m128i lower = InRange(in, 'a', 'z');
+    const __m128i digit = InRange(in, '0', '9');
+    const __m128i is62 = _mm_cmpeq_epi8(in, c62);
+    const __m128i is63 = _mm_cmpeq_epi8(in, c63);
+    const __m128i valid =
+        _mm_or_si128(_mm_or_si128(upper, lower),
+                     _mm_or_si128(digit, _mm_or_si128(is62, is63)));
+    if (_mm_movemask_epi8(valid) != 0xFFFF) {
+      break;
+    }
+    __m128i values =
+        _mm_and_si128(upper, _mm_sub_epi8(in, _mm_set1_epi8('A')));
+    values = _mm_or_si128(
+        values, _mm_and_si128(lower, _mm_sub_epi8(in, _mm_set1_epi8(71))));
+    values = _mm_or_si128(
+        values, _mm_and_si128(digit, _mm_add_epi8(in, _mm_set1_epi8(4))));
+    values = _mm_or_si128(values, _mm_and_si128(is62, _mm_set1_epi8(62)));
+    values = _mm_or_si128(values, _mm_and_si128(is63, _mm_set1_epi8(63)));
+    // Merge pairs of 6-bit values into 12 bits, then pairs of those into 24.
+    const __m128i merged = _mm_madd_epi16(
+        _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140)),
+        _mm_set1_epi32(0x00011000));
+    const __m128i out = _mm_shuffle_epi8(merged, pack);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), out);
+    const uint32_t last = static_cast<uint32_t>(_mm_extract_epi32(out, 2));
+    memcpy(dst + 8, &last, sizeof(last));
+    dst += 12;
+  }
+  return done;
+}
+
+__attribute__((target("avx2"))) size_t EncodeAvx2(
+    const uint8_t* src,
+    size_t length,
+    uint8_t* dst,
+    const AlphabetTables& tables) {
+  const __m256i spread = _mm256_broadcastsi128_si256(
+      _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+  const __m256i offsets = _mm256_broadcastsi128_si256(EncodeOffsets(tables));
+  size_t done = 0;
+  // Each step loads two overlapping 16 byte lanes, 12 bytes apart, and
+  // encodes the first 12 bytes of each.
+  for (; length - done >= 28; done += 24) {
+    const __m128i lo =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + done));
+    const __m128i hi =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + done + 12));
+    __m256i in = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+    in = _mm256_shuffle_epi8(in, spread);
+    const __m256i ac = _mm256_mulhi_epu16(
+        _mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00)),
+        _mm256_set1_epi32(0x04000040));
+    const __m256i bd = _mm256_mullo_epi16(
+        _mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0)),
+        _mm256_set1_epi32(0x01000010));
+    const __m256i indices = _mm256_or_si256(ac, bd);
+    const __m256i out = _mm256_add_epi8(
+        _mm256_shuffle_epi8(offsets, EncodeSelector(indices)), indices);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), out);
+    dst += 32;
+  }
+  return done;
+}
+
+__attribute__((target("avx2"))) size_t DecodeAvx2(
+    const uint8_t* src,
+    size_t length,
+    uint8_t* dst,
+    const AlphabetTables& tables) {
+  const __m256i c62 = _mm256_set1_epi8(tables.c62);
+  const __m256i c63 = _mm256_set1_epi8(tables.c63);
+  const __m256i pack = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+      2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+  const __m256i gather = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+  size_t done = 0;
+  for (; length - done >= 32; done += 32) {
+    const __m256i in =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + done));
+    const __m256i upper = InRange(in, 'A', 'Z');
+    const __m256i lower = InRange(in, 'a', 'z');
+    const __m256i digit = InRange(in, '0', '9');
+    const __m256i is62 = _mm256_cmpeq_epi8(in, c62);
+    const __m256i is63 = _mm256_cmpeq_epi8(in, c63);
+    const __m256i valid =
+        _mm256_or_si256(_mm256_or_si256(upper, lower),
+                        _mm256_or_si256(digit, _mm256_or_si256(is62, is63)));
+    if (_mm256_movemask_epi8(valid) != -1) {
+      break;
+    }
+    __m256i values =
+        _mm256_and_si256(upper, _mm256_sub_epi8(in, _mm256_set1_epi8('A')));
+    values = _mm256_or_si256(
+        values,
+        _mm256_and_si256(lower, _mm256_sub_epi8(in, _mm256_set1_epi8(71))));
+    values = _mm256_or_si256(
+        values,
+        _mm256_and_si256(digit, _mm256_add_epi8(in, _mm256_set1_epi8(4))));
+    values =
+        _mm256_or_si256(values, _mm256_and_si256(is62, _mm256_set1_epi8(62)));
+    values =
+        _mm256_or_si256(values, _mm256_and_si256(is63, _mm256_set1_epi8(63)));
+    const __m256i merged = _mm256_madd_epi16(
+        _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140)),
+        _mm256_set1_epi32(0x00011000));
+    // 12 bytes at the start of each lane; move them next to each other.
+    const __m256i out = _mm256_permutevar8x32_epi32(
+        _mm256_shuffle_epi8(merged, pack), gather);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst),
+                     _mm256_castsi256_si128(out));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + 16),
+                     _mm256_extracti128_si256(out, 1));
+    dst += 24;
+  }
+  return done;
+}
+
+#elif defined(BASE64_NEON)
+
+size_t EncodeNeon(const uint8_t* src,
+                  size_t length,
+                  uint8_t* dst,
+                  const AlphabetTables& tables) {
+  const uint8_t* encode = reinterpret_cast<const uint8_t*>(tables.encode);
+  uint8x16x4_t lookup;
+  lookup.val[0] = vld1q_u8(encode);
+  lookup.val[1] = vld1q_u8(encode + 16);
+  lookup.val[2] = vld1q_u8(encode + 32);
+  lookup.val[3] = vld1q_u8(encode + 48);
+  const uint8x16_t mask = vdupq_n_u8(0x3F);
+  size_t done = 0;
+  for (; length - done >= 48; done += 48) {
+    // De-interleave 16 groups of 3 bytes.
+    const uint8x16x3_t in = vld3q_u8(src + done);
+    uint8x16x4_t out;
+    out.val[0] = vshrq_n_u8(in.val[0], 2);
+    out.val[1] = vandq_u8(
+        vorrq_u8(vshlq_n_u8(in.val[0], 4), vshrq_n_u8(in.val[1], 4)), mask);
+    out.val[2] = vandq_u8(
+        vorrq_u8(vshlq_n_u8(in.val[1], 2), vshrq_n_u8(in.val[2], 6)), mask);
+    out.val[3] = vandq_u8(in.val[2], mask);
+    out.val[0] = vqtbl4q_u8(lookup, out.val[0]);
+    out.val[1] = vqtbl4q_u8(lookup, out.val[1]);
+    out.val[2] = vqtbl4q_u8(lookup, out.val[2]);
+    out.val[3] = vqtbl4q_u8(lookup, out.val[3]);
+    vst4q_u8(dst, out);
+    dst += 64;
+  }
+  return done;
+}
+
+size_t DecodeNeon(const uint8_t* src,
+                  size_t length,
+                  uint8_t* dst,
+                  const AlphabetTables& tables) {
+  // The decode table for 7-bit characters as two 64 byte lookups.
+  uint8x16x4_t low;
+  uint8x16x4_t high;
+  for (int i = 0; i < 4; i++) {
+    low.val[i] = vld1q_u8(tables.decode + 16 * i);
+    high.val[i] = vld1q_u8(tables.decode + 64 + 16 * i);
+  }
+  const uint8x16_t flip = vdupq_n_u8(0x40);
+  const uint8x16_t top = vdupq_n_u8(0x80);
+  size_t done = 0;
+  for (; length - done >= 64; done += 64) {
+    uint8x16x4_t in = vld4q_u8(src + done);
+    uint8x16_t error = vdupq_n_u8(0);
+    for (int i = 0; i < 4; i++) {
+      // Out of range indices look up 0, so each character hits exactly one
+      // table, or neither if it is above 0x7F.
+      const uint8x16_t value =
+          vorrq_u8(vqtbl4q_u8(low, in.val[i]),
+                   vqtbl4q_u8(high, veorq_u8(in.val[i], flip)));
+      error = vorrq_u8(error, vorrq_u8(value, vandq_u8(in.val[i], top)));
+      in.val[i] = value;
+    }
+    if (vmaxvq_u8(error) > 63) {
+      break;
+    }
+    uint8x16x3_t out;
+    out.val[0] = vorrq_u8(vshlq_n_u8(in.val[0], 2), vshrq_n_u8(in.val[1], 4));
+    out.val[1] = vorrq_u8(vshlq_n_u8(in.val[1], 4), vshrq_n_u8(in.val[2], 2));
+    out.val[2] = vorrq_u8(vshlq_n_u8(in.val[2], 6), in.val[3]);
+    vst3q_u8(dst, out);
+    dst += 48;
+  }
+  return done;
+}
+
+#endif
+
+struct Kernels {
+  Kernel encode;
+  Kernel decode;
+};
+
+Kernels SelectKernels() {
+#if defined(BASE64_X86)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return {EncodeAvx2, DecodeAvx2};
+  }
+  if (__builtin_cpu_supports("sse4.1")) {
+    return {EncodeSse, DecodeSse};
+  }
+#elif defined(BASE64_NEON)
+  return {EncodeNeon, DecodeNeon};
+#endif
+  return {EncodeScalar, DecodeScalar};
+}
+
+const Kernels& GetKernels() {
+  static const Kernels kernels = SelectKernels();
+  return kernels;
+}
+
+// Encodes length bytes, a multiple of 3, without padding.
+void EncodeGroups(const uint8_t* src,
+                  size_t length,
+                  uint8_t* dst,
+                  const AlphabetTables& tables) {
+  size_t done = GetKernels().encode(src, length, dst, tables);
+  EncodeScalar(src + done, length - done, dst + done / 3 * 4, tables);
+}
+
+// Encodes the last 1 or 2 bytes of the input and returns the number of
+// characters written.
+size_t EncodeTail(const uint8_t* src,
+                  size_t length,
+                  uint8_t* dst,
+                  const AlphabetTables& tables,
+                  bool padding) {
+  if (length == 0) {
+    return 0;
+  }
+  const char* encode = tables.encode;
+  const uint32_t a = src[0];
+  const uint32_t b = length == 2 ? src[1] : 0;
+  *dst++ = encode[a >> 2];
+  *dst++ = encode[(a << 4 | b >> 4) & 0x3F];
+  if (length == 2) {
+    *dst++ = encode[(b << 2) & 0x3F];
+  }
+  if (!padding) {
+    return length + 1;
+  }
+  if (length == 1) {
+    *dst++ = '=';
+  }
+  *dst = '=';
+  return 4;
+}
+
+// Decodes whole groups of alphabet characters and returns the number of
+// characters consumed. dst may be nullptr to only count.
+size_t DecodeGroups(const uint8_t* src,
+                    size_t length,
+                    uint8_t* dst,
+                    size_t* written,
+                    const AlphabetTables& tables) {
+  const Kernel kernel = GetKernels().decode;
+  if (dst) {
+    size_t done = kernel(src, length, dst + *written, tables);
+    done += DecodeScalar(src + done, length - done,
+                         dst + *written + done / 4 * 3, tables);
+    *written += done / 4 * 3;
+    return done;
+  }
+  uint8_t scratch[192];
+  size_t done = 0;
+  while (done < length) {
+    const size_t chunk = length - done < 256 ? length - done : 256;
+    size_t step = kernel(src + done, chunk, scratch, tables);
+    step += DecodeScalar(src + done + step, chunk - step,
+                         scratch + step / 4 * 3, tables);
+    done += step;
+    *written += step / 4 * 3;
+    if (step < chunk / 4 * 4 || step == 0) {
+      break;
+    }
+  }
+  return done;
+}
+
+}  // namespace
+
+Base64::Error Base64::Decode(const void* src,
+                             size_t srcLength,
+                             void* dst,
+                             size_t* dstLength) {
+  return Decode(src, srcLength, dst, dstLength, Options());
+}
 
 Base64::Error Base64::Decode(const void* srcv,
                              size_t srcLength,
                              void* dstv,
-                             size_t* dstLength) {
+                             size_t* dstLength,
+                             const Options& options) {
   const unsigned char* src = static_cast<const unsigned char*>(srcv);
   unsigned char* dst = static_cast<unsigned char*>(dstv);
+  Decoder decoder(options);
+  size_t length = 0;
+  Error error = decoder.Feed(src, srcLength, dst, &length);
+  if (error == Error::kNone) {
+    size_t tail = 0;
+    error = decoder.Flush(dst ? dst + length : nullptr, &tail);
+    length += tail;
+  }
+  *dstLength = length;
+  return error;
+}
 
-  int i = 0;
-  bool padTwo = false;
-  bool padThree = false;
-  char unsigned const* const end = src + srcLength;
-  while (src < end) {
-    unsigned char bytes[4] = {0, 0, 0, 0};
-    int byte = 0;
-    do {
-      unsigned char srcByte = *src++;
-      if (srcByte == 0) {
-        *dstLength = i;
-        return Error::kNone;
-      }
-      if (srcByte <= ' ') {
-        continue;  // treat as white space
+size_t Base64::Encode(const void* src, size_t length, void* dst) {
+  return Encode(src, length, dst, Options());
+}
+
+size_t Base64::Encode(const void* srcv,
+                      size_t length,
+                      void* dstv,
+                      const Options& options) {
+  BASE_DCHECK(dstv);
+  const unsigned char* src = static_cast<const unsigned char*>(srcv);
+  unsigned char* dst = static_cast<unsigned char*>(dstv);
+  const AlphabetTables& tables = GetTables(options.alphabet);
+
+  const size_t whole = length - length % 3;
+  EncodeGroups(src, whole, dst, tables);
+  return whole / 3 * 4 + EncodeTail(src + whole, length - whole,
+                                    dst + whole / 3 * 4, tables,
+                                    options.padding);
+}
+
+Base64::Encoder::Encoder() = default;
+
+Base64::Encoder::Encoder(const Options& options) : options_(options) {}
+
+void Base64::Encoder::Update(const void* srcv,
+                             size_t length,
+                             std::string* out) {
+  const unsigned char* src = static_cast<const unsigned char*>(srcv);
+  const AlphabetTables& tables = GetTables(options_.alphabet);
+  const size_t start = out->size();
+  out->resize(start + (pending_size_ + length) / 3 * 4);
+  unsigned char* dst = reinterpret_cast<unsigned char*>(&(*out)[0]) + start;
+  if (pending_size_ > 0) {
+    if (pending_size_ + length < 3) {
+      memcpy(pending_ + pending_size_, src, length);
+      pending_size_ += length;
+      return;
+    }
+    unsigned char group[3];
+    memcpy(group, pending_, pending_size_);
+    memcpy(group + pending_size_, src, 3 - pending_size_);
+    EncodeScalar(group, 3, dst, tables);
+    dst += 4;
+    src += 3 - pending_size_;
+    length -= 3 - pending_size_;
+    pending_size_ = 0;
+  }
+  const size_t whole = length - length % 3;
+  EncodeGroups(src, whole, dst, tables);
+  pending_size_ = length - whole;
+  memcpy(pending_, src + whole, pending_size_);
+}
+
+void Base64::Encoder::Finish(std::string* out) {
+  unsigned char tail[4];
+  const size_t size = EncodeTail(pending_, pending_size_, tail,
+                                 GetTables(options_.alphabet),
+                                 options_.padding);
+  out->append(reinterpret_cast<const char*>(tail), size);
+  pending_size_ = 0;
+}
+
+Base64::Decoder::Decoder() {
+  Reset();
+}
+
+Base64::Decoder::Decoder(const Options& options) : options_(options) {
+  Reset();
+}
+
+Base64::Error Base64::Decoder::Update(const void* src,
+                                      size_t length,
+                                      std::string* out) {
+  const size_t start = out->size();
+  out->resize(start + (quad_size_ + length) / 4 * 3 + 2);
+  size_t written = 0;
+  const Error error =
+      Feed(static_cast<const unsigned char*>(src), length,
+           reinterpret_cast<unsigned char*>(&(*out)[0]) + start, &written);
+  out->resize(start + written);
+  return error;
+}
+
+Base64::Error Base64::Decoder::Finish(std::string* out) {
+  unsigned char tail[2];
+  size_t written = 0;
+  const Error error = Flush(tail, &written);
+  out->append(reinterpret_cast<const char*>(tail), written);
+  return error;
+}
+
+void Base64::Decoder::Reset() {
+  memset(quad_, 0, sizeof(quad_));
+  quad_size_ = 0;
+  padding_ = 0;
+  done_ = false;
+}
+
+void Base64::Decoder::Emit(size_t count, unsigned char* dst, size_t* written) {
+  const uint32_t v = static_cast<uint32_t>(quad_[0]) << 18 |
+                     static_cast<uint32_t>(quad_[1]) << 12 |
+                     static_cast<uint32_t>(quad_[2]) << 6 | quad_[3];
+  if (dst) {
+    const unsigned char bytes[3] = {static_cast<unsigned char>(v >> 16),
+                                    static_cast<unsigned char>(v >> 8),
+                                    static_cast<unsigned char>(v)};
+    memcpy(dst + *written, bytes, count);
+  }
+  *written += count;
+  memset(quad_, 0, sizeof(quad_));
+  quad_size_ = 0;
+}
+
+Base64::Error Base64::Decoder::Feed(const unsigned char* src,
+                                    size_t length,
+                                    unsigned char* dst,
+                                    size_t* written) {
+  const AlphabetTables& tables = GetTables(options_.alphabet);
+  const bool strict = options_.strict;
+  *written = 0;
+  size_t i = 0;
+  while (i < length) {
+    if (quad_size_ == 0 && !done_ && padding_ == 0) {
+      i += DecodeGroups(src + i, length - i, dst, written, tables);
+      if (i == length) {
+        break;
       }
-      if (srcByte < '+' || srcByte > 'z') {
-        return Error::kBadChar;
+    }
+    const unsigned char c = src[i++];
+    if (done_) {
+      // Lenient decoding ignores everything after the end of the payload.
+      if (strict) {
+        return Error::kBadPadding;
       }
-      signed char decoded = kDecodeData[srcByte - '+'];
-      bytes[byte] = decoded;
-      if (decoded != DecodePad) {
-        if (decoded < 0) {
-          return Error::kBadChar;
-        }
-        byte++;
-        if (*src) {
-          continue;
-        }
-        if (byte == 0) {
-          *dstLength = i;
-          return Error::kNone;
-        }
-        if (byte == 4) {
-          break;
-        }
+      break;
+    }
+    const uint8_t value = tables.decode[c];
+    if (value != kInvalid && padding_ == 0) {
+      quad_[quad_size_++] = value;
+      if (quad_size_ == 4) {
+        Emit(3, dst, written);
       }
-      // As an optimization, if we find an equals sign
-      // we assume all future bytes to read are the
-      // appropriate number of padding equals signs.
-      if (byte < 2) {
+      continue;
+    }
+    if (c == '=') {
+      if (quad_size_ < 2 || (strict && !options_.padding)) {
         return Error::kBadPadding;
       }
-      padThree = true;
-      if (byte == 2) {
-        padTwo = true;
+      padding_++;
+      if (strict && quad_size_ + padding_ < 4) {
+        continue;
       }
-      break;
-    } while (byte < 4);
-    int two = 0;
-    int three = 0;
-    if (dst) {
-      int one = (uint8_t)(bytes[0] << 2);
-      two = bytes[1];
-      one |= two >> 4;
-      two = (uint8_t)((two << 4) & 0xFF);
-      three = bytes[2];
-      two |= three >> 2;
-      three = (uint8_t)((three << 6) & 0xFF);
-      three |= bytes[3];
-      BASE_DCHECK(one < 256 && two < 256 && three < 256);
-      dst[i] = (unsigned char)one;
-    }
-    i++;
-    if (padTwo) {
-      break;
+      if (strict && (quad_[quad_size_ - 1] & (quad_size_ == 2 ? 0x0F : 0x03))) {
+        return Error::kBadPadding;
+      }
+      Emit(quad_size_ - 1, dst, written);
+      done_ = true;
+      continue;
     }
-    if (dst) {
-      dst[i] = (unsigned char)two;
+    if (strict) {
+      return padding_ ? Error::kBadPadding : Error::kBadChar;
     }
-    i++;
-    if (padThree) {
-      break;
+    if (c == 0) {
+      // The payload ends at a NUL, as if it was padded.
+      if (quad_size_ == 1) {
+        return Error::kBadPadding;
+      }
+      if (quad_size_ > 1) {
+        Emit(quad_size_ - 1, dst, written);
+      }
+      done_ = true;
+      continue;
     }
-    if (dst) {
-      dst[i] = (unsigned char)three;
+    if (c <= ' ') {
+      continue;  // treat as white space
     }
-    i++;
+    return Error::kBadChar;
   }
-  *dstLength = i;
   return Error::kNone;
 }
 
-size_t Base64::Encode(const void* srcv, size_t length, void* dstv) {
-  BASE_DCHECK(dstv);
-  const unsigned char* src = static_cast<const unsigned char*>(srcv);
-  unsigned char* dst = static_cast<unsigned char*>(dstv);
-
-  const char* encode = kDefaultEncode;
-  size_t remainder = length % 3;
-  char unsigned const* const end = &src[length - remainder];
-  while (src < end) {
-    unsigned a = *src++;
-    unsigned b = *src++;
-    unsigned c = *src++;
-    int d = c & 0x3F;
-    c = (c >> 6 | b << 2) & 0x3F;
-    b = (b >> 4 | a << 4) & 0x3F;
-    a = a >> 2;
-    // NOLINTBEGIN(clang-analyzer-core.NullDereference)
-    *dst++ = encode[a];
-    *dst++ = encode[b];
-    *dst++ = encode[c];
-    *dst++ = encode[d];
-    // NOLINTEND(clang-analyzer-core.NullDereference)
-  }
-  if (remainder > 0) {
-    int k1 = 0;
-    int k2 = EncodePad;
-    int a = (uint8_t)*src++;
-    if (remainder == 2) {
-      int b = *src++;
-      k1 = b >> 4;
-      k2 = (b << 2) & 0x3F;
+Base64::Error Base64::Decoder::Flush(unsigned char* dst, size_t* written) {
+  *written = 0;
+  Error error = Error::kNone;
+  if (!done_ && (padding_ > 0 || quad_size_ == 1 ||
+                 (options_.strict && quad_size_ > 0 && options_.padding))) {
+    error = Error::kBadPadding;
+  } else if (!done_ && quad_size_ > 0) {
+    if (options_.strict &&
+        (quad_[quad_size_ - 1] & (quad_size_ == 2 ? 0x0F : 0x03))) {
+      error = Error::kBadPadding;
+    } else {
+      Emit(quad_size_ - 1, dst, written);
     }
-    // NOLINTBEGIN(clang-analyzer-core.NullDereference)
-    *dst++ = encode[a >> 2];
-    *dst++ = encode[(k1 | a << 4) & 0x3F];
-    *dst++ = encode[k2];
-    *dst++ = encode[EncodePad];
-    // NOLINTEND(clang-analyzer-core.NullDereference)
   }
-  return EncodedSize(length);
+  Reset();
+  return error;
 }
 
-}  // namespace flutter
+}  // namespace base
@@ -2,6 +2,7 @@
 #define BASE_COMMON_BASE64_H_
 
 #include <cstddef>
+#include <string>
 
 namespace base {
 
@@ -13,6 +14,23 @@ struct Base64 {
     kBadChar,
   };
 
+  enum class Alphabet {
+    // RFC 4648 section 4, ending in '+' and '/'.
+    kStandard,
+    // RFC 4648 section 5, ending in '-' and '_', safe in URLs and file names.
+    kUrlSafe,
+  };
+
+  struct Options {
+    Alphabet alphabet = Alphabet::kStandard;
+    // Whether encoding appends '=' padding. In strict mode this also decides
+    // whether decoding requires padding or rejects it.
+    bool padding = true;
+    // Whether decoding rejects whitespace, NUL, bad or missing padding and
+    // non-zero pad bits instead of skipping or tolerating them.
+    bool strict = false;
+  };
+
   /**
      Base64 encodes src into dst.
 
@@ -22,6 +40,19 @@ struct Base64 {
   */
   static size_t Encode(const void* src, size_t length, void* dst);
 
+  /**
+     Base64 encodes src into dst with the given alphabet and padding.
+
+     @param dst a pointer to a buffer of at least
+     EncodedSize(length, options) bytes.
+
+     @return the number of bytes written to dst.
+  */
+  static size_t Encode(const void* src,
+                       size_t length,
+                       void* dst,
+                       const Options& options);
+
   /**
      Returns the length of the buffer that needs to be allocated to encode
      srcDataLength bytes.
@@ -32,9 +63,24 @@ struct Base64 {
     return ((srcDataLength + 2) / 3) * 4;
   }
 
+  /**
+     Returns the length of the encoding of srcDataLength bytes with or without
+     padding, as selected by options.
+  */
+  static size_t EncodedSize(size_t srcDataLength, const Options& options) {
+    if (options.padding) {
+      return EncodedSize(srcDataLength);
+    }
+    size_t remainder = srcDataLength % 3;
+    return (srcDataLength / 3) * 4 + (remainder ? remainder + 1 : 0);
+  }
+
   /**
      Base64 decodes src into dst.
 
+     Whitespace is skipped, and decoding stops at the first NUL or padding
+     character. Input with the padding left out is accepted.
+
      This can be called once with 'dst' nullptr to get the required size,
      then again with an allocated 'dst' pointer to do the actual decoding.
 
@@ -48,6 +94,89 @@ struct Base64 {
                                     size_t srcLength,
                                     void* dst,
                                     size_t* dstLength);
+
+  /**
+     Base64 decodes src into dst with the given alphabet, leniently or strictly
+     as selected by options. Otherwise like Decode() above.
+  */
+  [[nodiscard]] static Error Decode(const void* src,
+                                    size_t srcLength,
+                                    void* dst,
+                                    size_t* dstLength,
+                                    const Options& options);
+
+  /**
+     Encodes input that arrives in chunks, so that large payloads can be
+     converted without holding all of them in memory. Chunks may have any
+     length; bytes that do not complete a 3 byte group are held back until
+     the next Update() or Finish().
+  */
+  class Encoder {
+   public:
+    Encoder();
+    explicit Encoder(const Options& options);
+
+    /** Encodes length bytes of src and appends the result to out. */
+    void Update(const void* src, size_t length, std::string* out);
+
+    /**
+       Encodes the held back bytes, appends them to out and resets the
+       encoder for the next payload.
+    */
+    void Finish(std::string* out);
+
+   private:
+    Options options_;
+    unsigned char pending_[2];
+    size_t pending_size_ = 0;
+  };
+
+  /**
+     Decodes input that arrives in chunks. Chunks may split groups, padding and
+     whitespace anywhere. The concatenated input is decoded as Decode() would
+     decode it in one piece.
+  */
+  class Decoder {
+   public:
+    Decoder();
+    explicit Decoder(const Options& options);
+
+    /** Decodes length bytes of src and appends the result to out. */
+    [[nodiscard]] Error Update(const void* src,
+                               size_t length,
+                               std::string* out);
+
+    /**
+       Decodes a trailing partial group, appends it to out and resets the
+       decoder for the next payload. Fails in strict mode if the input ended
+       early.
+    */
+    [[nodiscard]] Error Finish(std::string* out);
+
+   private:
+    friend struct Base64;
+
+    // Decodes src, writing to dst if it is not nullptr, and sets written to
+    // the number of bytes produced.
+    Error Feed(const unsigned char* src,
+               size_t length,
+               unsigned char* dst,
+               size_t* written);
+    // Decodes the partial group left at the end of the input and resets.
+    Error Flush(unsigned char* dst, size_t* written);
+    // Writes the bytes of the partial or complete group in quad_.
+    void Emit(size_t count, unsigned char* dst, size_t* written);
+    void Reset();
+
+    Options options_;
+    // Decoded 6-bit values of the current group.
+    unsigned char quad_[4];
+    size_t quad_size_;
+    // Number of padding characters seen in the current group.
+    size_t padding_;
+    // Set once the payload has ended at a NUL or at padding.
+    bool done_;
+  };
 };
 
 }  // namespace base
@@ -0,0 +1,338 @@
+#include "binary_log_format.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace base {
+namespace binary_log {
+
+namespace {
+
+class Reader {
+ public:
+  explicit Reader(std::string_view data) : data_(data) {}
+
+  bool empty() const { return data_.empty(); }
+
+  template <typename T>
+  bool Read(T* value) {
+    if (data_.size() < sizeof(T)) {
+      return false;
+    }
+    memcpy(value, data_.data(), sizeof(T));
+    data_.remove_prefix(sizeof(T));
+    return true;
+  }
+
+  bool ReadBytes(size_t size, std::string_view* bytes) {
+    if (data_.size() < size) {
+      return false;
+    }
+    *bytes = data_.substr(0, size);
+    data_.remove_prefix(size);
+    return true;
+  }
+
+ private:
+  std::string_view data_;
+};
+
+// Appends snprintf(|spec|, value) to |out|.
+template <typename T>
+void AppendFormatted(const char* spec, T value, string::StringBuilder* out) {
+  char buffer[128];
+  const int size = snprintf(buffer, sizeof(buffer), spec, value);
+  if (size < 0) {
+    return;
+  }
+  if (static_cast<size_t>(size) < sizeof(buffer)) {
+    out->AppendPieces({absl::string_view(buffer, size)});
+    return;
+  }
+  std::string large(size, '\0');
+  snprintf(&large[0], large.size() + 1, spec, value);
+  out->AppendPieces({absl::string_view(large)});
+}
+
+bool IsOneOf(char c, const char* set) {
+  return c != '\0' && strchr(set, c) != nullptr;
+}
+
+// Widths and precisions are read from the file, so they are capped: a
+// damaged one could otherwise have a single field allocate gigabytes.
+constexpr uint32_t kMaxFieldWidth = 1024;
+
+// Copies the flags, width and precision |spec| to |out|, with the width and
+// precision capped at kMaxFieldWidth. Never writes more than |spec|.
+char* CopySpec(std::string_view spec, char* out) {
+  size_t i = 0;
+  while (i < spec.size()) {
+    // A leading '0' is a flag, and zeros after the '.' do not count.
+    if (spec[i] < '1' || spec[i] > '9') {
+      *out++ = spec[i++];
+      continue;
+    }
+    const size_t begin = i;
+    uint32_t value = 0;
+    while (i < spec.size() && spec[i] >= '0' && spec[i] <= '9') {
+      if (value <= kMaxFieldWidth) {
+        value = value * 10 + (spec[i] - '0');
+      }
+      i++;
+    }
+    if (value > kMaxFieldWidth) {
+      // At least as long as the digits it replaces.
+      out += snprintf(out, i - begin + 1, "%u", kMaxFieldWidth);
+    } else {
+      memcpy(out, spec.data() + begin, i - begin);
+      out += i - begin;
+    }
+  }
+  return out;
+}
+
+// Formats one argument of type |type| from |reader| with the conversion
+// |spec|, which holds the flags, width and precision after its '%'.
+bool AppendArgument(std::string_view spec,
+                    char conversion,
+                    ArgType type,
+                    Reader* reader,
+                    string::StringBuilder* out) {
+  // '%', the spec, a length modifier, the conversion and a NUL.
+  char format[64];
+  if (spec.size() + 5 > sizeof(format)) {
+    spec = std::string_view();
+  }
+  format[0] = '%';
+  char* end = CopySpec(spec, format + 1);
+  auto finish = [&](const char* length, char c) {
+    const size_t length_size = strlen(length);
+    memcpy(end, length, length_size);
+    end[length_size] = c;
+    end[length_size + 1] = '\0';
+  };
+
+  switch (type) {
+    case ArgType::kSigned:
+    case ArgType::kUnsigned: {
+      uint64_t value;
+      if (!reader->Read(&value)) {
+        return false;
+      }
+      if (conversion == 'c') {
+        finish("", 'c');
+        AppendFormatted(format, static_cast<int>(value), out);
+      } else if (IsOneOf(conversion, "ouxX")) {
+        finish("ll", conversion);
+        AppendFormatted(format, static_cast<unsigned long long>(value), out);
+      } else if (type == ArgType::kSigned) {
+        finish("ll", 'd');
+        AppendFormatted(format, static_cast<long long>(value), out);
+      } else {
+        finish("ll", 'u');
+        AppendFormatted(format, static_cast<unsigned long long>(value), out);
+      }
+      return true;
+    }
+    case ArgType::kDouble: {
+      double value;
+      if (!reader->Read(&value)) {
+        return false;
+      }
+      finish("", IsOneOf(conversion, "eEfFgGaA") ? conversion : 'g');
+      AppendFormatted(format, value, out);
+      return true;
+    }
+    case ArgType::kString: {
+      uint32_t size;
+      std::string_view value;
+      if (!reader->Read(&size) || !reader->ReadBytes(size, &value)) {
+        return false;
+      }
+      if (spec.empty()) {
+        out->AppendPieces({absl::string_view(value.data(), value.size())});
+      } else {
+        finish("", 's');
+        AppendFormatted(format, std::string(value).c_str(), out);
+      }
+      return true;
+    }
+    case ArgType::kPointer: {
+      uint64_t value;
+      if (!reader->Read(&value)) {
+        return false;
+      }
+      finish("", 'p');
+      AppendFormatted(format, reinterpret_cast<void*>(value), out);
+      return true;
+    }
+  }
+  return false;
+}
+
+const char* GetSeverityName(int32_t severity) {
+  static const char* const kNames[] = {"INFO", "WARNING", "ERROR", "FATAL"};
+  if (severity >= 0 && severity < 4) {
+    return kNames[severity];
+  }
+  return severity < 0 ? "VERBOSE" : "UNKNOWN";
+}
+
+struct Site {
+  int32_t severity;
+  int32_t line;
+  std::string file;
+  std::string format;
+  std::vector<ArgType> types;
+};
+
+bool ReadString(Reader* reader, std::string* value) {
+  uint16_t size;
+  std::string_view bytes;
+  if (!reader->Read(&size) || !reader->ReadBytes(size, &bytes)) {
+    return false;
+  }
+  value->assign(bytes.data(), bytes.size());
+  return true;
+}
+
+bool ReadSite(Reader* reader, std::unordered_map<uint32_t, Site>* sites) {
+  uint32_t id;
+  Site site;
+  uint8_t count;
+  if (!reader->Read(&id) || !reader->Read(&site.severity) ||
+      !reader->Read(&site.line) || !ReadString(reader, &site.file) ||
+      !ReadString(reader, &site.format) || !reader->Read(&count)) {
+    return false;
+  }
+  std::string_view types;
+  if (!reader->ReadBytes(count, &types)) {
+    return false;
+  }
+  for (char type : types) {
+    site.types.push_back(static_cast<ArgType>(type));
+  }
+  (*sites)[id] = std::move(site);
+  return true;
+}
+
+bool DecodeRecord(std::string_view record,
+                  const std::unordered_map<uint32_t, Site>& sites,
+                  string::StringBuilder* out) {
+  Reader reader(record);
+  uint32_t id;
+  int64_t ticks;
+  if (!reader.Read(&id) || !reader.Read(&ticks)) {
+    return false;
+  }
+  const auto it = sites.find(id);
+  if (it == sites.end()) {
+    return false;
+  }
+  const Site& site = it->second;
+  char time[48];
+  snprintf(time, sizeof(time), "%lld.%06lld ",
+           static_cast<long long>(ticks / 1000000000),
+           static_cast<long long>(ticks % 1000000000 / 1000));
+  const char* file = strrchr(site.file.c_str(), '/');
+  file = file != nullptr ? file + 1 : site.file.c_str();
+  out->Append(time, "[", GetSeverityName(site.severity));
+  if (site.severity < 0) {
+    out->Append(-site.severity);
+  }
+  out->Append(":", file, "(", site.line, ")] ");
+  const bool ok = FormatArguments(site.format, site.types.data(),
+                                  site.types.size(),
+                                  record.substr(kRecordHeaderSize), out);
+  out->push_back('\n');
+  return ok;
+}
+
+}  // namespace
+
+bool FormatArguments(std::string_view format,
+                     const ArgType* types,
+                     size_t count,
+                     std::string_view args,
+                     string::StringBuilder* out) {
+  Reader reader(args);
+  size_t next = 0;
+  size_t i = 0;
+  while (i < format.size()) {
+    const size_t percent = format.find('%', i);
+    const std::string_view literal = format.substr(i, percent - i);
+    out->AppendPieces({absl::string_view(literal.data(), literal.size())});
+    if (percent == std::string_view::npos) {
+      break;
+    }
+    size_t j = percent + 1;
+    if (j < format.size() && format[j] == '%') {
+      out->push_back('%');
+      i = j + 1;
+      continue;
+    }
+    const size_t spec_begin = j;
+    while (j < format.size() && IsOneOf(format[j], "-+ #0123456789.")) {
+      j++;
+    }
+    const size_t spec_end = j;
+    while (j < format.size() && IsOneOf(format[j], "hlLqjzt")) {
+      j++;
+    }
+    if (j == format.size() || next == count) {
+      // No conversion, or no argument left for it: kept as written.
+      const size_t end = j < format.size() ? j + 1 : j;
+      const std::string_view raw = format.substr(percent, end - percent);
+      out->AppendPieces({absl::string_view(raw.data(), raw.size())});
+      i = end;
+      continue;
+    }
+    if (!AppendArgument(format.substr(spec_begin, spec_end - spec_begin),
+                        format[j], types[next], &reader, out)) {
+      return false;
+    }
+    next++;
+    i = j + 1;
+  }
+  return true;
+}
+
+bool DecodeBinaryLog(std::string_view data, string::StringBuilder* out) {
+  Reader reader(data);
+  std::string_view magic;
+  uint32_t version;
+  if (!reader.ReadBytes(sizeof(kFileMagic), &magic) ||
+      magic != std::string_view(kFileMagic, sizeof(kFileMagic)) ||
+      !reader.Read(&version) || version != kFileVersion) {
+    return false;
+  }
+  std::unordered_map<uint32_t, Site> sites;
+  while (!reader.empty()) {
+    char tag;
+    if (!reader.Read(&tag)) {
+      return false;
+    }
+    if (tag == kSiteEntry) {
+      if (!ReadSite(&reader, &sites)) {
+        return false;
+      }
+    } else if (tag == kRecordEntry) {
+      uint32_t size;
+      std::string_view record;
+      if (!reader.Read(&size) || !reader.ReadBytes(size, &record) ||
+          !DecodeRecord(record, sites, out)) {
+        return false;
+      }
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace binary_log
+}  // namespace base
@@ -0,0 +1,72 @@
+#ifndef BINARY_LOG_FORMAT_H_
+#define BINARY_LOG_FORMAT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string_view>
+
+#include "string/string_builder.h"
+
+// Encoding of structured log records (see structured_log.h) and of the binary
+// log files they are written to. This file only depends on string/, so that
+// host tools decoding pulled log files, like decode_binary_log.cc, can build
+// it on its own.
+//
+// A record is the id of its log site, a timestamp and the raw arguments:
+//
+//   u32 site id | i64 TimePoint ticks | argument...
+//
+// Integers, doubles and pointers take 8 bytes; strings take a u32 length and
+// their bytes. All values are little-endian, as on every Android ABI.
+//
+// A log file starts with kFileMagic and kFileVersion (u32), followed by
+// entries. Each file describes every log site it uses before the first
+// record of that site, so files can be decoded on their own:
+//
+//   'S' u32 id | i32 severity | i32 line | u16 size, file | u16 size, format
+//       | u8 argument count | ArgType...
+//   'R' u32 size | record
+
+namespace base {
+namespace binary_log {
+
+enum class ArgType : uint8_t {
+  kSigned = 1,
+  kUnsigned = 2,
+  kDouble = 3,
+  kString = 4,
+  kPointer = 5,
+};
+
+constexpr char kFileMagic[4] = {'B', 'L', 'O', 'G'};
+constexpr uint32_t kFileVersion = 1;
+
+constexpr char kSiteEntry = 'S';
+constexpr char kRecordEntry = 'R';
+
+constexpr size_t kRecordHeaderSize = sizeof(uint32_t) + sizeof(int64_t);
+
+// Appends |format| to |out| with its printf conversions replaced by the
+// arguments encoded in |args|, whose types are |types|. A conversion that
+// does not suit its argument's type is replaced by a default one for the
+// type. Widths and precisions are capped at 1024. Returns false if |args| is
+// shorter than |types| say.
+bool FormatArguments(std::string_view format,
+                     const ArgType* types,
+                     size_t count,
+                     std::string_view args,
+                     string::StringBuilder* out);
+
+// Decodes the log file |data| to text, one line per record:
+//
+//   <seconds>.<microseconds> [<SEVERITY>:<file>(<line>)] <message>
+//
+// Returns false if |data| is not a log file or is truncated; the records
+// before the damage are decoded regardless.
+bool DecodeBinaryLog(std::string_view data, string::StringBuilder* out);
+
+}  // namespace binary_log
+}  // namespace base
+
+#endif  // BINARY_LOG_FORMAT_H_
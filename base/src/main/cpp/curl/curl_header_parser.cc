@@ -7,6 +7,7 @@
 #include <utility>
 
 #include "http_client_util.h"
+#include "http_header_map.h"
 
 CurlHeaderParser::CurlHeaderParser()
     : status_code_(-1),
@@ -40,7 +41,7 @@ bool CurlHeaderParser::ParseAsStatus(const std::string& header_string) {
   status_code_ = status_code;
   // It is required that we store only the final header list. So we keep the
   // last set of headers
-  header_list_.clear();
+  headers_.Clear();
   return true;
 }
 
@@ -57,12 +58,17 @@ bool CurlHeaderParser::ParseAsHeader(const std::string& header_string) {
   // Removes the "Content-Encoding", "Content-Length", and "Content-Length"
   // headers from the response when the curl encoding in use because they
   // reflect in-flight encoded values
-  if (!use_curl_encoding_ ||
-      (!absl::EqualsIgnoreCase(key, kContentEncodingHdr) &&
-       !absl::EqualsIgnoreCase(key, kContentLengthHdr) &&
-       !absl::EqualsIgnoreCase(key, kTransferEncodingHdr))) {
-    header_list_.push_back({key, value});
+  if (use_curl_encoding_) {
+    switch (ClassifyHeader(key)) {
+      case WellKnownHeader::kContentEncoding:
+      case WellKnownHeader::kContentLength:
+      case WellKnownHeader::kTransferEncoding:
+        return true;
+      default:
+        break;
+    }
   }
+  headers_.Add(std::move(key), std::move(value));
   return true;
 }
 
@@ -86,4 +92,6 @@ bool CurlHeaderParser::IsLastHeader() const { return is_last_header_line_; }
 
 int CurlHeaderParser::GetStatusCode() const { return status_code_; }
 
-HeaderList CurlHeaderParser::GetHeaderList() const { return header_list_; }
\ No newline at end of file
+HeaderList CurlHeaderParser::GetHeaderList() const { return headers_.list(); }
+
+HeaderMap CurlHeaderParser::ReleaseHeaders() { return std::move(headers_); }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include <string>
 
 #include "http_client.h"
+#include "http_header_map.h"
 
 // A custom parser that is needed to call the first callback after all the
 // headers received
@@ -23,6 +24,8 @@ class CurlHeaderParser {
   ABSL_MUST_USE_RESULT bool IsLastHeader() const;
   ABSL_MUST_USE_RESULT int GetStatusCode() const;
   ABSL_MUST_USE_RESULT HeaderList GetHeaderList() const;
+  // Moves the parsed headers out, leaving the parser with none
+  ABSL_MUST_USE_RESULT HeaderMap ReleaseHeaders();
 
  private:
   // Extracts status codes from HTTP/1.1 and HTTP/2 responses
@@ -33,7 +36,7 @@ class CurlHeaderParser {
   bool ParseAsLastLine(const std::string& header_string);
 
   int status_code_;
-  HeaderList header_list_;
+  HeaderMap headers_;
   bool is_last_header_line_;
   bool use_curl_encoding_;
 };
\ No newline at end of file
@@ -6,6 +6,8 @@
 #include <vector>
 #include <absl/log/absl_log.h>
 #include <absl/synchronization/mutex.h>
+#include "../logging.h"
+#include "../trace_event.h"
 #include "curl_http_request_handle.h"
 #include "http_client.h"
 #include "http_client_util.h"
@@ -34,6 +36,7 @@ absl::Status PerformMultiHandlesBlocked(CurlMultiHandle* multi_handle) {
   int num_running_handles = -1;
   while (num_running_handles) {
     CURLMcode code = multi_handle->Perform(&num_running_handles);
+    BASE_TRACE_COUNTER("http", "RunningHandles", num_running_handles);
     if (code != CURLM_OK) {
       ABSL_LOG(ERROR) << "MultiPerform failed with code: " << code;
       return absl::InternalError(
@@ -43,6 +46,7 @@ absl::Status PerformMultiHandlesBlocked(CurlMultiHandle* multi_handle) {
     ReadCompleteMessages(multi_handle);
 
     if (num_running_handles > 0) {
+      BASE_TRACE_EVENT("http", "CurlMultiHandle::Poll");
       code = multi_handle->Poll(/*extra_fds*/ nullptr,
                                 /*extra_nfds*/ 0, /*timeout_ms*/ 1000,
                                 /*numfds*/ nullptr);
@@ -60,12 +64,19 @@ CurlHttpClient::CurlHttpClient(CurlApi* curl_api, std::string test_cert_path)
 
 std::unique_ptr<HttpRequestHandle> CurlHttpClient::EnqueueRequest(
     std::unique_ptr<HttpRequest> request) {
-  ABSL_LOG(INFO) << "Creating a " << ConvertMethodToString(request->method())
-                << " request to " << request->uri() << " with body "
-                << request->HasBody() << " with headers "
-                << request->extra_headers().size();
-  for (const auto& [key, value] : request->extra_headers()) {
-    ABSL_LOG(INFO) << key << ": " << value;
+  // Throttled, since this runs per request. Logs through absl like the rest
+  // of this file; only the verbosity check below uses base. The headers,
+  // which can carry credentials, need LogSettings::vmodule
+  // "curl_http_client=1".
+  ABSL_LOG_EVERY_N_SEC(INFO, 1)
+      << "Creating a " << ConvertMethodToString(request->method())
+      << " request to " << request->uri() << " with body "
+      << request->HasBody() << " with headers "
+      << request->extra_headers().size();
+  if (BASE_VLOG_IS_ON(1)) {
+    for (const auto& [key, value] : request->extra_headers()) {
+      ABSL_LOG(INFO) << key << ": " << value;
+    }
   }
 
   return std::make_unique<CurlHttpRequestHandle>(
@@ -74,6 +85,7 @@ std::unique_ptr<HttpRequestHandle> CurlHttpClient::EnqueueRequest(
 
 absl::Status CurlHttpClient::PerformRequests(
     std::vector<std::pair<HttpRequestHandle*, HttpRequestCallback*>> requests) {
+  BASE_TRACE_EVENT("http", "CurlHttpClient::PerformRequests");
   ABSL_LOG(INFO) << "PerformRequests";
   std::unique_ptr<CurlMultiHandle> multi_handle =
       curl_api_->CreateMultiHandle();
@@ -1,17 +1,20 @@
 #include "curl_http_request_handle.h"
 
+#include <algorithm>
 #include <memory>
 #include <optional>
 #include <string>
 #include <utility>
+#include <vector>
 
-#include <absl/strings/match.h>
 #include <curl/curl.h>
 #include <absl/log/absl_log.h>
+#include "../trace_event.h"
 #include "curl_api.h"
 #include "curl_header_parser.h"
 #include "curl_http_response.h"
 #include "http_client_util.h"
+#include "http_header_map.h"
 
 namespace {
 // A type check for the macro.
@@ -57,9 +60,10 @@ size_t CurlHttpRequestHandle::HeaderCallback(char* buffer, size_t size,
     return size * n_items;
   }
 
+  BASE_TRACE_EVENT("http", "HttpRequestCallback::OnResponseStarted");
   self->response_ =
       std::make_unique<CurlHttpResponse>(self->header_parser_.GetStatusCode(),
-                                         self->header_parser_.GetHeaderList());
+                                         self->header_parser_.ReleaseHeaders());
 
   // FCP_CHECK(self->callback_ != nullptr);
   absl::Status status =
@@ -75,6 +79,7 @@ size_t CurlHttpRequestHandle::HeaderCallback(char* buffer, size_t size,
 
 size_t CurlHttpRequestHandle::DownloadCallback(void* body, size_t size,
                                                size_t nmemb, void* user_data) {
+  BASE_TRACE_EVENT("http", "HttpRequestCallback::OnResponseBody");
   auto self = static_cast<CurlHttpRequestHandle*>(user_data);
   absl::string_view str_body(static_cast<char*>(body), size * nmemb);
 
@@ -130,6 +135,10 @@ CurlHttpRequestHandle::CurlHttpRequestHandle(
       header_list_(nullptr) {
   // FCP_CHECK(request_ != nullptr);
   // FCP_CHECK(easy_handle_ != nullptr);
+  if (base::IsTracingEnabled()) {
+    trace_id_ = base::NewTraceId();
+    BASE_TRACE_ASYNC_BEGIN("http", "HttpRequest", trace_id_);
+  }
 
   CURLcode code = InitializeConnection(test_cert_path);
   if (code != CURLE_OK) {
@@ -141,6 +150,7 @@ CurlHttpRequestHandle::CurlHttpRequestHandle(
 }
 
 CurlHttpRequestHandle::~CurlHttpRequestHandle() {
+  EndTrace();
   curl_slist_free_all(header_list_);
 }
 
@@ -157,9 +167,11 @@ void CurlHttpRequestHandle::Cancel() {
     callback_->OnResponseError(*request_, absl::CancelledError());
   }
   is_cancelled_ = true;
+  EndTrace();
 }
 
 void CurlHttpRequestHandle::MarkAsCompleted() {
+  BASE_TRACE_EVENT("http", "CurlHttpRequestHandle::MarkAsCompleted");
   absl::MutexLock lock(&mutex_);
 
   // FCP_CHECK(callback_ != nullptr);
@@ -172,10 +184,19 @@ void CurlHttpRequestHandle::MarkAsCompleted() {
     }
   }
   is_completed_ = true;
+  EndTrace();
+}
+
+void CurlHttpRequestHandle::EndTrace() {
+  if (trace_id_ != 0) {
+    BASE_TRACE_ASYNC_END("http", "HttpRequest", trace_id_);
+    trace_id_ = 0;
+  }
 }
 
 absl::Status CurlHttpRequestHandle::AddToMulti(CurlMultiHandle* multi_handle,
                                                HttpRequestCallback* callback) {
+  BASE_TRACE_EVENT("http", "CurlHttpRequestHandle::AddToMulti");
   absl::MutexLock lock(&mutex_);
 
   // FCP_CHECK(callback != nullptr);
@@ -322,11 +343,18 @@ CURLcode CurlHttpRequestHandle::InitializeConnection(
 
 CURLcode CurlHttpRequestHandle::InitializeHeaders(
     const HeaderList& extra_headers, HttpRequest::Method method) {
+  // Each name is classified once; the rest of this function switches on the
+  // result rather than comparing names.
+  std::vector<WellKnownHeader> kinds;
+  kinds.reserve(extra_headers.size());
+  for (const auto& [key, value] : extra_headers) {
+    kinds.push_back(ClassifyHeader(key));
+  }
+
   // If no "Accept-Encoding" request header is explicitly specified
   // advertise an "Accept-Encoding: gzip" else leave decoded.
-  std::optional<std::string> accept_encoding =
-      FindHeader(request_->extra_headers(), kAcceptEncodingHdr);
-  if (!accept_encoding.has_value()) {
+  if (std::find(kinds.begin(), kinds.end(), WellKnownHeader::kAcceptEncoding) ==
+      kinds.end()) {
     // Libcurl is responsible for the encoding.
     CURL_RETURN_IF_ERROR(
         easy_handle_->SetOpt(CURLOPT_ACCEPT_ENCODING, kGzipEncodingHdrValue));
@@ -337,28 +365,32 @@ CURLcode CurlHttpRequestHandle::InitializeHeaders(
         easy_handle_->SetOpt(CURLOPT_ACCEPT_ENCODING, nullptr));
   }
 
-  for (auto& [key, value] : extra_headers) {
-    if (absl::EqualsIgnoreCase(key, kAcceptEncodingHdr)) {
-      continue;
-    } else if (absl::EqualsIgnoreCase(key, kContentLengthHdr)) {
-      if (method == HttpRequest::Method::kPost) {
-        // For post less than 2GB
-        CURL_RETURN_IF_ERROR(
-            easy_handle_->SetOpt(CURLOPT_POSTFIELDSIZE, std::stol(value)));
-
-        // Removes the header to prevent libcurl from setting it
-        // to 'Expect: 100-continue' by default, which causes an additional
-        // and unnecessary network round trip.
-        header_list_ = AddToCurlHeaderList(header_list_, kExpectHdr, "");
-      } else if (method == HttpRequest::Method::kPut) {
-        CURL_RETURN_IF_ERROR(
-            easy_handle_->SetOpt(CURLOPT_INFILESIZE, std::stol(value)));
-        header_list_ = AddToCurlHeaderList(header_list_, kExpectHdr, "");
-      }
-    } else {
-      // A user-defined "Expect" header is not supported.
-      // FCP_CHECK(!absl::EqualsIgnoreCase(key, kExpectHdr));
-      header_list_ = AddToCurlHeaderList(header_list_, key, value);
+  for (size_t i = 0; i < extra_headers.size(); i++) {
+    const auto& [key, value] = extra_headers[i];
+    switch (kinds[i]) {
+      case WellKnownHeader::kAcceptEncoding:
+        break;
+      case WellKnownHeader::kContentLength:
+        if (method == HttpRequest::Method::kPost) {
+          // For post less than 2GB
+          CURL_RETURN_IF_ERROR(
+              easy_handle_->SetOpt(CURLOPT_POSTFIELDSIZE, std::stol(value)));
+
+          // Removes the header to prevent libcurl from setting it
+          // to 'Expect: 100-continue' by default, which causes an additional
+          // and unnecessary network round trip.
+          header_list_ = AddToCurlHeaderList(header_list_, kExpectHdr, "");
+        } else if (method == HttpRequest::Method::kPut) {
+          CURL_RETURN_IF_ERROR(
+              easy_handle_->SetOpt(CURLOPT_INFILESIZE, std::stol(value)));
+          header_list_ = AddToCurlHeaderList(header_list_, kExpectHdr, "");
+        }
+        break;
+      default:
+        // A user-defined "Expect" header is not supported.
+        // FCP_CHECK(kinds[i] != WellKnownHeader::kExpect);
+        header_list_ = AddToCurlHeaderList(header_list_, key, value);
+        break;
     }
   }
 
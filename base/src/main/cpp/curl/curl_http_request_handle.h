@@ -57,6 +57,9 @@ class CurlHttpRequestHandle : public HttpRequestHandle {
   static size_t UploadCallback(char* buffer, size_t size, size_t num,
                                void* user_data) ABSL_NO_THREAD_SAFETY_ANALYSIS;
 
+  // Ends the "HttpRequest" trace span, if it is open.
+  void EndTrace() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
   // Called periodically. Used to cancel the request.
   static size_t ProgressCallback(void* user_data, curl_off_t dltotal,
                                  curl_off_t dlnow, curl_off_t ultotal,
@@ -76,4 +79,7 @@ class CurlHttpRequestHandle : public HttpRequestHandle {
   char error_buffer_[CURL_ERROR_SIZE] ABSL_GUARDED_BY(mutex_){};
   // Owned by the class.
   curl_slist* header_list_;
+  // Id of the "HttpRequest" trace span from construction to completion, or
+  // 0 if tracing was off at construction or the span has ended.
+  uint64_t trace_id_ ABSL_GUARDED_BY(mutex_) = 0;
 };
@@ -2,9 +2,11 @@
 
 #include <utility>
 
-CurlHttpResponse::CurlHttpResponse(int status_code, HeaderList header_list)
-    : status_code_(status_code), header_list_(std::move(header_list)) {}
+CurlHttpResponse::CurlHttpResponse(int status_code, HeaderMap headers)
+    : status_code_(status_code), headers_(std::move(headers)) {}
 
 int CurlHttpResponse::code() const { return status_code_; }
 
-const HeaderList& CurlHttpResponse::headers() const { return header_list_; }
+const HeaderList& CurlHttpResponse::headers() const { return headers_.list(); }
+
+const HeaderMap& CurlHttpResponse::header_map() const { return headers_; }
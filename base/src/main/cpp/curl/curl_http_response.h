@@ -2,18 +2,22 @@
 #include <utility>
 
 #include "http_client.h"
+#include "http_header_map.h"
 
 // A simple http response. This class is thread-safe.
 class CurlHttpResponse : public HttpResponse {
  public:
-  CurlHttpResponse(int status_code, HeaderList header_list);
+  CurlHttpResponse(int status_code, HeaderMap headers);
   ~CurlHttpResponse() override = default;
 
   // HttpResponse:
   ABSL_MUST_USE_RESULT int code() const override;
   ABSL_MUST_USE_RESULT const HeaderList& headers() const override;
 
+  // The same headers, indexed by name.
+  ABSL_MUST_USE_RESULT const HeaderMap& header_map() const;
+
  private:
   const int status_code_;
-  const HeaderList header_list_;
+  const HeaderMap headers_;
 };
@@ -14,6 +14,7 @@
 #include <absl/strings/string_view.h>
 #include <absl/strings/strip.h>
 #include <absl/strings/substitute.h>
+#include "../string/ascii_case.h"
 #include "http_client.h"
 #include "monitoring.h"
 
@@ -167,14 +168,14 @@ std::string ConvertMethodToString(HttpRequest::Method method) {
 
 std::optional<std::string> FindHeader(const HeaderList& headers,
                                       absl::string_view needle) {
-  // Normalize the needle (since header names are case insensitive, as per RFC
-  // 2616 section 4.2).
-  const std::string normalized_needle = absl::AsciiStrToLower(needle);
+  // Header names are case insensitive, as per RFC 2616 section 4.2. Names are
+  // compared in place, so no lowercase copy of the needle or of any header is
+  // made; the length check rejects most names before their bytes are read.
+  // Comparing non-ASCII data w/ our needle is safe as well.
   const auto& header_entry = std::find_if(
-      headers.begin(), headers.end(), [&normalized_needle](const Header& x) {
-        // AsciiStrToLower safely handles non-ASCII data, and comparing
-        // non-ASCII data w/ our needle is safe as well.
-        return absl::AsciiStrToLower(std::get<0>(x)) == normalized_needle;
+      headers.begin(), headers.end(), [needle](const Header& x) {
+        return base::string::EqualsIgnoreAsciiCase(
+            std::get<0>(x), std::string_view(needle.data(), needle.size()));
       });
 
   if (header_entry == headers.end()) {
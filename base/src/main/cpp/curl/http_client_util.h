@@ -56,11 +56,12 @@ absl::Status ConvertHttpCodeToStatus(int code);
 std::string ConvertMethodToString(HttpRequest::Method method);
 
 // Finds the header value for header with name `needle` in a list of headers
-// (incl. normalizing the header names to lowercase before doing any
-// comparisons). Note that this returns the first matching header value (rather
-// than coalescing repeated header values as per RFC2616 section 4.2), so it
-// must only be used for headers for which only a single value is expected.
-// Returns an empty optional if no header value was found.
+// (comparing the header names case-insensitively). Note that this returns the
+// first matching header value (rather than coalescing repeated header values
+// as per RFC2616 section 4.2), so it must only be used for headers for which
+// only a single value is expected. Returns an empty optional if no header value
+// was found. Callers doing several lookups in the same list should build a
+// `HeaderMap` (see http_header_map.h) instead.
 std::optional<std::string> FindHeader(const HeaderList& headers,
                                       absl::string_view needle);
 
@@ -0,0 +1,177 @@
+#include "http_header_map.h"
+
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <absl/strings/string_view.h>
+#include "../string/ascii_case.h"
+#include "http_client.h"
+#include "http_client_util.h"
+
+namespace {
+
+constexpr absl::string_view kWellKnownHeaderNames[kWellKnownHeaderCount] = {
+    "",
+    kAcceptEncodingHdr,
+    kApiKeyHdr,
+    kContentEncodingHdr,
+    kContentLengthHdr,
+    kContentTypeHdr,
+    kExpectHdr,
+    kTransferEncodingHdr,
+};
+
+// The only name each well-known header can be confused with is one of the
+// same length, so the length alone picks the candidate to compare against.
+static_assert(sizeof(kExpectHdr) - 1 == 6);
+static_assert(sizeof(kContentTypeHdr) - 1 == 12);
+static_assert(sizeof(kContentLengthHdr) - 1 == 14);
+static_assert(sizeof(kApiKeyHdr) - 1 == 14);
+static_assert(sizeof(kAcceptEncodingHdr) - 1 == 15);
+static_assert(sizeof(kContentEncodingHdr) - 1 == 16);
+static_assert(sizeof(kTransferEncodingHdr) - 1 == 17);
+
+// absl::string_view is only an alias of std::string_view in some builds.
+std::string_view ToStd(absl::string_view s) {
+  return std::string_view(s.data(), s.size());
+}
+
+bool SameName(absl::string_view a, absl::string_view b) {
+  return base::string::EqualsIgnoreAsciiCase(ToStd(a), ToStd(b));
+}
+
+size_t HashName(absl::string_view name) {
+  return base::string::HashIgnoreAsciiCase(ToStd(name));
+}
+
+WellKnownHeader Candidate(absl::string_view name) {
+  switch (name.size()) {
+    case 6:
+      return WellKnownHeader::kExpect;
+    case 12:
+      return WellKnownHeader::kContentType;
+    case 14:
+      return (name[0] | 0x20) == 'x' ? WellKnownHeader::kApiKey
+                                     : WellKnownHeader::kContentLength;
+    case 15:
+      return WellKnownHeader::kAcceptEncoding;
+    case 16:
+      return WellKnownHeader::kContentEncoding;
+    case 17:
+      return WellKnownHeader::kTransferEncoding;
+    default:
+      return WellKnownHeader::kUnknown;
+  }
+}
+
+}  // namespace
+
+WellKnownHeader ClassifyHeader(absl::string_view name) {
+  const WellKnownHeader candidate = Candidate(name);
+  if (candidate != WellKnownHeader::kUnknown &&
+      SameName(name, WellKnownHeaderName(candidate))) {
+    return candidate;
+  }
+  return WellKnownHeader::kUnknown;
+}
+
+absl::string_view WellKnownHeaderName(WellKnownHeader header) {
+  return kWellKnownHeaderNames[static_cast<size_t>(header)];
+}
+
+HeaderMap::HeaderMap() { well_known_.fill(kNone); }
+
+HeaderMap::HeaderMap(HeaderList headers) : headers_(std::move(headers)) {
+  well_known_.fill(kNone);
+  next_.resize(headers_.size(), kNone);
+  for (uint32_t i = 0; i < headers_.size(); i++) {
+    Index(i);
+  }
+}
+
+HeaderMap::HeaderMap(HeaderMap&& other)
+    : headers_(std::move(other.headers_)),
+      well_known_(other.well_known_),
+      by_hash_(std::move(other.by_hash_)),
+      next_(std::move(other.next_)) {
+  other.Clear();
+}
+
+HeaderMap& HeaderMap::operator=(HeaderMap&& other) {
+  if (this != &other) {
+    headers_ = std::move(other.headers_);
+    well_known_ = other.well_known_;
+    by_hash_ = std::move(other.by_hash_);
+    next_ = std::move(other.next_);
+    other.Clear();
+  }
+  return *this;
+}
+
+void HeaderMap::Add(std::string name, std::string value) {
+  headers_.emplace_back(std::move(name), std::move(value));
+  next_.push_back(kNone);
+  Index(static_cast<uint32_t>(headers_.size() - 1));
+}
+
+void HeaderMap::Clear() {
+  headers_.clear();
+  well_known_.fill(kNone);
+  by_hash_.clear();
+  next_.clear();
+}
+
+const std::string* HeaderMap::Find(WellKnownHeader header) const {
+  if (header == WellKnownHeader::kUnknown) {
+    return nullptr;
+  }
+  const uint32_t index = well_known_[static_cast<size_t>(header)];
+  return index == kNone ? nullptr : &headers_[index].second;
+}
+
+const std::string* HeaderMap::Find(absl::string_view name) const {
+  const WellKnownHeader header = ClassifyHeader(name);
+  if (header != WellKnownHeader::kUnknown) {
+    return Find(header);
+  }
+  const auto it = by_hash_.find(HashName(name));
+  if (it == by_hash_.end()) {
+    return nullptr;
+  }
+  for (uint32_t index = it->second; index != kNone; index = next_[index]) {
+    if (SameName(headers_[index].first, name)) {
+      return &headers_[index].second;
+    }
+  }
+  return nullptr;
+}
+
+void HeaderMap::Index(uint32_t index) {
+  const std::string& name = headers_[index].first;
+  const WellKnownHeader header = ClassifyHeader(name);
+  if (header != WellKnownHeader::kUnknown) {
+    uint32_t& first = well_known_[static_cast<size_t>(header)];
+    if (first == kNone) {
+      first = index;
+    }
+    return;
+  }
+  const auto [it, inserted] = by_hash_.try_emplace(HashName(name), index);
+  if (inserted) {
+    return;
+  }
+  // Chains each distinct name once; a repeat of a name already in the chain
+  // is never the first match.
+  uint32_t last = it->second;
+  while (true) {
+    if (SameName(headers_[last].first, name)) {
+      return;
+    }
+    if (next_[last] == kNone) {
+      break;
+    }
+    last = next_[last];
+  }
+  next_[last] = index;
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <absl/container/flat_hash_map.h>
+#include <absl/strings/string_view.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "http_client.h"
+
+// Header names the HTTP client itself acts on. Recognizing one of these costs
+// a length switch and a single case-insensitive compare, and lets the callers
+// switch on the result instead of comparing the name against each constant.
+enum class WellKnownHeader : uint8_t {
+  kUnknown = 0,
+  kAcceptEncoding,
+  kApiKey,
+  kContentEncoding,
+  kContentLength,
+  kContentType,
+  kExpect,
+  kTransferEncoding,
+};
+
+inline constexpr size_t kWellKnownHeaderCount =
+    static_cast<size_t>(WellKnownHeader::kTransferEncoding) + 1;
+
+// Returns the well-known header `name` refers to, ignoring case, or
+// `WellKnownHeader::kUnknown`.
+WellKnownHeader ClassifyHeader(absl::string_view name);
+
+// Returns the canonical spelling of `header` (e.g. "Content-Length"), or an
+// empty string for `WellKnownHeader::kUnknown`.
+absl::string_view WellKnownHeaderName(WellKnownHeader header);
+
+// A `HeaderList` indexed by case-insensitive header name. Each name is hashed
+// once, folded to lowercase, when the header is added, so lookups neither scan
+// the list nor lowercase every name they pass. Well-known headers are found by
+// their enumerator without hashing at all.
+//
+// As with `FindHeader`, lookups return the first header added under a name;
+// repeated headers stay in `list()` in the order they were added.
+class HeaderMap {
+ public:
+  HeaderMap();
+  explicit HeaderMap(HeaderList headers);
+
+  // A moved-from map is empty.
+  HeaderMap(HeaderMap&& other);
+  HeaderMap& operator=(HeaderMap&& other);
+  HeaderMap(const HeaderMap&) = default;
+  HeaderMap& operator=(const HeaderMap&) = default;
+
+  void Add(std::string name, std::string value);
+  void Clear();
+
+  // Returns the value of the first header with the given name, or nullptr.
+  const std::string* Find(WellKnownHeader header) const;
+  const std::string* Find(absl::string_view name) const;
+
+  bool Contains(WellKnownHeader header) const {
+    return Find(header) != nullptr;
+  }
+  bool Contains(absl::string_view name) const { return Find(name) != nullptr; }
+
+  const HeaderList& list() const { return headers_; }
+  size_t size() const { return headers_.size(); }
+  bool empty() const { return headers_.empty(); }
+
+ private:
+  static constexpr uint32_t kNone = UINT32_MAX;
+
+  void Index(uint32_t index);
+
+  HeaderList headers_;
+  // Index of the first header of each well-known name, or kNone.
+  std::array<uint32_t, kWellKnownHeaderCount> well_known_;
+  // Index of the first header of each other name, keyed by the lowercase
+  // hash of the name. Names whose hashes collide are chained through `next_`.
+  absl::flat_hash_map<size_t, uint32_t> by_hash_;
+  std::vector<uint32_t> next_;
+};
@@ -0,0 +1,62 @@
+// Host tool that prints a binary log file pulled off a device as text. Build
+// with -DBASE_BUILD_TOOLS=ON, then run
+//
+//   decode_binary_log <file>
+//
+// With no file, or "-", reads standard input. Exits with status 1 if the file
+// is not a log file or is truncated, after printing the records before the
+// damage.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+
+#include "binary_log_format.h"
+#include "string/string_builder.h"
+
+namespace {
+
+bool ReadFile(FILE* file, std::string* data) {
+  char buffer[64 * 1024];
+  size_t size;
+  while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    data->append(buffer, size);
+  }
+  return !ferror(file);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc > 2) {
+    fprintf(stderr, "usage: %s [file]\n", argv[0]);
+    return 2;
+  }
+  const char* path = argc == 2 ? argv[1] : "-";
+  const bool is_stdin = strcmp(path, "-") == 0;
+  FILE* file = is_stdin ? stdin : fopen(path, "rb");
+  if (file == nullptr) {
+    fprintf(stderr, "%s: cannot open %s\n", argv[0], path);
+    return 2;
+  }
+  std::string data;
+  const bool read = ReadFile(file, &data);
+  if (!is_stdin) {
+    fclose(file);
+  }
+  if (!read) {
+    fprintf(stderr, "%s: cannot read %s\n", argv[0], path);
+    return 2;
+  }
+
+  base::string::StringBuilder text;
+  const bool ok = base::binary_log::DecodeBinaryLog(data, &text);
+  fwrite(text.data(), 1, text.size(), stdout);
+  if (!ok) {
+    fprintf(stderr, "%s: %s is not a log file or is truncated\n", argv[0],
+            path);
+    return 1;
+  }
+  return 0;
+}
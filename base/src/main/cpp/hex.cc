@@ -0,0 +1,364 @@
+#include "hex.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HEX_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define HEX_NEON 1
+#endif
+
+namespace base {
+
+namespace {
+
+constexpr uint8_t kInvalid = 0xFF;
+
+constexpr char kLowerDigits[] = "0123456789abcdef";
+constexpr char kUpperDigits[] = "0123456789ABCDEF";
+
+struct EncodeTable {
+  // The two digits of each byte.
+  char pairs[256][2];
+};
+
+constexpr EncodeTable MakeEncodeTable(const char* digits) {
+  EncodeTable table{};
+  for (int i = 0; i < 256; i++) {
+    table.pairs[i][0] = digits[i >> 4];
+    table.pairs[i][1] = digits[i & 0xF];
+  }
+  return table;
+}
+
+constexpr EncodeTable kLowerTable = MakeEncodeTable(kLowerDigits);
+constexpr EncodeTable kUpperTable = MakeEncodeTable(kUpperDigits);
+
+struct DecodeTable {
+  // The value of each hex digit, kInvalid for any other character.
+  uint8_t values[256];
+};
+
+constexpr DecodeTable MakeDecodeTable() {
+  DecodeTable table{};
+  for (int i = 0; i < 256; i++) {
+    table.values[i] = kInvalid;
+  }
+  for (int i = 0; i < 16; i++) {
+    table.values[static_cast<uint8_t>(kLowerDigits[i])] =
+        static_cast<uint8_t>(i);
+    table.values[static_cast<uint8_t>(kUpperDigits[i])] =
+        static_cast<uint8_t>(i);
+  }
+  return table;
+}
+
+constexpr DecodeTable kDecodeTable = MakeDecodeTable();
+
+// Kernels encode |length| bytes and decode |pairs| digit pairs, returning how
+// many they converted. They may stop early, at the end of their last whole
+// step or before a step containing a non-digit, and leave the rest to the
+// scalar kernels.
+typedef size_t (*EncodeKernel)(const uint8_t* src,
+                               size_t length,
+                               uint8_t* dst,
+                               HexCase hex_case);
+typedef size_t (*DecodeKernel)(const uint8_t* src,
+                               size_t pairs,
+                               uint8_t* dst);
+
+size_t EncodeScalar(const uint8_t* src,
+                    size_t length,
+                    uint8_t* dst,
+                    HexCase hex_case) {
+  const EncodeTable& table =
+      hex_case == HexCase::kUpper ? kUpperTable : kLowerTable;
+  for (size_t i = 0; i < length; i++) {
+    dst[2 * i] = table.pairs[src[i]][0];
+    dst[2 * i + 1] = table.pairs[src[i]][1];
+  }
+  return length;
+}
+
+size_t DecodeScalar(const uint8_t* src, size_t pairs, uint8_t* dst) {
+  const uint8_t* values = kDecodeTable.values;
+  size_t done = 0;
+  for (; done < pairs; done++) {
+    const uint8_t hi = values[src[2 * done]];
+    const uint8_t lo = values[src[2 * done + 1]];
+    if ((hi | lo) == kInvalid) {
+      break;
+    }
+    dst[done] = static_cast<uint8_t>(hi << 4 | lo);
+  }
+  return done;
+}
+
+#if defined(HEX_X86)
+
+// Digits are computed rather than looked up so that the kernels only need
+// SSE2: a nibble n becomes '0' + n, plus the distance to 'a' or 'A' when it is
+// above 9. Decoding reverses this with unsigned range checks on c - '0' and
+// (c | 0x20) - 'a'.
+
+__attribute__((target("sse2"))) inline __m128i ToDigits(__m128i nibbles,
+                                                         __m128i letter) {
+  const __m128i above_nine =
+      _mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9));
+  return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')),
+                      _mm_and_si128(above_nine, letter));
+}
+
+// Returns the value of each digit in |chars| and sets the bytes of |valid|
+// to 0xFF where there is a digit.
+__attribute__((target("sse2"))) inline __m128i FromDigits(__m128i chars,
+                                                          __m128i* valid) {
+  const __m128i digit = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+  const __m128i letter = _mm_sub_epi8(
+      _mm_or_si128(chars, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+  const __m128i is_digit =
+      _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+  const __m128i is_letter =
+      _mm_cmpeq_epi8(_mm_min_epu8(letter, _mm_set1_epi8(5)), letter);
+  *valid = _mm_or_si128(is_digit, is_letter);
+  return _mm_or_si128(
+      _mm_and_si128(is_digit, digit),
+      _mm_and_si128(is_letter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+}
+
+// Joins the digit values of 8 pairs, high nibble in the even bytes, into the
+// low byte of each 16-bit lane.
+__attribute__((target("sse2"))) inline __m128i JoinNibbles(__m128i values) {
+  return _mm_or_si128(
+      _mm_slli_epi16(_mm_and_si128(values, _mm_set1_epi16(0x00FF)), 4),
+      _mm_srli_epi16(values, 8));
+}
+
+__attribute__((target("sse2"))) size_t EncodeSse2(const uint8_t* src,
+                                                  size_t length,
+                                                  uint8_t* dst,
+                                                  HexCase hex_case) {
+  const __m128i mask = _mm_set1_epi8(0x0F);
+  const __m128i letter = _mm_set1_epi8(
+      hex_case == HexCase::kUpper ? 'A' - '0' - 10 : 'a' - '0' - 10);
+  size_t done = 0;
+  for (; length - done >= 16; done += 16) {
+    const __m128i in =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + done));
+    const __m128i hi = _mm_and_si128(_mm_srli_epi16(in, 4), mask);
+    const __m128i lo = _mm_and_si128(in, mask);
+    __m128i* out = reinterpret_cast<__m128i*>(dst + 2 * done);
+    _mm_storeu_si128(out, ToDigits(_mm_unpacklo_epi8(hi, lo), letter));
+    _mm_storeu_si128(out + 1, ToDigits(_mm_unpackhi_epi8(hi, lo), letter));
+  }
+  return done;
+}
+
+__attribute__((target("sse2"))) size_t DecodeSse2(const uint8_t* src,
+                                                  size_t pairs,
+                                                  uint8_t* dst) {
+  size_t done = 0;
+  for (; pairs - done >= 16; done += 16) {
+    const __m128i* in = reinterpret_cast<const __m128i*>(src + 2 * done);
+    __m128i valid_a;
+    __m128i valid_b;
+    const __m128i a = FromDigits(_mm_loadu_si128(in), &valid_a);
+    const __m128i b = FromDigits(_mm_loadu_si128(in + 1), &valid_b);
+    if (_mm_movemask_epi8(_mm_and_si128(valid_a, valid_b)) != 0xFFFF) {
+      break;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + done),
+                     _mm_packus_epi16(JoinNibbles(a), JoinNibbles(b)));
+  }
+  return done;
+}
+
+__attribute__((target("avx2"))) inline __m256i ToDigits(__m256i nibbles,
+                                                        __m256i letter) {
+  const __m256i above_nine =
+      _mm256_cmpgt_epi8(nibbles, _mm256_set1_epi8(9));
+  return _mm256_add_epi8(_mm256_add_epi8(nibbles, _mm256_set1_epi8('0')),
+                         _mm256_and_si256(above_nine, letter));
+}
+
+__attribute__((target("avx2"))) inline __m256i FromDigits(__m256i chars,
+                                                          __m256i* valid) {
+  const __m256i digit = _mm256_sub_epi8(chars, _mm256_set1_epi8('0'));
+  const __m256i letter = _mm256_sub_epi8(
+      _mm256_or_si256(chars, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+  const __m256i is_digit =
+      _mm256_cmpeq_epi8(_mm256_min_epu8(digit, _mm256_set1_epi8(9)), digit);
+  const __m256i is_letter =
+      _mm256_cmpeq_epi8(_mm256_min_epu8(letter, _mm256_set1_epi8(5)), letter);
+  *valid = _mm256_or_si256(is_digit, is_letter);
+  return _mm256_or_si256(
+      _mm256_and_si256(is_digit, digit),
+      _mm256_and_si256(is_letter,
+                       _mm256_add_epi8(letter, _mm256_set1_epi8(10))));
+}
+
+__attribute__((target("avx2"))) inline __m256i JoinNibbles(__m256i values) {
+  return _mm256_or_si256(
+      _mm256_slli_epi16(
+          _mm256_and_si256(values, _mm256_set1_epi16(0x00FF)), 4),
+      _mm256_srli_epi16(values, 8));
+}
+
+__attribute__((target("avx2"))) size_t EncodeAvx2(const uint8_t* src,
+                                                  size_t length,
+                                                  uint8_t* dst,
+                                                  HexCase hex_case) {
+  const __m256i mask = _mm256_set1_epi8(0x0F);
+  const __m256i letter = _mm256_set1_epi8(
+      hex_case == HexCase::kUpper ? 'A' - '0' - 10 : 'a' - '0' - 10);
+  size_t done = 0;
+  for (; length - done >= 32; done += 32) {
+    const __m256i in =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + done));
+    const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(in, 4), mask);
+    const __m256i lo = _mm256_and_si256(in, mask);
+    // The unpacks work within 128-bit lanes: |first| holds bytes 0-7 and
+    // 16-23, |second| bytes 8-15 and 24-31.
+    const __m256i first = ToDigits(_mm256_unpacklo_epi8(hi, lo), letter);
+    const __m256i second = ToDigits(_mm256_unpackhi_epi8(hi, lo), letter);
+    __m256i* out = reinterpret_cast<__m256i*>(dst + 2 * done);
+    _mm256_storeu_si256(out, _mm256_permute2x128_si256(first, second, 0x20));
+    _mm256_storeu_si256(out + 1,
+                        _mm256_permute2x128_si256(first, second, 0x31));
+  }
+  return done;
+}
+
+__attribute__((target("avx2"))) size_t DecodeAvx2(const uint8_t* src,
+                                                  size_t pairs,
+                                                  uint8_t* dst) {
+  size_t done = 0;
+  for (; pairs - done >= 32; done += 32) {
+    const __m256i* in = reinterpret_cast<const __m256i*>(src + 2 * done);
+    __m256i valid_a;
+    __m256i valid_b;
+    const __m256i a = FromDigits(_mm256_loadu_si256(in), &valid_a);
+    const __m256i b = FromDigits(_mm256_loadu_si256(in + 1), &valid_b);
+    if (_mm256_movemask_epi8(_mm256_and_si256(valid_a, valid_b)) != -1) {
+      break;
+    }
+    // The pack also works within lanes, leaving the 8 byte quarters in the
+    // order 0, 2, 1, 3.
+    const __m256i packed = _mm256_packus_epi16(JoinNibbles(a), JoinNibbles(b));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + done),
+                        _mm256_permute4x64_epi64(packed, 0xD8));
+  }
+  return done;
+}
+
+#elif defined(HEX_NEON)
+
+// Returns the value of each digit in |chars| and sets the bytes of |valid|
+// to 0xFF where there is a digit.
+inline uint8x16_t FromDigits(uint8x16_t chars, uint8x16_t* valid) {
+  const uint8x16_t digit = vsubq_u8(chars, vdupq_n_u8('0'));
+  const uint8x16_t letter =
+      vsubq_u8(vorrq_u8(chars, vdupq_n_u8(0x20)), vdupq_n_u8('a'));
+  const uint8x16_t is_digit = vcleq_u8(digit, vdupq_n_u8(9));
+  *valid = vorrq_u8(is_digit, vcleq_u8(letter, vdupq_n_u8(5)));
+  return vbslq_u8(is_digit, digit, vaddq_u8(letter, vdupq_n_u8(10)));
+}
+
+size_t EncodeNeon(const uint8_t* src,
+                  size_t length,
+                  uint8_t* dst,
+                  HexCase hex_case) {
+  const uint8x16_t digits = vld1q_u8(reinterpret_cast<const uint8_t*>(
+      hex_case == HexCase::kUpper ? kUpperDigits : kLowerDigits));
+  const uint8x16_t mask = vdupq_n_u8(0x0F);
+  size_t done = 0;
+  for (; length - done >= 16; done += 16) {
+    const uint8x16_t in = vld1q_u8(src + done);
+    uint8x16x2_t out;
+    out.val[0] = vqtbl1q_u8(digits, vshrq_n_u8(in, 4));
+    out.val[1] = vqtbl1q_u8(digits, vandq_u8(in, mask));
+    vst2q_u8(dst + 2 * done, out);
+  }
+  return done;
+}
+
+size_t DecodeNeon(const uint8_t* src, size_t pairs, uint8_t* dst) {
+  size_t done = 0;
+  for (; pairs - done >= 16; done += 16) {
+    // Splits the high digits from the low ones.
+    const uint8x16x2_t in = vld2q_u8(src + 2 * done);
+    uint8x16_t valid_hi;
+    uint8x16_t valid_lo;
+    const uint8x16_t hi = FromDigits(in.val[0], &valid_hi);
+    const uint8x16_t lo = FromDigits(in.val[1], &valid_lo);
+    if (vminvq_u8(vandq_u8(valid_hi, valid_lo)) == 0) {
+      break;
+    }
+    vst1q_u8(dst + done, vorrq_u8(vshlq_n_u8(hi, 4), lo));
+  }
+  return done;
+}
+
+#endif
+
+struct Kernels {
+  EncodeKernel encode;
+  DecodeKernel decode;
+};
+
+Kernels SelectKernels() {
+#if defined(HEX_X86)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return {EncodeAvx2, DecodeAvx2};
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return {EncodeSse2, DecodeSse2};
+  }
+#elif defined(HEX_NEON)
+  return {EncodeNeon, DecodeNeon};
+#endif
+  return {EncodeScalar, DecodeScalar};
+}
+
+const Kernels& GetKernels() {
+  static const Kernels kernels = SelectKernels();
+  return kernels;
+}
+
+}  // namespace
+
+std::string HexEncode(std::string_view input, HexCase hex_case) {
+  std::string result(HexEncodedSize(input.size()), '\0');
+  HexEncodeTo(input, &result[0], hex_case);
+  return result;
+}
+
+std::pair<bool, std::string> HexDecode(std::string_view input) {
+  std::string result(HexDecodedSize(input.size()), '\0');
+  size_t written = 0;
+  const bool ok =
+      HexDecodeTo(input, reinterpret_cast<uint8_t*>(&result[0]), &written);
+  result.resize(written);
+  return {ok, std::move(result)};
+}
+
+size_t HexEncodeTo(std::string_view input, char* output, HexCase hex_case) {
+  const uint8_t* src = reinterpret_cast<const uint8_t*>(input.data());
+  uint8_t* dst = reinterpret_cast<uint8_t*>(output);
+  const size_t done = GetKernels().encode(src, input.size(), dst, hex_case);
+  EncodeScalar(src + done, input.size() - done, dst + 2 * done, hex_case);
+  return HexEncodedSize(input.size());
+}
+
+bool HexDecodeTo(std::string_view input, uint8_t* output, size_t* written) {
+  const uint8_t* src = reinterpret_cast<const uint8_t*>(input.data());
+  const size_t pairs = HexDecodedSize(input.size());
+  size_t done = GetKernels().decode(src, pairs, output);
+  // Also finds the exact position of a non-digit that stopped the kernel.
+  done += DecodeScalar(src + 2 * done, pairs - done, output + done);
+  *written = done;
+  return done == pairs && input.size() % 2 == 0;
+}
+
+}  // namespace base
@@ -0,0 +1,49 @@
+#ifndef BASE_HEX_H_
+#define BASE_HEX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace base {
+
+enum class HexCase {
+  kLower,
+  kUpper,
+};
+
+// Hexadecimal conversions, two digits per byte with the high nibble first.
+// Runs of 16 bytes (SSE2, NEON) or 32 bytes (AVX2, where the CPU has it) are
+// converted per step; decoding accepts digits of either case.
+std::string HexEncode(std::string_view input,
+                      HexCase hex_case = HexCase::kLower);
+std::pair<bool, std::string> HexDecode(std::string_view input);
+
+// Number of characters HexEncode() produces for |size| bytes.
+constexpr size_t HexEncodedSize(size_t size) {
+  return size * 2;
+}
+
+// Number of bytes HexDecode() produces for |size| characters.
+constexpr size_t HexDecodedSize(size_t size) {
+  return size / 2;
+}
+
+// Encodes |input| into |output|, which must have room for
+// HexEncodedSize(input.size()) characters. Returns the number written.
+size_t HexEncodeTo(std::string_view input,
+                   char* output,
+                   HexCase hex_case = HexCase::kLower);
+
+// Decodes |input| into |output|, which must have room for
+// HexDecodedSize(input.size()) bytes, and sets |written| to the number of
+// bytes decoded. Returns false on a character that is not a hex digit or an
+// odd number of characters; |written| then counts the digit pairs decoded
+// before the error.
+bool HexDecodeTo(std::string_view input, uint8_t* output, size_t* written);
+
+}  // namespace base
+
+#endif  // BASE_HEX_H_
@@ -103,9 +103,8 @@ std::string JavaStringToString(JNIEnv* env, jstring str) {
   if (chars == nullptr) {
     return "";
   }
-  std::u16string u16_string(reinterpret_cast<const char16_t*>(chars),
-                            env->GetStringLength(str));
-  std::string u8_string = Utf16ToUtf8(u16_string);
+  std::string u8_string = Utf16ToUtf8(std::u16string_view(
+      reinterpret_cast<const char16_t*>(chars), env->GetStringLength(str)));
   env->ReleaseStringChars(str, chars);
   ASSERT_NO_EXCEPTION();
   return u8_string;
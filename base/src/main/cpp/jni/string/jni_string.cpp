@@ -7,19 +7,32 @@
 #include <jni.h>
 
 #include <string>
+#include <string_view>
+
+#include "../../string_conversion.h"
 
 namespace base {
 namespace jni {
 namespace string {
 
 std::string ConvertJavaStringToUTF8(JNIEnv* env, jstring java_string) {
-  // Convert Java string to std::string
-  const jsize strLen = env->GetStringUTFLength(java_string);
-  const char* char_buffer = env->GetStringUTFChars(java_string, nullptr);
-  std::string str(char_buffer, strLen);
+  // Transcode the UTF-16 chars directly. GetStringUTFChars would produce
+  // modified UTF-8, which encodes supplementary characters as surrogate
+  // pairs and NUL as two bytes, and copies the string once more.
+  const jsize length = env->GetStringLength(java_string);
+  std::string str(MaxUtf8Length(length), '\0');
+  const jchar* chars = env->GetStringCritical(java_string, nullptr);
+  if (chars == nullptr) {
+    env->DeleteLocalRef(java_string);
+    return std::string();
+  }
+  // No JNI calls are allowed until the chars are released.
+  str.resize(Utf16ToUtf8(
+      std::u16string_view(reinterpret_cast<const char16_t*>(chars), length),
+      &str[0]));
 
   // Release memory
-  env->ReleaseStringUTFChars(java_string, char_buffer);
+  env->ReleaseStringCritical(java_string, chars);
   env->DeleteLocalRef(java_string);
   return str;
 }
@@ -8,6 +8,7 @@
 
 // C++ includes
 #include <iomanip>
+#include <limits>
 #include <sstream>
 
 
@@ -213,6 +214,8 @@ JSONArray::Size JSONArray::GetNumElements() { return m_elements.size(); }
 
 JSONParser::JSONParser(const char *cstr) : StdStringExtractor(cstr) {}
 
+JSONParser::JSONParser(std::string_view json) : StdStringExtractor(json) {}
+
 JSONParser::Token JSONParser::GetToken(std::string &value) {
   std::ostringstream error;
 
@@ -373,7 +376,7 @@ JSONParser::Token JSONParser::GetToken(std::string &value) {
       }
 
       if (m_index > start_index) {
-        value = m_packet.substr(start_index, m_index - start_index);
+        value.assign(m_packet, start_index, m_index - start_index);
         if (got_decimal_point) {
           if (exp_index != 0) {
             // We have an exponent, make sure we got exponent digits
@@ -522,6 +525,53 @@ JSONValue::SP JSONParser::ParseJSONArray() {
   return JSONValue::SP();
 }
 
+namespace {
+
+// Whether the tokenizer-validated number |s| is at least 1 in magnitude.
+bool IsAtLeastOne(const std::string &s) {
+  size_t i = s[0] == '-' ? 1 : 0;
+  // Decimal exponent of the leading digit, and whether it is non-zero yet.
+  int64_t weight = -1;
+  bool found = false;
+  bool after_point = false;
+  for (; i < s.size() && s[i] != 'e' && s[i] != 'E'; i++) {
+    if (s[i] == '.') {
+      after_point = true;
+    } else if (!found && s[i] != '0') {
+      found = true;
+      if (!after_point) weight = 0;
+    } else if (!after_point && found) {
+      weight++;
+    } else if (after_point && !found) {
+      weight--;
+    }
+  }
+  if (!found) return false;
+  int64_t exponent = 0;
+  bool negative = false;
+  if (i < s.size()) {
+    i++;
+    if (s[i] == '+' || s[i] == '-') negative = s[i++] == '-';
+    for (; i < s.size() && exponent < INT32_MAX; i++) {
+      exponent = exponent * 10 + (s[i] - '0');
+    }
+  }
+  return weight + (negative ? -exponent : exponent) >= 0;
+}
+
+// Parses a number token as a double. Out of range values saturate like
+// strtod: to +/-inf if too large, to +/-0 if too small.
+double ParseJSONDouble(const std::string &value) {
+  double result;
+  if (base::StringConvert::ToDouble(value, &result)) return result;
+  const double magnitude = IsAtLeastOne(value)
+                               ? std::numeric_limits<double>::infinity()
+                               : 0.0;
+  return value.front() == '-' ? -magnitude : magnitude;
+}
+
+}  // namespace
+
 JSONValue::SP JSONParser::ParseJSONValue() {
   std::string value;
   const JSONParser::Token token = GetToken(value);
@@ -539,21 +589,20 @@ JSONValue::SP JSONParser::ParseJSONValue(const std::string &value,
 
     case JSONParser::Token::Integer: {
       if (value.front() == '-') {
-        bool success = false;
-        int64_t sval = base::StringConvert::ToSInt64(value.c_str(), 0, 0, &success);
-        if (success) return JSONValue::SP(new JSONNumber(sval));
+        int64_t sval;
+        if (base::StringConvert::ToSInt64(value, &sval))
+          return JSONValue::SP(new JSONNumber(sval));
       } else {
-        bool success = false;
-        uint64_t uval = base::StringConvert::ToUInt64(value.c_str(), 0, 0, &success);
-        if (success) return JSONValue::SP(new JSONNumber(uval));
+        uint64_t uval;
+        if (base::StringConvert::ToUInt64(value, &uval))
+          return JSONValue::SP(new JSONNumber(uval));
       }
-    } break;
+      // Too large for 64 bits, or with an exponent: keep it as a double.
+      return JSONValue::SP(new JSONNumber(ParseJSONDouble(value)));
+    }
 
-    case JSONParser::Token::Float: {
-      bool success = false;
-      double val = base::StringConvert::ToDouble(value.c_str(), 0.0, &success);
-      if (success) return JSONValue::SP(new JSONNumber(val));
-    } break;
+    case JSONParser::Token::Float:
+      return JSONValue::SP(new JSONNumber(ParseJSONDouble(value)));
 
     case JSONParser::Token::String:
       return JSONValue::SP(new JSONString(value));
@@ -11,6 +11,7 @@
 #include <memory>
 #include <ostream>
 #include <string>
+#include <string_view>
 #include <vector>
 #include "../string/StdStringExtractor.h"
 
@@ -275,7 +276,9 @@ class JSONParser : public StdStringExtractor {
     EndOfFile
   };
 
+  // The parser reads the JSON in place; it must outlive the parser.
   JSONParser(const char *cstr);
+  JSONParser(std::string_view json);
 
   int GetEscapedChar(bool &was_escaped);
 
@@ -2,11 +2,14 @@
 #define JSON_JSON_GENERATOR_H
 
 #include <iomanip>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "../string/string_builder.h"
+
 /// \class JSONGenerator JSONGenerator.h
 /// A class which can construct structured data for the sole purpose
 /// of printing it in JSON format.
@@ -96,7 +99,21 @@ class JSONGenerator {
       return NULL;
     }
 
-    virtual void Dump(std::ostream &s) const = 0;
+    /// Writes the JSON text of the object to s.
+    void Dump(std::ostream &s) const {
+      base::string::StringBuilder builder;
+      DumpTo(&builder);
+      s.write(builder.data(), builder.size());
+    }
+
+    std::string DumpToString() const {
+      base::string::StringBuilder builder;
+      DumpTo(&builder);
+      return builder.ToString();
+    }
+
+    /// Appends the JSON text of the object to s.
+    virtual void DumpTo(base::string::StringBuilder *s) const = 0;
 
    private:
     Type m_type;
@@ -110,14 +127,14 @@ class JSONGenerator {
 
     void AddItem(ObjectSP item) { m_items.push_back(item); }
 
-    void Dump(std::ostream &s) const override {
-      s << "[";
+    void DumpTo(base::string::StringBuilder *s) const override {
+      s->push_back('[');
       const size_t arrsize = m_items.size();
       for (size_t i = 0; i < arrsize; ++i) {
-        m_items[i]->Dump(s);
-        if (i + 1 < arrsize) s << ",";
+        m_items[i]->DumpTo(s);
+        if (i + 1 < arrsize) s->push_back(',');
       }
-      s << "]";
+      s->push_back(']');
     }
 
    protected:
@@ -133,7 +150,9 @@ class JSONGenerator {
 
     void SetValue(uint64_t value) { m_value = value; }
 
-    void Dump(std::ostream &s) const override { s << m_value; }
+    void DumpTo(base::string::StringBuilder *s) const override {
+      s->Append(m_value);
+    }
 
    protected:
     uint64_t m_value;
@@ -147,7 +166,9 @@ class JSONGenerator {
 
     void SetValue(double value) { m_value = value; }
 
-    void Dump(std::ostream &s) const override { s << m_value; }
+    void DumpTo(base::string::StringBuilder *s) const override {
+      s->Append(m_value);
+    }
 
    protected:
     double m_value;
@@ -161,11 +182,11 @@ class JSONGenerator {
 
     void SetValue(bool value) { m_value = value; }
 
-    void Dump(std::ostream &s) const override {
+    void DumpTo(base::string::StringBuilder *s) const override {
       if (m_value)
-        s << "true";
+        s->Append("true");
       else
-        s << "false";
+        s->Append("false");
     }
 
    protected:
@@ -182,15 +203,15 @@ class JSONGenerator {
 
     void SetValue(const std::string &string) { m_value = string; }
 
-    void Dump(std::ostream &s) const override {
-      std::string quoted;
+    void DumpTo(base::string::StringBuilder *s) const override {
+      s->push_back('"');
       const size_t strsize = m_value.size();
       for (size_t i = 0; i < strsize; ++i) {
         char ch = m_value[i];
-        if (ch == '"') quoted.push_back('\\');
-        quoted.push_back(ch);
+        if (ch == '"') s->push_back('\\');
+        s->push_back(ch);
       }
-      s << '"' << quoted.c_str() << '"';
+      s->push_back('"');
     }
 
    protected:
@@ -236,20 +257,20 @@ class JSONGenerator {
       AddItem(key, ObjectSP(new Boolean(value)));
     }
 
-    void Dump(std::ostream &s) const override {
+    void DumpTo(base::string::StringBuilder *s) const override {
       bool have_printed_one_elem = false;
-      s << "{";
+      s->push_back('{');
       for (collection::const_iterator iter = m_dict.begin();
            iter != m_dict.end(); ++iter) {
         if (!have_printed_one_elem) {
           have_printed_one_elem = true;
         } else {
-          s << ",";
+          s->push_back(',');
         }
-        s << "\"" << iter->first.c_str() << "\":";
-        iter->second->Dump(s);
+        s->Append("\"", iter->first, "\":");
+        iter->second->DumpTo(s);
       }
-      s << "}";
+      s->push_back('}');
     }
 
    protected:
@@ -269,7 +290,9 @@ class JSONGenerator {
 
     bool IsValid() const override { return false; }
 
-    void Dump(std::ostream &s) const override { s << "null"; }
+    void DumpTo(base::string::StringBuilder *s) const override {
+      s->Append("null");
+    }
 
    protected:
   };
@@ -285,7 +308,7 @@ class JSONGenerator {
 
     bool IsValid() const override { return m_object != nullptr; }
 
-    void Dump(std::ostream &s) const override;
+    void DumpTo(base::string::StringBuilder *s) const override;
 
    private:
     void *m_object;
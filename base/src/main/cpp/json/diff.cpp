@@ -0,0 +1,418 @@
+#include "diff.h"
+
+#include <algorithm>
+#include <atomic>
+#include <string_view>
+#include <utility>
+#include <variant>
+
+#include "absl/hash/hash.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "../curl/scheduler.h"
+#include "../logging.h"
+
+namespace base {
+namespace json {
+namespace {
+
+using value_t = ::nlohmann::json::value_t;
+using array_t = ::nlohmann::json::array_t;
+using object_t = ::nlohmann::json::object_t;
+
+uint64_t Mix(uint64_t seed, uint64_t value) {
+  return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
+
+uint64_t StringHash(std::string_view s) {
+  return absl::Hash<std::string_view>{}(s);
+}
+
+uint64_t DoubleHash(double d) {
+  if (d == 0) d = 0;  // -0.0 == 0.0
+  return Mix(static_cast<uint64_t>(value_t::number_float),
+             absl::Hash<double>{}(d));
+}
+
+// Integers past 2^53 are hashed exactly: going through double would make
+// neighbouring values collide.
+uint64_t IntegerHash(bool negative, uint64_t magnitude) {
+  return Mix(Mix(static_cast<uint64_t>(value_t::number_integer), negative),
+             magnitude);
+}
+
+// Hash of a non-container value. Numbers that a double represents exactly are
+// hashed through it, so that values `JsonSame` considers equal hash equally.
+uint64_t ScalarHash(const ::nlohmann::json& value) {
+  const auto t = value.type();
+  const uint64_t tag = static_cast<uint64_t>(t);
+  switch (t) {
+    case value_t::boolean:
+      return Mix(tag, value.get<bool>() ? 1 : 0);
+    case value_t::number_integer: {
+      const int64_t i = value.get<int64_t>();
+      const double d = static_cast<double>(i);
+      // 2^63 rounds from INT64_MAX and does not convert back.
+      if (d < 9223372036854775808.0 && static_cast<int64_t>(d) == i) {
+        return DoubleHash(d);
+      }
+      return IntegerHash(i < 0, i < 0 ? 0 - static_cast<uint64_t>(i)
+                                      : static_cast<uint64_t>(i));
+    }
+    case value_t::number_unsigned: {
+      const uint64_t u = value.get<uint64_t>();
+      const double d = static_cast<double>(u);
+      if (d < 18446744073709551616.0 && static_cast<uint64_t>(d) == u) {
+        return DoubleHash(d);
+      }
+      return IntegerHash(false, u);
+    }
+    case value_t::number_float:
+      return DoubleHash(value.get<double>());
+    case value_t::string:
+      return Mix(tag, StringHash(value.get_ref<const std::string&>()));
+    case value_t::binary: {
+      const auto& bin = value.get_binary();
+      return Mix(tag, StringHash(std::string_view(
+                          reinterpret_cast<const char*>(bin.data()),
+                          bin.size())));
+    }
+    default:
+      return tag;
+  }
+}
+
+void AppendIndex(std::string* path, size_t index) {
+  path->push_back('/');
+  path->append(std::to_string(index));
+}
+
+// Appends `key` as an RFC 6901 reference token.
+void AppendKey(std::string* path, std::string_view key) {
+  path->push_back('/');
+  for (char c : key) {
+    if (c == '~') {
+      path->append("~0");
+    } else if (c == '/') {
+      path->append("~1");
+    } else {
+      path->push_back(c);
+    }
+  }
+}
+
+class Differ {
+ public:
+  Differ(const JsonDiffOptions& options,
+         std::atomic<size_t>* op_count,
+         bool allow_parallel)
+      : options_(options),
+        op_count_(op_count),
+        allow_parallel_(allow_parallel) {}
+
+  // Appends the operations turning `a` into `b` to `out`. `path` is the
+  // location of `a` in the root document.
+  void Run(const ::nlohmann::json& a,
+           const ::nlohmann::json& b,
+           std::string path,
+           std::vector<JsonPatchOp>* out) {
+    path_ = std::move(path);
+    out_ = out;
+    CompareOrDefer(a, b);
+    while (!stack_.empty() && !Stopped()) {
+      auto& e = stack_.back();
+      if (auto* array_frame = std::get_if<ArrayFrame>(&e)) {
+        if (array_frame->next == array_frame->end) {
+          stack_.pop_back();
+          continue;
+        }
+        const size_t i = array_frame->next++;
+        const auto& a_v = (*array_frame->a)[i];
+        const auto& b_v = (*array_frame->b)[i];
+        path_.resize(array_frame->path_size);
+        AppendIndex(&path_, i);
+        CompareOrDefer(a_v, b_v);
+      } else {
+        auto* object_frame = std::get_if<ObjectFrame>(&e);
+        auto& a_cur = object_frame->a_cur;
+        auto& b_cur = object_frame->b_cur;
+        const bool a_done = a_cur == object_frame->a_end;
+        const bool b_done = b_cur == object_frame->b_end;
+        if (a_done && b_done) {
+          stack_.pop_back();
+          continue;
+        }
+        path_.resize(object_frame->path_size);
+        if (b_done || (!a_done && a_cur->first < b_cur->first)) {
+          AppendKey(&path_, a_cur->first);
+          ++a_cur;
+          Emit(JsonPatchOp::Type::kRemove, nullptr);
+        } else if (a_done || b_cur->first < a_cur->first) {
+          AppendKey(&path_, b_cur->first);
+          const auto& b_v = (b_cur++)->second;
+          Emit(JsonPatchOp::Type::kAdd, &b_v);
+        } else {
+          AppendKey(&path_, a_cur->first);
+          const auto& a_v = (a_cur++)->second;
+          const auto& b_v = (b_cur++)->second;
+          CompareOrDefer(a_v, b_v);
+        }
+      }
+    }
+    stack_.clear();
+  }
+
+ private:
+  struct ArrayFrame {
+    const array_t* a;
+    const array_t* b;
+    size_t next, end;
+    size_t path_size;
+  };
+  struct ObjectFrame {
+    object_t::const_iterator a_cur, a_end, b_cur, b_end;
+    size_t path_size;
+  };
+  using StackEntry = std::variant<ArrayFrame, ObjectFrame>;
+
+  // A child slot of a container that is split across tasks. For objects
+  // `key` is set and one of `a`/`b` is null for removed/added members.
+  struct Child {
+    const std::string* key;
+    size_t index;
+    const ::nlohmann::json* a;
+    const ::nlohmann::json* b;
+  };
+
+  bool Stopped() const {
+    return options_.max_ops != 0 &&
+           op_count_->load(std::memory_order_relaxed) >= options_.max_ops;
+  }
+
+  void Emit(JsonPatchOp::Type type, const ::nlohmann::json* value) {
+    if (options_.max_ops != 0 &&
+        op_count_->fetch_add(1, std::memory_order_relaxed) >=
+            options_.max_ops) {
+      return;
+    }
+    out_->push_back(
+        JsonPatchOp{type, path_, value ? *value : ::nlohmann::json()});
+  }
+
+  bool HashesEqual(const ::nlohmann::json& a, const ::nlohmann::json& b) const {
+    return options_.a_index && options_.b_index &&
+           options_.a_index->Get(a) == options_.b_index->Get(b);
+  }
+
+  bool ShouldSplit(size_t children) const {
+    return allow_parallel_ && options_.scheduler &&
+           children >= options_.parallel_threshold;
+  }
+
+  // Compares scalars right away and pushes a frame for containers. Emits a
+  // replace if the values differ in type.
+  void CompareOrDefer(const ::nlohmann::json& a, const ::nlohmann::json& b) {
+    const auto t = a.type();
+    if (t != b.type() && !(a.is_number() && b.is_number())) {
+      Emit(JsonPatchOp::Type::kReplace, &b);
+      return;
+    }
+    switch (t) {
+      case value_t::discarded:
+      case value_t::null:
+        return;
+      case value_t::array: {
+        if (HashesEqual(a, b)) return;
+        const auto& a_arr = a.get_ref<const array_t&>();
+        const auto& b_arr = b.get_ref<const array_t&>();
+        const size_t common = std::min(a_arr.size(), b_arr.size());
+        const size_t path_size = path_.size();
+        for (size_t i = a_arr.size(); i-- > common;) {
+          AppendIndex(&path_, i);
+          Emit(JsonPatchOp::Type::kRemove, nullptr);
+          path_.resize(path_size);
+        }
+        for (size_t i = common; i < b_arr.size(); ++i) {
+          AppendIndex(&path_, i);
+          Emit(JsonPatchOp::Type::kAdd, &b_arr[i]);
+          path_.resize(path_size);
+        }
+        if (common == 0) return;
+        if (ShouldSplit(common)) {
+          std::vector<Child> children;
+          children.reserve(common);
+          for (size_t i = 0; i < common; ++i) {
+            children.push_back(Child{nullptr, i, &a_arr[i], &b_arr[i]});
+          }
+          RunSplit(children);
+          return;
+        }
+        stack_.emplace_back(ArrayFrame{&a_arr, &b_arr, 0, common, path_size});
+        return;
+      }
+      case value_t::object: {
+        if (HashesEqual(a, b)) return;
+        const auto& a_obj = a.get_ref<const object_t&>();
+        const auto& b_obj = b.get_ref<const object_t&>();
+        if (a_obj.empty() && b_obj.empty()) return;
+        if (ShouldSplit(std::max(a_obj.size(), b_obj.size()))) {
+          RunSplit(MergeChildren(a_obj, b_obj));
+          return;
+        }
+        stack_.emplace_back(ObjectFrame{a_obj.begin(), a_obj.end(),
+                                        b_obj.begin(), b_obj.end(),
+                                        path_.size()});
+        return;
+      }
+      default:
+        if (!(a == b)) Emit(JsonPatchOp::Type::kReplace, &b);
+        return;
+    }
+  }
+
+  static std::vector<Child> MergeChildren(const object_t& a_obj,
+                                          const object_t& b_obj) {
+    std::vector<Child> children;
+    children.reserve(std::max(a_obj.size(), b_obj.size()));
+    auto a_cur = a_obj.begin();
+    auto b_cur = b_obj.begin();
+    while (a_cur != a_obj.end() || b_cur != b_obj.end()) {
+      if (b_cur == b_obj.end() ||
+          (a_cur != a_obj.end() && a_cur->first < b_cur->first)) {
+        children.push_back(Child{&a_cur->first, 0, &a_cur->second, nullptr});
+        ++a_cur;
+      } else if (a_cur == a_obj.end() || b_cur->first < a_cur->first) {
+        children.push_back(Child{&b_cur->first, 0, nullptr, &b_cur->second});
+        ++b_cur;
+      } else {
+        children.push_back(
+            Child{&a_cur->first, 0, &a_cur->second, &b_cur->second});
+        ++a_cur;
+        ++b_cur;
+      }
+    }
+    return children;
+  }
+
+  // Diffs `children` of the container at `path_` in contiguous chunks on
+  // the scheduler and appends the chunk results in order.
+  void RunSplit(const std::vector<Child>& children) {
+    const size_t task_count = std::max<size_t>(
+        1, std::min(options_.parallel_tasks, children.size()));
+    const size_t chunk = (children.size() + task_count - 1) / task_count;
+    std::vector<std::vector<JsonPatchOp>> results(task_count);
+    absl::BlockingCounter pending(static_cast<int>(task_count));
+    for (size_t t = 0; t < task_count; ++t) {
+      const size_t begin = std::min(children.size(), t * chunk);
+      const size_t end = std::min(children.size(), begin + chunk);
+      options_.scheduler->Schedule([this, &children, &results, &pending, t,
+                                    begin, end] {
+        Differ differ(options_, op_count_, false);
+        std::string path;
+        for (size_t i = begin; i < end && !differ.Stopped(); ++i) {
+          const Child& child = children[i];
+          path = path_;
+          if (child.key) {
+            AppendKey(&path, *child.key);
+          } else {
+            AppendIndex(&path, child.index);
+          }
+          if (!child.b) {
+            differ.path_ = std::move(path);
+            differ.out_ = &results[t];
+            differ.Emit(JsonPatchOp::Type::kRemove, nullptr);
+          } else if (!child.a) {
+            differ.path_ = std::move(path);
+            differ.out_ = &results[t];
+            differ.Emit(JsonPatchOp::Type::kAdd, child.b);
+          } else {
+            differ.Run(*child.a, *child.b, std::move(path), &results[t]);
+          }
+        }
+        pending.DecrementCount();
+      });
+    }
+    pending.Wait();
+    for (auto& result : results) {
+      out_->insert(out_->end(), std::make_move_iterator(result.begin()),
+                   std::make_move_iterator(result.end()));
+    }
+  }
+
+  const JsonDiffOptions& options_;
+  std::atomic<size_t>* op_count_;
+  const bool allow_parallel_;
+  std::string path_;
+  std::vector<JsonPatchOp>* out_ = nullptr;
+  std::vector<StackEntry> stack_;
+};
+
+}  // namespace
+
+JsonHashIndex::JsonHashIndex(const ::nlohmann::json& root) {
+  // Collect containers in pre-order, then hash them in reverse so that every
+  // child is hashed before its parent.
+  std::vector<const ::nlohmann::json*> containers;
+  std::vector<const ::nlohmann::json*> pending{&root};
+  while (!pending.empty()) {
+    const auto* node = pending.back();
+    pending.pop_back();
+    if (!node->is_structured()) continue;
+    containers.push_back(node);
+    for (const auto& child : *node) {
+      if (child.is_structured()) pending.push_back(&child);
+    }
+  }
+  hashes_.reserve(containers.size());
+  const auto child_hash = [this](const ::nlohmann::json& child) {
+    return child.is_structured() ? hashes_.at(&child) : ScalarHash(child);
+  };
+  for (auto it = containers.rbegin(); it != containers.rend(); ++it) {
+    const auto& node = **it;
+    uint64_t h = static_cast<uint64_t>(node.type());
+    if (node.is_array()) {
+      for (const auto& child : node.get_ref<const array_t&>()) {
+        h = Mix(h, child_hash(child));
+      }
+    } else {
+      for (const auto& [key, value] : node.get_ref<const object_t&>()) {
+        h = Mix(Mix(h, StringHash(key)), child_hash(value));
+      }
+    }
+    hashes_.emplace(&node, h);
+  }
+}
+
+uint64_t JsonHashIndex::Get(const ::nlohmann::json& node) const {
+  if (!node.is_structured()) return ScalarHash(node);
+  auto it = hashes_.find(&node);
+  BASE_DCHECK(it != hashes_.end()) << "node is not part of the indexed tree";
+  return it == hashes_.end() ? 0 : it->second;
+}
+
+std::vector<JsonPatchOp> JsonDiff(const ::nlohmann::json& a,
+                                  const ::nlohmann::json& b,
+                                  const JsonDiffOptions& options) {
+  std::atomic<size_t> op_count{0};
+  std::vector<JsonPatchOp> ops;
+  Differ(options, &op_count, true).Run(a, b, std::string(), &ops);
+  return ops;
+}
+
+::nlohmann::json JsonPatchToJson(const std::vector<JsonPatchOp>& ops) {
+  auto patch = ::nlohmann::json::array();
+  for (const auto& op : ops) {
+    const char* name = "replace";
+    if (op.type == JsonPatchOp::Type::kAdd) {
+      name = "add";
+    } else if (op.type == JsonPatchOp::Type::kRemove) {
+      name = "remove";
+    }
+    ::nlohmann::json entry = {{"op", name}, {"path", op.path}};
+    if (op.type != JsonPatchOp::Type::kRemove) entry["value"] = op.value;
+    patch.push_back(std::move(entry));
+  }
+  return patch;
+}
+
+}  // namespace json
+}  // namespace base
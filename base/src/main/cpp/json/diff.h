@@ -0,0 +1,99 @@
+#ifndef BASE_JSON_DIFF_H
+#define BASE_JSON_DIFF_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "absl/container/flat_hash_map.h"
+#include "../macros.h"
+
+class Scheduler;
+
+namespace base {
+namespace json {
+
+/// One difference between two documents, expressed as an RFC 6902 (JSON
+/// Patch) operation. `path` is an RFC 6901 JSON Pointer to the location the
+/// operation applies to: in the *source* document for `kRemove` and
+/// `kReplace`, in the *target* document for `kAdd`. `value` is unset for
+/// `kRemove`.
+struct JsonPatchOp {
+  enum class Type { kAdd, kRemove, kReplace };
+
+  Type type;
+  std::string path;
+  ::nlohmann::json value;
+};
+
+/// Structural hashes of every array and object in a document.
+///
+/// Building the index walks the document once. Keeping the index of the
+/// previous snapshot around lets `JsonDiff` skip every container whose hash is
+/// unchanged without looking inside it. The index refers to the nodes of
+/// `root` by address, so `root` must outlive it and must not be mutated.
+///
+/// Hashes follow `JsonSame` semantics: numbers representing the same value
+/// hash equally regardless of their integer/float type. Integers a double
+/// cannot represent exactly are hashed by their exact value instead, so that
+/// distinct large integers do not collide.
+class JsonHashIndex {
+ public:
+  explicit JsonHashIndex(const ::nlohmann::json& root);
+
+  /// Returns the hash of `node`, which must be `root` or a descendant of it.
+  uint64_t Get(const ::nlohmann::json& node) const;
+
+ private:
+  absl::flat_hash_map<const ::nlohmann::json*, uint64_t> hashes_;
+
+  BASE_DISALLOW_COPY_AND_ASSIGN(JsonHashIndex);
+};
+
+struct JsonDiffOptions {
+  /// Stops after this many operations have been found; 0 means report every
+  /// difference. `max_ops = 1` answers "did anything change?" as cheaply as
+  /// `JsonSame`.
+  size_t max_ops = 0;
+
+  /// Optional hash indexes of `a` and `b`. When both are given, containers
+  /// with equal hashes are treated as identical and not descended into, so a
+  /// change goes unreported if two different containers have colliding 64-bit
+  /// hashes. The hashes are not collision-resistant against crafted input.
+  const JsonHashIndex* a_index = nullptr;
+  const JsonHashIndex* b_index = nullptr;
+
+  /// When set, arrays and objects with at least `parallel_threshold` children
+  /// have their children compared in up to `parallel_tasks` tasks on this
+  /// scheduler. Containers nested inside a split container are not split
+  /// again. The calling thread blocks until the tasks are done, so it must not
+  /// be one of the scheduler's own threads. When `max_ops` cuts the walk
+  /// short, which of the differences get reported is then unspecified.
+  Scheduler* scheduler = nullptr;
+  size_t parallel_threshold = 4096;
+  size_t parallel_tasks = 8;
+};
+
+/// Computes the operations that turn `a` into `b`.
+///
+/// Applying the returned operations in order to `a` yields a document that is
+/// `JsonSame` to `b`. Array elements are compared by index: extra trailing
+/// elements are removed (from the back) or added, the common prefix is diffed
+/// element by element. Like `JsonSame`, the walk is non-recursive.
+///
+/// Unless `max_ops` stops the walk early, the result does not depend on whether
+/// the comparison ran in parallel.
+std::vector<JsonPatchOp> JsonDiff(const ::nlohmann::json& a,
+                                  const ::nlohmann::json& b,
+                                  const JsonDiffOptions& options = {});
+
+/// Converts `ops` to an RFC 6902 patch document.
+::nlohmann::json JsonPatchToJson(const std::vector<JsonPatchOp>& ops);
+
+}  // namespace json
+}  // namespace base
+
+#endif  // BASE_JSON_DIFF_H
@@ -3,9 +3,14 @@
 #include <fcntl.h>
 
 #include <algorithm>
+#include <atomic>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <limits>
+#include <mutex>
+#include <string_view>
+#include <vector>
 #include "log_level.h"
 #include "logging.h"
 
@@ -17,17 +22,141 @@ extern LogSettings g_log_settings;
 
 }  // namespace state
 
+namespace {
+
+struct VmoduleEntry {
+  std::string pattern;
+  LogSeverity min_log_level;
+};
+
+// Guards state::g_log_settings and the parsed vmodule entries.
+std::mutex& GetLogSettingsMutex() {
+  static std::mutex* mutex = new std::mutex();
+  return *mutex;
+}
+
+std::vector<VmoduleEntry>& GetVmoduleEntries() {
+  static std::vector<VmoduleEntry>* entries = new std::vector<VmoduleEntry>();
+  return *entries;
+}
+
+// Read without the lock by GetMinLogLevel().
+std::atomic<LogSeverity> g_min_log_level{kLogInfo};
+
+// Skips malformed entries: there is nowhere to report them but the log.
+std::vector<VmoduleEntry> ParseVmodule(std::string_view vmodule) {
+  std::vector<VmoduleEntry> entries;
+  while (!vmodule.empty()) {
+    const size_t comma = vmodule.find(',');
+    const std::string_view entry = vmodule.substr(0, comma);
+    vmodule = comma == std::string_view::npos ? std::string_view()
+                                              : vmodule.substr(comma + 1);
+    const size_t equals = entry.rfind('=');
+    if (equals == 0 || equals == std::string_view::npos) {
+      continue;
+    }
+    const std::string text(entry.substr(equals + 1));
+    char* end = nullptr;
+    const long value = strtol(text.c_str(), &end, 10);
+    if (text.empty() || *end != '\0') {
+      continue;
+    }
+    // A verbosity of -kLogFatal already keeps only FATAL messages.
+    const long verbosity = std::clamp<long>(value, -kLogFatal, 1 << 16);
+    entries.push_back({std::string(entry.substr(0, equals)),
+                       static_cast<LogSeverity>(-verbosity)});
+  }
+  return entries;
+}
+
+// Matches |text| against |pattern|, where '*' matches any run of characters
+// and '?' any one character.
+bool MatchesPattern(std::string_view pattern, std::string_view text) {
+  size_t p = 0;
+  size_t t = 0;
+  // Where to resume after the last '*' if the rest fails to match.
+  size_t star = std::string_view::npos;
+  size_t star_text = 0;
+  while (t < text.size()) {
+    if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == text[t])) {
+      p++;
+      t++;
+    } else if (p < pattern.size() && pattern[p] == '*') {
+      star = p++;
+      star_text = t;
+    } else if (star != std::string_view::npos) {
+      p = star + 1;
+      t = ++star_text;
+    } else {
+      return false;
+    }
+  }
+  while (p < pattern.size() && pattern[p] == '*') {
+    p++;
+  }
+  return p == pattern.size();
+}
+
+// Whether |pattern| matches the module of |path|, which has no extension.
+bool MatchesModule(std::string_view pattern, std::string_view path) {
+  if (pattern.find('/') == std::string_view::npos) {
+    const size_t slash = path.rfind('/');
+    return MatchesPattern(pattern, slash == std::string_view::npos
+                                       ? path
+                                       : path.substr(slash + 1));
+  }
+  if (MatchesPattern(pattern, path)) {
+    return true;
+  }
+  for (size_t slash = path.find('/'); slash != std::string_view::npos;
+       slash = path.find('/', slash + 1)) {
+    if (MatchesPattern(pattern, path.substr(slash + 1))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
 void SetLogSettings(const LogSettings& settings) {
-  // Validate the new settings as we set them.
-  state::g_log_settings.min_log_level =
-      std::min(kLogFatal, settings.min_log_level);
+  std::vector<VmoduleEntry> entries = ParseVmodule(settings.vmodule);
+  {
+    std::scoped_lock lock(GetLogSettingsMutex());
+    // Validate the new settings as we set them.
+    state::g_log_settings.min_log_level =
+        std::min(kLogFatal, settings.min_log_level);
+    state::g_log_settings.vmodule = settings.vmodule;
+    GetVmoduleEntries() = std::move(entries);
+    g_min_log_level.store(state::g_log_settings.min_log_level,
+                          std::memory_order_relaxed);
+  }
+  // Makes every LogSite look up its level again.
+  state::g_log_settings_generation.fetch_add(1, std::memory_order_release);
 }
 
 LogSettings GetLogSettings() {
+  std::scoped_lock lock(GetLogSettingsMutex());
   return state::g_log_settings;
 }
 
 int GetMinLogLevel() {
+  return std::min(g_min_log_level.load(std::memory_order_relaxed), kLogFatal);
+}
+
+int GetMinLogLevelForFile(const char* file) {
+  std::string_view path(file);
+  const size_t dot = path.rfind('.');
+  if (dot != std::string_view::npos &&
+      path.find('/', dot) == std::string_view::npos) {
+    path = path.substr(0, dot);
+  }
+  std::scoped_lock lock(GetLogSettingsMutex());
+  for (const VmoduleEntry& entry : GetVmoduleEntries()) {
+    if (MatchesModule(entry.pattern, path)) {
+      return entry.min_log_level;
+    }
+  }
   return std::min(state::g_log_settings.min_log_level, kLogFatal);
 }
 
@@ -19,6 +19,17 @@ struct LogSettings {
   // at level -x, so setting the min log level to negative values enables
   // verbose logging.
   LogSeverity min_log_level = kLogInfo;
+
+  // Per-module overrides of |min_log_level|, as comma-separated
+  // <pattern>=<verbosity> entries in the style of glog's --vmodule, e.g.
+  // "curl_http_client=2,looper=-1".
+  //
+  // A pattern is matched against the name of a source file without its
+  // directory and extension, or, if it contains a '/', against the trailing
+  // components of its path; '*' and '?' are wildcards. The first matching
+  // entry sets the minimum log level of the file to -<verbosity>, so 2
+  // enables BASE_VLOG(2) and -1 keeps only warnings and worse.
+  std::string vmodule;
 };
 
 // Gets the active log settings for the current process.
@@ -31,6 +42,11 @@ LogSettings GetLogSettings();
 // higher than kLogFatal.
 int GetMinLogLevel();
 
+// Gets the minimum log level for code in |file|, a __FILE__ path, taking
+// LogSettings::vmodule into account. Never returns a value higher than
+// kLogFatal.
+int GetMinLogLevelForFile(const char* file);
+
 class ScopedSetLogSettings {
  public:
   explicit ScopedSetLogSettings(const LogSettings& settings);
@@ -3,6 +3,7 @@
 // found in the LICENSE file.
 
 #include "log_settings.h"
+#include "logging.h"
 
 namespace base {
 namespace state {
@@ -10,5 +11,8 @@ namespace state {
 // Declared in log_settings.cc.
 LogSettings g_log_settings;
 
+// Declared in logging.h.
+std::atomic<uint32_t> g_log_settings_generation{1};
+
 }  // namespace state
 }  // namespace base
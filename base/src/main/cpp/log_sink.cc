@@ -0,0 +1,60 @@
+#include "log_sink.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include "string/string_builder.h"
+
+#include <android/log.h>
+
+namespace base {
+
+namespace {
+
+android_LogPriority GetAndroidPriority(LogSeverity severity) {
+  switch (severity) {
+    case kLogInfo:
+      return ANDROID_LOG_INFO;
+    case kLogWarning:
+      return ANDROID_LOG_WARN;
+    case kLogError:
+      return ANDROID_LOG_ERROR;
+    case kLogFatal:
+      return ANDROID_LOG_FATAL;
+  }
+  return (severity < 0) ? ANDROID_LOG_VERBOSE : ANDROID_LOG_UNKNOWN;
+}
+
+class SystemLogSink : public LogSink {
+ public:
+  void Send(const LogRecord& record) override {
+    __android_log_write(GetAndroidPriority(record.severity), "Base",
+                        record.message.data());
+    // Don't use std::cerr here, because it may not be initialized properly
+    // yet.
+    fwrite(record.message.data(), 1, record.message.size(), stderr);
+    fflush(stderr);
+  }
+
+  void SendBatch(const LogRecord* records, size_t count) override {
+    string::StringBuilder text;
+    for (size_t i = 0; i < count; i++) {
+      __android_log_write(GetAndroidPriority(records[i].severity), "Base",
+                          records[i].message.data());
+      const std::string_view message = records[i].message;
+      memcpy(text.AppendUninitialized(message.size()), message.data(),
+             message.size());
+    }
+    fwrite(text.data(), 1, text.size(), stderr);
+    fflush(stderr);
+  }
+};
+
+}  // namespace
+
+LogSink* GetSystemLogSink() {
+  static SystemLogSink* sink = new SystemLogSink();
+  return sink;
+}
+
+}  // namespace base
@@ -0,0 +1,51 @@
+#ifndef LOG_SINK_H_
+#define LOG_SINK_H_
+
+#include <stddef.h>
+
+#include <string_view>
+
+#include "log_level.h"
+
+namespace base {
+
+// A formatted log message. |message| ends in '\n' and is followed by a NUL
+// that it does not count, so sinks can pass |message.data()| to C APIs.
+struct LogRecord {
+  LogSeverity severity;
+  std::string_view message;
+};
+
+// Destination of formatted log messages. Sinks are called from the logging
+// thread, or from the async logging drainer (see async_logging.h), and must
+// be thread-safe.
+class LogSink {
+ public:
+  virtual ~LogSink() = default;
+
+  virtual void Send(const LogRecord& record) = 0;
+
+  // Sends |count| records at once. Sinks that pay per write, such as stderr,
+  // override this to write the batch in one go.
+  virtual void SendBatch(const LogRecord* records, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+      Send(records[i]);
+    }
+  }
+};
+
+// Destination of encoded structured log records (see structured_log.h and
+// binary_log_format.h). Called by the async logging drainer.
+class BinaryLogSink {
+ public:
+  virtual ~BinaryLogSink() = default;
+
+  virtual void SendBatch(const std::string_view* records, size_t count) = 0;
+};
+
+// Writes to logcat, tagged "Base", and to stderr.
+LogSink* GetSystemLogSink();
+
+}  // namespace base
+
+#endif  // LOG_SINK_H_
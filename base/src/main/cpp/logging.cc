@@ -6,11 +6,12 @@
 #include <cstring>
 #include <iostream>
 
+#include "async_logging.h"
 #include "log_level.h"
 #include "log_settings.h"
+#include "log_sink.h"
 #include "logging.h"
-
-#include <android/log.h>
+#include "time/time_point.h"
 
 namespace base {
 
@@ -41,22 +42,28 @@ const char* StripPath(const char* path) {
 }
 }  // namespace
 
+void AppendLogPrefix(LogSeverity severity,
+                     const char* file,
+                     int line,
+                     string::StringBuilder* out) {
+  if (severity >= kLogInfo) {
+    out->Append("[", GetNameForLogSeverity(severity));
+  } else {
+    out->Append("[VERBOSE", -severity);
+  }
+  out->Append(":", severity > kLogInfo ? StripDots(file) : StripPath(file),
+              "(", line, ")] ");
+}
+
 LogMessage::LogMessage(LogSeverity severity,
                        const char* file,
                        int line,
                        const char* condition)
-    : severity_(severity), file_(file), line_(line) {
-  stream_ << "[";
-  if (severity >= kLogInfo) {
-    stream_ << GetNameForLogSeverity(severity);
-  } else {
-    stream_ << "VERBOSE" << -severity;
-  }
-  stream_ << ":" << (severity > kLogInfo ? StripDots(file_) : StripPath(file_))
-          << "(" << line_ << ")] ";
+    : stream_(&buffer_), severity_(severity), file_(file), line_(line) {
+  AppendLogPrefix(severity, file, line, &buffer_);
 
   if (condition) {
-    stream_ << "Check failed: " << condition << ". ";
+    buffer_.Append("Check failed: ", condition, ". ");
   }
 }
 
@@ -85,32 +92,24 @@ void LogMessage::CaptureNextLog(std::ostringstream* stream) {
 }
 
 LogMessage::~LogMessage() {
-  stream_ << std::endl;
+  buffer_.push_back('\n');
+  // Terminated for the sinks' C string APIs, but not counted in message.
+  buffer_.push_back('\0');
+  const std::string_view message(buffer_.data(), buffer_.size() - 1);
 
   if (capture_next_log_stream_) {
-    *capture_next_log_stream_ << stream_.str();
+    capture_next_log_stream_->write(message.data(), message.size());
     capture_next_log_stream_ = nullptr;
   } else {
-    android_LogPriority priority =
-        (severity_ < 0) ? ANDROID_LOG_VERBOSE : ANDROID_LOG_UNKNOWN;
-    switch (severity_) {
-      case kLogInfo:
-        priority = ANDROID_LOG_INFO;
-        break;
-      case kLogWarning:
-        priority = ANDROID_LOG_WARN;
-        break;
-      case kLogError:
-        priority = ANDROID_LOG_ERROR;
-        break;
-      case kLogFatal:
-        priority = ANDROID_LOG_FATAL;
-        break;
+    const LogRecord record = {severity_, message};
+    if (severity_ >= kLogFatal) {
+      // Everything queued before this message goes out first, and this one
+      // is written before the process dies rather than left in a buffer.
+      FlushAsyncLogging();
+      GetActiveLogSink()->Send(record);
+    } else if (!SendToAsyncLog(record)) {
+      GetSystemLogSink()->Send(record);
     }
-    __android_log_write(priority, "Base", stream_.str().c_str());
-    // Don't use std::cerr here, because it may not be initialized properly yet.
-    fprintf(stderr, "%s", stream_.str().c_str());
-    fflush(stderr);
   }
 
   if (severity_ >= kLogFatal) {
@@ -126,6 +125,28 @@ bool ShouldCreateLogMessage(LogSeverity severity) {
   return severity >= GetMinLogLevel();
 }
 
+int LogSite::Update() {
+  // Read before the settings, so that a change racing with this lookup
+  // leaves a stale generation behind rather than a stale level.
+  const uint32_t generation =
+      state::g_log_settings_generation.load(std::memory_order_acquire);
+  const int level = GetMinLogLevelForFile(file_);
+  cached_.store((uint64_t{generation} << 32) | static_cast<uint32_t>(level),
+                std::memory_order_relaxed);
+  return level;
+}
+
+bool LogEveryPeriodState::ShouldLog(TimeDelta period) {
+  const int64_t now = TimePoint::Now().ToEpochDelta().ToNanoseconds();
+  int64_t next = next_ticks_.load(std::memory_order_relaxed);
+  if (now < next) {
+    return false;
+  }
+  // Of the threads that get here at once, only the first logs.
+  return next_ticks_.compare_exchange_strong(next, now + period.ToNanoseconds(),
+                                             std::memory_order_relaxed);
+}
+
 void KillProcess() {
   abort();
 }
@@ -1,10 +1,15 @@
 #ifndef LOGGING_H_
 #define LOGGING_H_
 
+#include <stdint.h>
+
+#include <atomic>
 #include <sstream>
 
 #include "log_level.h"
 #include "macros.h"
+#include "string/string_builder.h"
+#include "time/time_delta.h"
 
 namespace base {
 
@@ -41,7 +46,10 @@ class LogMessage {
   // This is a raw pointer so that we avoid having a non-trivially-destructible
   // static. It is only ever for use in unit tests.
   static thread_local std::ostringstream* capture_next_log_stream_;
-  std::ostringstream stream_;
+  // The message is assembled in buffer_, which short messages fit in without
+  // allocating; stream_ appends to it.
+  string::StringBuilder buffer_;
+  string::StringBuilderStream stream_;
   const LogSeverity severity_;
   const char* file_;
   const int line_;
@@ -49,13 +57,88 @@ class LogMessage {
   BASE_DISALLOW_COPY_AND_ASSIGN(LogMessage);
 };
 
-// Gets the BASE_VLOG default verbosity level.
+// Appends the "[SEVERITY:file(line)] " prefix that LogMessage starts each
+// message with.
+void AppendLogPrefix(LogSeverity severity,
+                     const char* file,
+                     int line,
+                     string::StringBuilder* out);
+
+// Gets the BASE_VLOG default verbosity level. Ignores LogSettings::vmodule,
+// which the macros apply per call site.
 int GetVlogVerbosity();
 
-// Returns true if |severity| is at or above the current minimum log level.
-// kLogFatal and above is always true.
+// Returns true if |severity| is at or above the current minimum log level,
+// ignoring LogSettings::vmodule. kLogFatal and above is always true.
 bool ShouldCreateLogMessage(LogSeverity severity);
 
+namespace state {
+
+// Bumped by SetLogSettings(). Defined in log_settings_state.cc.
+extern std::atomic<uint32_t> g_log_settings_generation;
+
+}  // namespace state
+
+// The minimum log level of one logging call site, which depends on its file
+// (see LogSettings::vmodule). It is cached until the log settings change, so
+// checking it costs two relaxed loads. Sites are constant-initialized, so
+// they need no initialization guard either.
+class LogSite {
+ public:
+  constexpr explicit LogSite(const char* file) : file_(file) {}
+
+  int min_log_level() {
+    const uint64_t cached = cached_.load(std::memory_order_relaxed);
+    if (static_cast<uint32_t>(cached >> 32) ==
+        state::g_log_settings_generation.load(std::memory_order_relaxed)) {
+      return static_cast<int32_t>(static_cast<uint32_t>(cached));
+    }
+    return Update();
+  }
+
+ private:
+  int Update();
+
+  const char* const file_;
+  // The settings generation the level was looked up in, in the high half,
+  // and the level in the low half. Generation 0 is never current.
+  std::atomic<uint64_t> cached_{0};
+};
+
+// Call site state of BASE_LOG_EVERY_N.
+class LogEveryNState {
+ public:
+  bool ShouldLog(uint32_t n) {
+    return n <= 1 || count_.fetch_add(1, std::memory_order_relaxed) % n == 0;
+  }
+
+ private:
+  std::atomic<uint32_t> count_{0};
+};
+
+// Call site state of BASE_LOG_FIRST_N.
+class LogFirstNState {
+ public:
+  bool ShouldLog(uint32_t n) {
+    // Stops counting once past |n|, so the count cannot wrap around.
+    return count_.load(std::memory_order_relaxed) < n &&
+           count_.fetch_add(1, std::memory_order_relaxed) < n;
+  }
+
+ private:
+  std::atomic<uint32_t> count_{0};
+};
+
+// Call site state of BASE_LOG_EVERY_PERIOD.
+class LogEveryPeriodState {
+ public:
+  bool ShouldLog(TimeDelta period);
+
+ private:
+  // TimePoint ticks before which the site stays quiet.
+  std::atomic<int64_t> next_ticks_{INT64_MIN};
+};
+
 [[noreturn]] void KillProcess();
 
 }  // namespace base
@@ -72,12 +155,46 @@ bool ShouldCreateLogMessage(LogSeverity severity);
       : ::base::LogMessageVoidify() &       \
             ::base::LogMessage(::base::kLogFatal, 0, 0, nullptr).stream()
 
+// Evaluates to a |type| object of the call site, constructed from the
+// remaining arguments the first time the site runs.
+#define BASE_LOG_CALL_SITE_STATIC(type, ...)            \
+  ([]() -> type& {                                      \
+    static type base_log_call_site_static{__VA_ARGS__}; \
+    return base_log_call_site_static;                   \
+  }())
+
 #define BASE_LOG_IS_ON(severity) \
-  (::base::ShouldCreateLogMessage(::base::LOG_##severity))
+  (::base::LOG_##severity >=     \
+   BASE_LOG_CALL_SITE_STATIC(::base::LogSite, __FILE__).min_log_level())
 
 #define BASE_LOG(severity) \
   BASE_LAZY_STREAM(BASE_LOG_STREAM(severity), BASE_LOG_IS_ON(severity))
 
+// Logs the 1st, (n+1)th, (2n+1)th... time the statement runs with logging
+// on.
+#define BASE_LOG_EVERY_N(severity, n)                                    \
+  BASE_LAZY_STREAM(                                                      \
+      BASE_LOG_STREAM(severity),                                         \
+      BASE_LOG_IS_ON(severity) &&                                        \
+          BASE_LOG_CALL_SITE_STATIC(::base::LogEveryNState).ShouldLog(n))
+
+// Logs the first n times the statement runs with logging on.
+#define BASE_LOG_FIRST_N(severity, n)                                    \
+  BASE_LAZY_STREAM(                                                      \
+      BASE_LOG_STREAM(severity),                                         \
+      BASE_LOG_IS_ON(severity) &&                                        \
+          BASE_LOG_CALL_SITE_STATIC(::base::LogFirstNState).ShouldLog(n))
+
+// Logs at most once per |period|, a TimeDelta, and drops the messages in
+// between. For statements that can run in a tight loop, such as per request
+// logging.
+#define BASE_LOG_EVERY_PERIOD(severity, period)                       \
+  BASE_LAZY_STREAM(                                                   \
+      BASE_LOG_STREAM(severity),                                      \
+      BASE_LOG_IS_ON(severity) &&                                     \
+          BASE_LOG_CALL_SITE_STATIC(::base::LogEveryPeriodState)      \
+              .ShouldLog(period))
+
 #define BASE_CHECK(condition)                                              \
   BASE_LAZY_STREAM(                                                        \
       ::base::LogMessage(::base::kLogFatal, __FILE__, __LINE__, #condition) \
@@ -85,7 +202,8 @@ bool ShouldCreateLogMessage(LogSeverity severity);
       !(condition))
 
 #define BASE_VLOG_IS_ON(verbose_level) \
-  ((verbose_level) <= ::base::GetVlogVerbosity())
+  (-(verbose_level) >=                 \
+   BASE_LOG_CALL_SITE_STATIC(::base::LogSite, __FILE__).min_log_level())
 
 // The VLOG macros log with negative verbosities.
 #define BASE_VLOG_STREAM(verbose_level) \
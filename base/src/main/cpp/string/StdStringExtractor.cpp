@@ -1,22 +1,66 @@
 #include "StdStringExtractor.h"
 
+#include <ctype.h>
 #include <stdlib.h>
+#include <string.h>
 
-static inline int xdigit_to_sint(char ch) {
-  if (ch >= 'a' && ch <= 'f') return 10 + ch - 'a';
-  if (ch >= 'A' && ch <= 'F') return 10 + ch - 'A';
-  if (ch >= '0' && ch <= '9') return ch - '0';
-  return -1;
+#include <algorithm>
+#include <charconv>
+
+#include "../hex.h"
+
+namespace {
+
+struct HexTable {
+  // The value of each hex digit, 0xFF for any other character.
+  uint8_t values[256];
+};
+
+constexpr HexTable MakeHexTable() {
+  HexTable table{};
+  for (int i = 0; i < 256; i++) table.values[i] = 0xFF;
+  for (int i = 0; i < 10; i++) table.values['0' + i] = i;
+  for (int i = 0; i < 6; i++) {
+    table.values['a' + i] = 10 + i;
+    table.values['A' + i] = 10 + i;
+  }
+  return table;
 }
 
+constexpr HexTable kHexTable = MakeHexTable();
+
+inline uint8_t xdigit_value(char ch) {
+  return kHexTable.values[static_cast<uint8_t>(ch)];
+}
+
+inline bool is_xdigit(char ch) { return xdigit_value(ch) != 0xFF; }
+
+// Converts the magnitude and sign of a parsed integer to int64_t, saturating
+// like strtoll().
+int64_t ToSigned(uint64_t magnitude, bool negative) {
+  if (negative) {
+    return magnitude > static_cast<uint64_t>(INT64_MAX)
+               ? INT64_MIN
+               : -static_cast<int64_t>(magnitude);
+  }
+  return magnitude > static_cast<uint64_t>(INT64_MAX)
+             ? INT64_MAX
+             : static_cast<int64_t>(magnitude);
+}
+
+}  // namespace
+
 // StdStringExtractor constructor
 StdStringExtractor::StdStringExtractor() : m_packet(), m_index(0) {}
 
 StdStringExtractor::StdStringExtractor(const char *packet_cstr)
     : m_packet(), m_index(0) {
-  if (packet_cstr) m_packet.assign(packet_cstr);
+  if (packet_cstr) m_packet = packet_cstr;
 }
 
+StdStringExtractor::StdStringExtractor(std::string_view packet)
+    : m_packet(packet), m_index(0) {}
+
 // Destructor
 StdStringExtractor::~StdStringExtractor() {}
 
@@ -41,9 +85,9 @@ int StdStringExtractor::DecodeHexU8() {
   if (GetBytesLeft() < 2) {
     return -1;
   }
-  const int hi_nibble = xdigit_to_sint(m_packet[m_index]);
-  const int lo_nibble = xdigit_to_sint(m_packet[m_index + 1]);
-  if (hi_nibble == -1 || lo_nibble == -1) {
+  const uint8_t hi_nibble = xdigit_value(m_packet[m_index]);
+  const uint8_t lo_nibble = xdigit_value(m_packet[m_index + 1]);
+  if ((hi_nibble | lo_nibble) == 0xFF) {
     return -1;
   }
   m_index += 2;
@@ -70,46 +114,54 @@ bool StdStringExtractor::GetHexU8Ex(uint8_t &ch, bool set_eof_on_fail) {
   return true;
 }
 
-uint32_t StdStringExtractor::GetU32(uint32_t fail_value, int base) {
-  if (m_index < m_packet.size()) {
-    char *end = nullptr;
-    const char *start = m_packet.c_str();
-    const char *cstr = start + m_index;
-    uint32_t result = static_cast<uint32_t>(::strtoul(cstr, &end, base));
-
-    if (end && end != cstr) {
-      m_index = end - start;
-      return result;
-    }
+size_t StdStringExtractor::ParseInteger(int base, uint64_t &magnitude,
+                                        bool &negative, bool &overflow) const {
+  const char *begin = m_packet.data();
+  const char *end = begin + m_packet.size();
+  const char *p = begin + m_index;
+  while (p < end && isspace(static_cast<unsigned char>(*p))) ++p;
+  negative = false;
+  if (p < end && (*p == '+' || *p == '-')) {
+    negative = *p == '-';
+    ++p;
   }
-  return fail_value;
+  // Like strtoull(), "0x" only counts as a prefix if a hex digit follows;
+  // otherwise the number is the "0".
+  if ((base == 0 || base == 16) && end - p >= 3 && p[0] == '0' &&
+      (p[1] == 'x' || p[1] == 'X') && is_xdigit(p[2])) {
+    p += 2;
+    base = 16;
+  } else if (base == 0) {
+    base = (p < end && *p == '0') ? 8 : 10;
+  }
+  if (base < 2 || base > 36) return 0;
+  magnitude = 0;
+  const std::from_chars_result result =
+      std::from_chars(p, end, magnitude, base);
+  if (result.ptr == p) return 0;
+  overflow = result.ec == std::errc::result_out_of_range;
+  if (overflow) magnitude = UINT64_MAX;
+  return result.ptr - begin;
+}
+
+uint32_t StdStringExtractor::GetU32(uint32_t fail_value, int base) {
+  return static_cast<uint32_t>(GetU64(fail_value, base));
 }
 
 int32_t StdStringExtractor::GetS32(int32_t fail_value, int base) {
-  if (m_index < m_packet.size()) {
-    char *end = nullptr;
-    const char *start = m_packet.c_str();
-    const char *cstr = start + m_index;
-    int32_t result = static_cast<int32_t>(::strtol(cstr, &end, base));
-
-    if (end && end != cstr) {
-      m_index = end - start;
-      return result;
-    }
-  }
-  return fail_value;
+  return static_cast<int32_t>(GetS64(fail_value, base));
 }
 
 uint64_t StdStringExtractor::GetU64(uint64_t fail_value, int base) {
   if (m_index < m_packet.size()) {
-    char *end = nullptr;
-    const char *start = m_packet.c_str();
-    const char *cstr = start + m_index;
-    uint64_t result = ::strtoull(cstr, &end, base);
-
-    if (end && end != cstr) {
-      m_index = end - start;
-      return result;
+    uint64_t magnitude;
+    bool negative;
+    bool overflow;
+    const size_t end = ParseInteger(base, magnitude, negative, overflow);
+    if (end) {
+      m_index = end;
+      // Like strtoull(), a '-' negates the value unless it overflowed.
+      return negative && !overflow ? 0 - magnitude : magnitude;
     }
   }
   return fail_value;
@@ -117,14 +169,13 @@ uint64_t StdStringExtractor::GetU64(uint64_t fail_value, int base) {
 
 int64_t StdStringExtractor::GetS64(int64_t fail_value, int base) {
   if (m_index < m_packet.size()) {
-    char *end = nullptr;
-    const char *start = m_packet.c_str();
-    const char *cstr = start + m_index;
-    int64_t result = ::strtoll(cstr, &end, base);
-
-    if (end && end != cstr) {
-      m_index = end - start;
-      return result;
+    uint64_t magnitude;
+    bool negative;
+    bool overflow;
+    const size_t end = ParseInteger(base, magnitude, negative, overflow);
+    if (end) {
+      m_index = end;
+      return ToSigned(magnitude, negative);
     }
   }
   return fail_value;
@@ -138,7 +189,7 @@ uint32_t StdStringExtractor::GetHexMaxU32(bool little_endian,
   SkipSpaces();
   if (little_endian) {
     uint32_t shift_amount = 0;
-    while (m_index < m_packet.size() && ::isxdigit(m_packet[m_index])) {
+    while (m_index < m_packet.size() && is_xdigit(m_packet[m_index])) {
       // Make sure we don't exceed the size of a uint32_t...
       if (nibble_count >= (sizeof(uint32_t) * 2)) {
         m_index = UINT64_MAX;
@@ -146,10 +197,10 @@ uint32_t StdStringExtractor::GetHexMaxU32(bool little_endian,
       }
 
       uint8_t nibble_lo;
-      uint8_t nibble_hi = xdigit_to_sint(m_packet[m_index]);
+      uint8_t nibble_hi = xdigit_value(m_packet[m_index]);
       ++m_index;
-      if (m_index < m_packet.size() && ::isxdigit(m_packet[m_index])) {
-        nibble_lo = xdigit_to_sint(m_packet[m_index]);
+      if (m_index < m_packet.size() && is_xdigit(m_packet[m_index])) {
+        nibble_lo = xdigit_value(m_packet[m_index]);
         ++m_index;
         result |= ((uint32_t)nibble_hi << (shift_amount + 4));
         result |= ((uint32_t)nibble_lo << shift_amount);
@@ -162,14 +213,14 @@ uint32_t StdStringExtractor::GetHexMaxU32(bool little_endian,
       }
     }
   } else {
-    while (m_index < m_packet.size() && ::isxdigit(m_packet[m_index])) {
+    while (m_index < m_packet.size() && is_xdigit(m_packet[m_index])) {
       // Make sure we don't exceed the size of a uint32_t...
       if (nibble_count >= (sizeof(uint32_t) * 2)) {
         m_index = UINT64_MAX;
         return fail_value;
       }
 
-      uint8_t nibble = xdigit_to_sint(m_packet[m_index]);
+      uint8_t nibble = xdigit_value(m_packet[m_index]);
       // Big Endian
       result <<= 4;
       result |= nibble;
@@ -189,7 +240,7 @@ uint64_t StdStringExtractor::GetHexMaxU64(bool little_endian,
   SkipSpaces();
   if (little_endian) {
     uint32_t shift_amount = 0;
-    while (m_index < m_packet.size() && ::isxdigit(m_packet[m_index])) {
+    while (m_index < m_packet.size() && is_xdigit(m_packet[m_index])) {
       // Make sure we don't exceed the size of a uint64_t...
       if (nibble_count >= (sizeof(uint64_t) * 2)) {
         m_index = UINT64_MAX;
@@ -197,10 +248,10 @@ uint64_t StdStringExtractor::GetHexMaxU64(bool little_endian,
       }
 
       uint8_t nibble_lo;
-      uint8_t nibble_hi = xdigit_to_sint(m_packet[m_index]);
+      uint8_t nibble_hi = xdigit_value(m_packet[m_index]);
       ++m_index;
-      if (m_index < m_packet.size() && ::isxdigit(m_packet[m_index])) {
-        nibble_lo = xdigit_to_sint(m_packet[m_index]);
+      if (m_index < m_packet.size() && is_xdigit(m_packet[m_index])) {
+        nibble_lo = xdigit_value(m_packet[m_index]);
         ++m_index;
         result |= ((uint64_t)nibble_hi << (shift_amount + 4));
         result |= ((uint64_t)nibble_lo << shift_amount);
@@ -213,14 +264,14 @@ uint64_t StdStringExtractor::GetHexMaxU64(bool little_endian,
       }
     }
   } else {
-    while (m_index < m_packet.size() && ::isxdigit(m_packet[m_index])) {
+    while (m_index < m_packet.size() && is_xdigit(m_packet[m_index])) {
       // Make sure we don't exceed the size of a uint64_t...
       if (nibble_count >= (sizeof(uint64_t) * 2)) {
         m_index = UINT64_MAX;
         return fail_value;
       }
 
-      uint8_t nibble = xdigit_to_sint(m_packet[m_index]);
+      uint8_t nibble = xdigit_value(m_packet[m_index]);
       // Big Endian
       result <<= 4;
       result |= nibble;
@@ -237,6 +288,11 @@ size_t StdStringExtractor::GetHexBytes(void *dst_void, size_t dst_len,
   uint8_t *dst = (uint8_t *)dst_void;
   size_t bytes_extracted = 0;
   while (bytes_extracted < dst_len && GetBytesLeft()) {
+    // Decode runs of digit pairs in bulk, and only go through GetHexU8() to
+    // skip spaces or fail.
+    bytes_extracted +=
+        DecodeHexPairs(dst + bytes_extracted, dst_len - bytes_extracted);
+    if (bytes_extracted == dst_len || !GetBytesLeft()) break;
     dst[bytes_extracted] = GetHexU8(fail_fill_value);
     if (IsGood())
       ++bytes_extracted;
@@ -257,6 +313,11 @@ size_t StdStringExtractor::GetHexBytesAvail(void *dst_void, size_t dst_len) {
   uint8_t *dst = (uint8_t *)dst_void;
   size_t bytes_extracted = 0;
   while (bytes_extracted < dst_len) {
+    // Decode runs of digit pairs in bulk, and only go through DecodeHexU8()
+    // to skip spaces or stop.
+    bytes_extracted +=
+        DecodeHexPairs(dst + bytes_extracted, dst_len - bytes_extracted);
+    if (bytes_extracted == dst_len) break;
     int decode = DecodeHexU8();
     if (decode == -1) {
       break;
@@ -269,8 +330,7 @@ size_t StdStringExtractor::GetHexBytesAvail(void *dst_void, size_t dst_len) {
 size_t StdStringExtractor::GetHexByteString(std::string &str) {
   str.clear();
   str.reserve(GetBytesLeft() / 2);
-  char ch;
-  while ((ch = GetHexU8()) != '\0') str.append(1, ch);
+  AppendHexByteString(str, true);
   return str.size();
 }
 
@@ -278,7 +338,13 @@ size_t StdStringExtractor::GetHexByteStringFixedLength(std::string &str,
                                                        uint32_t nibble_length) {
   str.clear();
 
-  uint32_t nibble_count = 0;
+  // Every iteration of the loop below appends one byte, even when it fails
+  // to decode one, so the leading run of digit pairs can be done in bulk.
+  const size_t max_bytes = (static_cast<size_t>(nibble_length) + 1) / 2;
+  str.resize(std::min<size_t>(max_bytes, GetBytesLeft() / 2));
+  str.resize(DecodeHexPairs(reinterpret_cast<uint8_t *>(&str[0]), str.size()));
+
+  uint64_t nibble_count = str.size() * 2;
   for (const char *pch = Peek();
        (nibble_count < nibble_length) && (pch != nullptr);
        str.append(1, GetHexU8(0, false)), pch = Peek(), nibble_count += 2) {
@@ -290,14 +356,43 @@ size_t StdStringExtractor::GetHexByteStringFixedLength(std::string &str,
 size_t StdStringExtractor::GetHexByteStringTerminatedBy(std::string &str,
                                                         char terminator) {
   str.clear();
-  char ch;
-  while ((ch = GetHexU8(0, false)) != '\0') str.append(1, ch);
+  AppendHexByteString(str, false);
   if (Peek() && *Peek() == terminator) return str.size();
 
   str.clear();
   return str.size();
 }
 
+size_t StdStringExtractor::DecodeHexPairs(uint8_t *dst, size_t dst_len) {
+  const size_t pairs = std::min<size_t>(dst_len, GetBytesLeft() / 2);
+  if (pairs == 0) return 0;
+  size_t written = 0;
+  base::HexDecodeTo(m_packet.substr(m_index, pairs * 2), dst, &written);
+  m_index += written * 2;
+  return written;
+}
+
+void StdStringExtractor::AppendHexByteString(std::string &str,
+                                             bool set_eof_on_fail) {
+  uint8_t run[256];
+  while (true) {
+    const size_t decoded = DecodeHexPairs(run, sizeof(run));
+    // A "00" pair ends the string, and is consumed like GetHexU8() would.
+    const void *nul = memchr(run, 0, decoded);
+    if (nul != nullptr) {
+      const size_t length = static_cast<const uint8_t *>(nul) - run;
+      m_index -= (decoded - length - 1) * 2;
+      str.append(reinterpret_cast<const char *>(run), length);
+      return;
+    }
+    str.append(reinterpret_cast<const char *>(run), decoded);
+    if (decoded == sizeof(run)) continue;
+    const char ch = GetHexU8(0, set_eof_on_fail);
+    if (ch == '\0') return;
+    str.append(1, ch);
+  }
+}
+
 bool StdStringExtractor::GetNameColonValue(std::string &name,
                                            std::string &value) {
   // Read something in the form of NNNN:VVVV; where NNNN is any character
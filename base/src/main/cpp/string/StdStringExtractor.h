@@ -4,15 +4,21 @@
 #include <stdint.h>
 
 #include <string>
+#include <string_view>
 
 // Based on StringExtractor, with the added limitation that this file should not
 // take a dependency on LLVM, as it is used from debugserver.
+//
+// The extractor is a cursor over borrowed data: it does not copy the packet,
+// which must outlive it. The packet need not be NUL-terminated, so it can be
+// a slice of a larger buffer or of a mapped file.
 class StdStringExtractor {
  public:
   enum { BigEndian = 0, LittleEndian = 1 };
   // Constructors and Destructors
   StdStringExtractor();
   StdStringExtractor(const char *packet_cstr);
+  StdStringExtractor(std::string_view packet);
   virtual ~StdStringExtractor();
 
   // Returns true if the file position is still valid for the data
@@ -24,13 +30,13 @@ class StdStringExtractor {
   void SetFilePos(uint32_t idx) { m_index = idx; }
 
   void Clear() {
-    m_packet.clear();
+    m_packet = std::string_view();
     m_index = 0;
   }
 
   void SkipSpaces();
 
-  const std::string &GetStringRef() const { return m_packet; }
+  std::string_view GetStringRef() const { return m_packet; }
 
   bool Empty() { return m_packet.empty(); }
 
@@ -77,18 +83,37 @@ class StdStringExtractor {
 
   size_t GetHexByteStringTerminatedBy(std::string &str, char terminator);
 
+  // Returns the unread part of the packet, which need not be NUL-terminated.
   const char *Peek() {
-    if (m_index < m_packet.size()) return m_packet.c_str() + m_index;
+    if (m_index < m_packet.size()) return m_packet.data() + m_index;
     return nullptr;
   }
 
  protected:
   // For StdStringExtractor only
-  std::string m_packet;  // The string in which to extract data.
-  uint64_t m_index;      // When extracting data from a packet, this index
-                         // will march along as things get extracted. If set
-                         // to UINT64_MAX the end of the packet data was
-                         // reached when decoding information
+  std::string_view m_packet;  // The string in which to extract data.
+  uint64_t m_index;  // When extracting data from a packet, this index
+                     // will march along as things get extracted. If set
+                     // to UINT64_MAX the end of the packet data was
+                     // reached when decoding information
+
+ private:
+  // Parses an integer at the current position the way strtoull() does
+  // (leading spaces, a sign, and a base prefix when base is 0 or 16), but
+  // bounded by the packet size and without the locale. Sets magnitude to the
+  // value without its sign, saturated on overflow. Returns the index after
+  // the digits, or 0 if there are none.
+  size_t ParseInteger(int base, uint64_t &magnitude, bool &negative,
+                      bool &overflow) const;
+
+  // Decodes the run of hex digit pairs at the current position into at most
+  // dst_len bytes of dst, without skipping spaces, and moves past it. Returns
+  // the number of bytes decoded.
+  size_t DecodeHexPairs(uint8_t *dst, size_t dst_len);
+
+  // Appends bytes to str like calling GetHexU8(0, set_eof_on_fail) until it
+  // returns 0, which a "00" pair or a failure to decode does.
+  void AppendHexByteString(std::string &str, bool set_eof_on_fail);
 };
 
 #endif  // STD_STRIN_GEXTRACTOR_H
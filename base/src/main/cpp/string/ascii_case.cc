@@ -0,0 +1,198 @@
+#include "ascii_case.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <functional>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define ASCII_CASE_SSE2 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define ASCII_CASE_NEON 1
+#endif
+
+namespace base {
+namespace string {
+
+namespace {
+
+// Unlike hex.cc these kernels are chosen at compile time: the strings are
+// mostly shorter than a cache line, so an indirect call would cost more than
+// the AVX2 width could save. SSE2 is part of every x86-64 and Android x86 ABI.
+
+constexpr size_t kBlock = 16;
+
+inline char LowerByte(char c) {
+  return (c >= 'A' && c <= 'Z') ? static_cast<char>(c | 0x20) : c;
+}
+
+inline uint64_t LoadWord(const char* p) {
+  uint64_t word;
+  memcpy(&word, p, sizeof(word));
+  return word;
+}
+
+inline void StoreWord(char* p, uint64_t word) {
+  memcpy(p, &word, sizeof(word));
+}
+
+// Folds the 8 bytes of |word| at once. The high bit of each byte is cleared
+// first so that the additions below cannot carry into the next byte; it then
+// tells whether the byte was ASCII at all.
+inline uint64_t LowerWord(uint64_t word) {
+  constexpr uint64_t kOnes = 0x0101010101010101;
+  constexpr uint64_t kHighBits = 0x8080808080808080;
+  const uint64_t low7 = word & ~kHighBits;
+  const uint64_t from_a = low7 + kOnes * (0x80 - 'A');
+  const uint64_t above_z = low7 + kOnes * (0x7F - 'Z');
+  const uint64_t upper = (from_a ^ above_z) & ~word & kHighBits;
+  return word | (upper >> 2);
+}
+
+#if defined(ASCII_CASE_SSE2)
+
+// SSE2 only compares signed bytes, so 'A'..'Z' are first moved to the bottom
+// of the signed range, where a single compare picks them out.
+inline __m128i LowerBlock(__m128i chars) {
+  const __m128i shifted =
+      _mm_add_epi8(chars, _mm_set1_epi8(static_cast<char>(0x80 - 'A')));
+  const __m128i upper =
+      _mm_cmplt_epi8(shifted, _mm_set1_epi8(static_cast<char>(0x80 + 26)));
+  return _mm_or_si128(chars, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+}
+
+inline void LowerBlockTo(const char* src, char* dst) {
+  const __m128i chars =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), LowerBlock(chars));
+}
+
+inline bool BlocksEqual(const char* a, const char* b) {
+  const __m128i lower_a =
+      LowerBlock(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a)));
+  const __m128i lower_b =
+      LowerBlock(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b)));
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(lower_a, lower_b)) == 0xFFFF;
+}
+
+#elif defined(ASCII_CASE_NEON)
+
+inline uint8x16_t LowerBlock(uint8x16_t chars) {
+  const uint8x16_t upper =
+      vcleq_u8(vsubq_u8(chars, vdupq_n_u8('A')), vdupq_n_u8('Z' - 'A'));
+  return vorrq_u8(chars, vandq_u8(upper, vdupq_n_u8(0x20)));
+}
+
+inline void LowerBlockTo(const char* src, char* dst) {
+  const uint8x16_t chars = vld1q_u8(reinterpret_cast<const uint8_t*>(src));
+  vst1q_u8(reinterpret_cast<uint8_t*>(dst), LowerBlock(chars));
+}
+
+inline bool BlocksEqual(const char* a, const char* b) {
+  const uint8x16_t lower_a =
+      LowerBlock(vld1q_u8(reinterpret_cast<const uint8_t*>(a)));
+  const uint8x16_t lower_b =
+      LowerBlock(vld1q_u8(reinterpret_cast<const uint8_t*>(b)));
+  return vminvq_u8(vceqq_u8(lower_a, lower_b)) == 0xFF;
+}
+
+#else
+
+inline void LowerBlockTo(const char* src, char* dst) {
+  const uint64_t first = LoadWord(src);
+  const uint64_t second = LoadWord(src + 8);
+  StoreWord(dst, LowerWord(first));
+  StoreWord(dst + 8, LowerWord(second));
+}
+
+inline bool BlocksEqual(const char* a, const char* b) {
+  return LowerWord(LoadWord(a)) == LowerWord(LoadWord(b)) &&
+         LowerWord(LoadWord(a + 8)) == LowerWord(LoadWord(b + 8));
+}
+
+#endif
+
+inline bool WordsEqual(const char* a, const char* b) {
+  return LowerWord(LoadWord(a)) == LowerWord(LoadWord(b));
+}
+
+}  // namespace
+
+// Past the first block or word, the last one is taken to end exactly at the
+// end of the string, overlapping bytes already done; folding is idempotent,
+// so this also holds when |src| and |dst| are the same buffer.
+void AsciiToLower(const char* src, size_t size, char* dst) {
+  if (size >= kBlock) {
+    size_t i = 0;
+    for (; i + kBlock <= size; i += kBlock) {
+      LowerBlockTo(src + i, dst + i);
+    }
+    if (i < size) {
+      LowerBlockTo(src + size - kBlock, dst + size - kBlock);
+    }
+  } else if (size >= 8) {
+    // Both words are loaded before either is stored, in case src == dst.
+    const uint64_t first = LoadWord(src);
+    const uint64_t last = LoadWord(src + size - 8);
+    StoreWord(dst, LowerWord(first));
+    StoreWord(dst + size - 8, LowerWord(last));
+  } else {
+    for (size_t i = 0; i < size; i++) {
+      dst[i] = LowerByte(src[i]);
+    }
+  }
+}
+
+std::string AsciiToLower(std::string_view s) {
+  std::string result(s.size(), '\0');
+  AsciiToLower(s.data(), s.size(), &result[0]);
+  return result;
+}
+
+bool EqualsIgnoreAsciiCase(std::string_view a, std::string_view b) {
+  const size_t size = a.size();
+  if (size != b.size()) {
+    return false;
+  }
+  const char* pa = a.data();
+  const char* pb = b.data();
+  if (size >= kBlock) {
+    size_t i = 0;
+    for (; i + kBlock <= size; i += kBlock) {
+      if (!BlocksEqual(pa + i, pb + i)) {
+        return false;
+      }
+    }
+    return i == size || BlocksEqual(pa + size - kBlock, pb + size - kBlock);
+  }
+  if (size >= 8) {
+    return WordsEqual(pa, pb) && WordsEqual(pa + size - 8, pb + size - 8);
+  }
+  for (size_t i = 0; i < size; i++) {
+    if (LowerByte(pa[i]) != LowerByte(pb[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+size_t HashIgnoreAsciiCase(std::string_view s) {
+  // Folds into a stack buffer a chunk at a time; a header name almost always
+  // fits in one.
+  constexpr size_t kChunk = 64;
+  char chunk[kChunk];
+  size_t hash = 0;
+  do {
+    const size_t size = s.size() < kChunk ? s.size() : kChunk;
+    AsciiToLower(s.data(), size, chunk);
+    hash = hash * 31 + std::hash<std::string_view>()(
+                           std::string_view(chunk, size));
+    s.remove_prefix(size);
+  } while (!s.empty());
+  return hash;
+}
+
+}  // namespace string
+}  // namespace base
@@ -0,0 +1,34 @@
+#ifndef STRING_ASCII_CASE_H_
+#define STRING_ASCII_CASE_H_
+
+#include <stddef.h>
+
+#include <string>
+#include <string_view>
+
+namespace base {
+namespace string {
+
+/// ASCII case folding for protocol tokens such as HTTP header names. Only
+/// 'A' to 'Z' are folded; every other byte, including non-ASCII ones, is left
+/// as is. Runs of 16 bytes are folded per step with SSE2 or NEON and shorter
+/// tails 8 bytes at a time, so the short strings these are meant for rarely
+/// take a byte loop.
+
+/// Writes `size` bytes of `src` to `dst` with upper case letters folded to
+/// lower case. `src` and `dst` may be the same buffer.
+void AsciiToLower(const char* src, size_t size, char* dst);
+
+std::string AsciiToLower(std::string_view s);
+
+/// Whether `a` and `b` are equal once folded to lower case.
+bool EqualsIgnoreAsciiCase(std::string_view a, std::string_view b);
+
+/// Hash of `s` folded to lower case, so that strings for which
+/// EqualsIgnoreAsciiCase() holds hash alike. Does not allocate.
+size_t HashIgnoreAsciiCase(std::string_view s);
+
+}  // namespace string
+}  // namespace base
+
+#endif  // STRING_ASCII_CASE_H_
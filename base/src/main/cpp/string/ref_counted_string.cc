@@ -3,22 +3,23 @@
 #include <cstring>
 #include <new>
 
+#include "string_intern_pool.h"
+
 namespace base {
 namespace string {
 
 RefCountedString& RefCountedString::operator=(
     const RefCountedString& other) noexcept {
-  if (other.data_) other.header().IncrementReferenceCount();
-  if (data_) header().DecrementReferenceCount();
-  data_ = other.data_;
+  if (other.on_heap()) other.header().IncrementReferenceCount();
+  if (on_heap()) header().DecrementReferenceCount();
+  memcpy(rep_, other.rep_, sizeof(rep_));
   return *this;
 }
 
 RefCountedString& RefCountedString::operator=(std::string_view s) {
-  auto* data = AllocateCopy(s);
-  if (data_) header().DecrementReferenceCount();
-  data_ = data;
-  return *this;
+  // s may point into this string.
+  RefCountedString copy(s);
+  return *this = std::move(copy);
 }
 
 RefCountedString& RefCountedString::operator=(const char* s) {
@@ -39,8 +40,42 @@ const char* RefCountedString::AllocateCopy(std::string_view s) {
   return data;
 }
 
+const char* RefCountedString::AllocateInterned(std::string_view s,
+                                               StringInternPool* pool,
+                                               size_t hash) {
+  void* ptr =
+      ::operator new(sizeof(InternedPrefix) + sizeof(Header) + s.size());
+  auto* prefix = new (ptr) InternedPrefix{pool, hash};
+  auto* header =
+      new (prefix + 1) Header{s.size() | Header::kInternedFlag};
+  char* data = reinterpret_cast<char*>(header + 1);
+  std::memcpy(data, s.data(), s.size());
+  return data;
+}
+
+bool RefCountedString::TryAddReference(const char* data) {
+  const Header& header = reinterpret_cast<const Header*>(data)[-1];
+  size_t count = header.ref_count.load(std::memory_order_relaxed);
+  while (count != 0) {
+    if (header.ref_count.compare_exchange_weak(count, count + 1,
+                                               std::memory_order_relaxed)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 void RefCountedString::Header::Deallocate() const {
-  ::operator delete(const_cast<Header*>(this), length + sizeof(Header));
+  if (!interned()) {
+    ::operator delete(const_cast<Header*>(this), length + sizeof(Header));
+    return;
+  }
+  const auto* prefix = reinterpret_cast<const InternedPrefix*>(this) - 1;
+  prefix->pool->Release(
+      std::string_view(reinterpret_cast<const char*>(this + 1), size()),
+      prefix->hash);
+  ::operator delete(const_cast<InternedPrefix*>(prefix),
+                    sizeof(InternedPrefix) + sizeof(Header) + size());
 }
 
 }  // namespace string
@@ -3,6 +3,7 @@
 
 #include <assert.h>
 #include <stddef.h>
+#include <string.h>
 
 #include <atomic>
 #include <new>
@@ -12,33 +13,50 @@
 namespace base {
 namespace string {
 
+class StringInternPool;
+
 /// Reference-counted immutable string.
 ///
-/// This is the size of a single pointer, and requires only a single heap
-/// allocation.
+/// Strings of up to kInlineCapacity characters are stored in the object
+/// itself, which is two pointers in size. Longer ones take a single heap
+/// allocation shared by all copies. Interned strings are always on the heap,
+/// so that the pool can hand out the same copy.
+///
+/// data() of an inline string points into the object, so it does not
+/// outlive the object or survive moving it.
 class RefCountedString {
  public:
-  RefCountedString() : data_(nullptr) {}
-  RefCountedString(std::string_view s) : data_(AllocateCopy(s)) {}
+  static constexpr size_t kInlineCapacity = 15;
+
+  RefCountedString() = default;
+  RefCountedString(std::string_view s) {
+    if (s.size() <= kInlineCapacity) {
+      SetInline(s.data(), s.size());
+    } else {
+      SetHeap(AllocateCopy(s));
+    }
+  }
   RefCountedString(const char* s) : RefCountedString(std::string_view(s)) {}
 
-  RefCountedString(const RefCountedString& other) noexcept
-      : data_(other.data_) {
-    if (data_) {
+  RefCountedString(const RefCountedString& other) noexcept {
+    memcpy(rep_, other.rep_, sizeof(rep_));
+    if (on_heap()) {
       header().IncrementReferenceCount();
     }
   }
 
-  RefCountedString(RefCountedString&& other) noexcept : data_(other.data_) {
-    other.data_ = nullptr;
+  RefCountedString(RefCountedString&& other) noexcept {
+    memcpy(rep_, other.rep_, sizeof(rep_));
+    other.rep_[kInlineCapacity] = 0;
   }
 
   RefCountedString& operator=(const RefCountedString& other) noexcept;
 
   RefCountedString& operator=(RefCountedString&& other) noexcept {
-    auto temp = other.data_;
-    other.data_ = data_;
-    data_ = temp;
+    char temp[sizeof(rep_)];
+    memcpy(temp, other.rep_, sizeof(rep_));
+    memcpy(other.rep_, rep_, sizeof(rep_));
+    memcpy(rep_, temp, sizeof(rep_));
     return *this;
   }
 
@@ -46,21 +64,28 @@ class RefCountedString {
   RefCountedString& operator=(const char* s);
 
   ~RefCountedString() {
-    if (!data_) return;
+    if (!on_heap()) return;
     header().DecrementReferenceCount();
   }
 
-  bool empty() const { return data_ == nullptr; }
-  const char* data() const { return data_; }
-  size_t size() const { return data_ ? header().length : 0; }
+  bool empty() const { return size() == 0; }
+  const char* data() const { return on_heap() ? heap_data() : rep_; }
+  size_t size() const { return on_heap() ? header().size() : tag(); }
+
+  /// Whether the characters are stored in the object rather than on the
+  /// heap.
+  bool inlined() const { return !on_heap(); }
+
+  /// Whether this string was handed out by a StringInternPool.
+  bool interned() const { return on_heap() && header().interned(); }
 
   char operator[](size_t i) const {
     assert(i <= size());
-    return data_[i];
+    return data()[i];
   }
 
-  const char* begin() const { return data_; }
-  const char* end() const { return data_ + size(); }
+  const char* begin() const { return data(); }
+  const char* end() const { return data() + size(); }
 
   /// Implicitly converts to `string_view`, like `std::string`.
   operator std::string_view() const { return std::string_view(data(), size()); }
@@ -72,7 +97,14 @@ class RefCountedString {
   }
 
   friend bool operator==(const RefCountedString& a, const RefCountedString& b) {
-    return a.data_ == b.data_ || std::string_view(a) == std::string_view(b);
+    if (a.on_heap() && b.on_heap()) {
+      if (a.heap_data() == b.heap_data()) return true;
+      // A pool hands out a single copy of each distinct string.
+      if (a.interned() && b.interned() && a.prefix().pool == b.prefix().pool) {
+        return false;
+      }
+    }
+    return std::string_view(a) == std::string_view(b);
   }
 
   friend bool operator<(const RefCountedString& a, const RefCountedString& b) {
@@ -193,16 +225,23 @@ class RefCountedString {
 
   template <typename H>
   friend H AbslHashValue(H h, const RefCountedString& s) {
-    return H::combine_contiguous(std::move(h), s.data_, s.size());
+    return H::combine_contiguous(std::move(h), s.data(), s.size());
   }
 
  private:
   friend class RefCountedStringWriter;
+  friend class StringInternPool;
 
   struct Header {
+    // Set in `length` for strings owned by a StringInternPool.
+    static constexpr size_t kInternedFlag = ~(~size_t{0} >> 1);
+
     size_t length;
     mutable std::atomic<size_t> ref_count{1};
 
+    size_t size() const { return length & ~kInternedFlag; }
+    bool interned() const { return (length & kInternedFlag) != 0; }
+
     void IncrementReferenceCount() const {
       ref_count.fetch_add(1, std::memory_order_relaxed);
     }
@@ -216,21 +255,74 @@ class RefCountedString {
     void Deallocate() const;
   };
 
+  // Interned strings are allocated with this in front of their Header.
+  struct InternedPrefix {
+    StringInternPool* pool;
+    size_t hash;
+  };
+  static_assert(sizeof(InternedPrefix) % alignof(Header) == 0);
+
+  // Takes over a reference to heap data that the caller already holds.
+  struct AdoptTag {};
+  RefCountedString(const char* data, AdoptTag) { SetHeap(data); }
+
   static char* Allocate(size_t size);
   static const char* AllocateCopy(std::string_view s);
+  static const char* AllocateInterned(std::string_view s,
+                                      StringInternPool* pool,
+                                      size_t hash);
+
+  // Adds a reference to `data` unless its last one is already gone.
+  static bool TryAddReference(const char* data);
+
+  // The last byte of rep_ holds the size of an inline string, or kHeapTag
+  // when the first bytes hold a pointer to heap data.
+  static constexpr unsigned char kHeapTag = 0xFF;
+
+  unsigned char tag() const {
+    return static_cast<unsigned char>(rep_[kInlineCapacity]);
+  }
+  bool on_heap() const { return tag() == kHeapTag; }
+
+  const char* heap_data() const {
+    const char* data;
+    memcpy(&data, rep_, sizeof(data));
+    return data;
+  }
+
+  void SetHeap(const char* data) {
+    memcpy(rep_, &data, sizeof(data));
+    rep_[kInlineCapacity] = static_cast<char>(kHeapTag);
+  }
+
+  // Makes this an inline string of `size` characters, copying `data` if it
+  // is not nullptr.
+  void SetInline(const char* data, size_t size) {
+    if (data) memcpy(rep_, data, size);
+    rep_[kInlineCapacity] = static_cast<char>(size);
+  }
 
   const Header& header() const {
-    return reinterpret_cast<const Header*>(data_)[-1];
+    return reinterpret_cast<const Header*>(heap_data())[-1];
   }
 
-  const char* data_;
+  const InternedPrefix& prefix() const {
+    return reinterpret_cast<const InternedPrefix*>(&header())[-1];
+  }
+
+  alignas(const char*) char rep_[kInlineCapacity + 1] = {};
 };
+static_assert(sizeof(RefCountedString) == 16);
 
 class RefCountedStringWriter {
  public:
   RefCountedStringWriter() = default;
   explicit RefCountedStringWriter(size_t size) {
-    string_.data_ = RefCountedString::Allocate(size);
+    if (size <= RefCountedString::kInlineCapacity) {
+      string_.SetInline(nullptr, size);
+    } else {
+      string_.SetHeap(RefCountedString::Allocate(size));
+    }
   }
   RefCountedStringWriter(RefCountedStringWriter&& other) = default;
   RefCountedStringWriter(const RefCountedStringWriter& other) = delete;
@@ -250,7 +342,7 @@ struct HeapUsageEstimator;
 template <>
 struct HeapUsageEstimator<RefCountedString, void> {
   static size_t EstimateHeapUsage(const RefCountedString& x, size_t max_depth) {
-    return x.size();
+    return x.inlined() ? 0 : x.size();
   }
 };
 
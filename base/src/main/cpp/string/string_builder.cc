@@ -0,0 +1,99 @@
+#include "string_builder.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "absl/strings/cord.h"
+
+namespace base {
+namespace string {
+
+StringBuilder::~StringBuilder() {
+  if (data_ != inline_) free(data_);
+}
+
+StringBuilder& StringBuilder::AppendPieces(
+    std::initializer_list<absl::string_view> pieces) {
+  size_t length = 0;
+  for (absl::string_view piece : pieces) length += piece.size();
+  if (size_ + length > capacity_) {
+    for (absl::string_view piece : pieces) {
+      if (Overlaps(std::string_view(piece.data(), piece.size()))) {
+        // Growing would free what it points into; gather the pieces
+        // elsewhere first.
+        StringBuilder gathered;
+        gathered.AppendPieces(pieces);
+        reserve(size_ + length);
+        AppendUnchecked(gathered.view());
+        return *this;
+      }
+    }
+  }
+  reserve(size_ + length);
+  for (absl::string_view piece : pieces) {
+    AppendUnchecked(std::string_view(piece.data(), piece.size()));
+  }
+  return *this;
+}
+
+StringBuilder& StringBuilder::AppendRepeated(char c, size_t count) {
+  memset(AppendUninitialized(count), c, count);
+  return *this;
+}
+
+absl::Cord StringBuilder::ReleaseAsCord() {
+  if (data_ == inline_) {
+    absl::Cord cord(absl::string_view(data_, size_));
+    size_ = 0;
+    return cord;
+  }
+  char* data = data_;
+  absl::Cord cord = absl::MakeCordFromExternal(
+      absl::string_view(data, size_), [data] { free(data); });
+  data_ = inline_;
+  size_ = 0;
+  capacity_ = kInlineCapacity;
+  return cord;
+}
+
+void StringBuilder::Grow(size_t capacity) {
+  // Double so that a run of small appends is amortized linear.
+  capacity = std::max(capacity, capacity_ * 2);
+  char* data;
+  if (data_ == inline_) {
+    data = static_cast<char*>(malloc(capacity));
+    if (data != nullptr) memcpy(data, inline_, size_);
+  } else {
+    data = static_cast<char*>(realloc(data_, capacity));
+  }
+  // Out of memory is fatal, as it is for operator new without exceptions.
+  if (data == nullptr) abort();
+  data_ = data;
+  capacity_ = capacity;
+}
+
+void StringBuilder::AppendUnchecked(std::string_view piece) {
+  // memcpy may not be passed a null pointer, even for zero bytes.
+  if (piece.empty()) return;
+  memcpy(data_ + size_, piece.data(), piece.size());
+  size_ += piece.size();
+}
+
+StringBuilderStream::Buffer::int_type StringBuilderStream::Buffer::overflow(
+    int_type c) {
+  if (!traits_type::eq_int_type(c, traits_type::eof())) {
+    builder_->push_back(traits_type::to_char_type(c));
+  }
+  return traits_type::not_eof(c);
+}
+
+std::streamsize StringBuilderStream::Buffer::xsputn(const char* s,
+                                                    std::streamsize n) {
+  builder_->AppendPieces({absl::string_view(s, static_cast<size_t>(n))});
+  return n;
+}
+
+}  // namespace string
+}  // namespace base
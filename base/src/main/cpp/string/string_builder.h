@@ -0,0 +1,173 @@
+#ifndef STRING_STRING_BUILDER_H_
+#define STRING_STRING_BUILDER_H_
+
+#include <stddef.h>
+
+#include <functional>
+#include <initializer_list>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+
+#include "absl/base/config.h"
+#include "absl/strings/str_cat.h"
+
+namespace absl {
+ABSL_NAMESPACE_BEGIN
+class Cord;
+ABSL_NAMESPACE_END
+}  // namespace absl
+
+namespace base {
+namespace string {
+
+/// Growable byte buffer for assembling serializer and log output without
+/// iostreams. The first kInlineCapacity bytes live inside the builder, so
+/// short results never touch the heap.
+///
+/// Appends of several pieces add up their lengths first and grow the buffer
+/// at most once. Arguments are formatted like absl::StrCat: integers in
+/// decimal, floating point like "%g". Pieces may point into the builder
+/// itself, as in `b.Append(b.view(), "x")`.
+class StringBuilder {
+ public:
+  static constexpr size_t kInlineCapacity = 256;
+
+  StringBuilder() = default;
+  ~StringBuilder();
+
+  StringBuilder(const StringBuilder&) = delete;
+  StringBuilder& operator=(const StringBuilder&) = delete;
+
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  std::string_view view() const { return std::string_view(data_, size_); }
+
+  /// Empties the builder, keeping its buffer.
+  void clear() { size_ = 0; }
+
+  /// Makes room for `capacity` bytes in total.
+  void reserve(size_t capacity) {
+    if (capacity > capacity_) Grow(capacity);
+  }
+
+  StringBuilder& push_back(char c) {
+    if (size_ == capacity_) Grow(size_ + 1);
+    data_[size_++] = c;
+    return *this;
+  }
+
+  template <typename... Args>
+  StringBuilder& Append(const absl::AlphaNum& a, const Args&... args) {
+    return AppendPieces(
+        {a.Piece(), static_cast<const absl::AlphaNum&>(args).Piece()...});
+  }
+
+  StringBuilder& AppendPieces(std::initializer_list<absl::string_view> pieces);
+
+  /// Appends `count` copies of `c`.
+  StringBuilder& AppendRepeated(char c, size_t count);
+
+  /// Appends the elements of `range`, which must convert to std::string_view,
+  /// separated by `delimiter`.
+  template <typename Range>
+  StringBuilder& AppendJoin(const Range& range, std::string_view delimiter) {
+    size_t length = 0;
+    size_t count = 0;
+    for (const auto& element : range) {
+      length += std::string_view(element).size();
+      count++;
+    }
+    if (count == 0) return *this;
+    const size_t total = length + (count - 1) * delimiter.size();
+    if (size_ + total > capacity_ && Overlaps(delimiter, range)) {
+      // Growing would free what they point into; join them elsewhere first.
+      StringBuilder joined;
+      joined.AppendJoin(range, delimiter);
+      return AppendPieces({absl::string_view(joined.data(), joined.size())});
+    }
+    reserve(size_ + total);
+    bool first = true;
+    for (const auto& element : range) {
+      if (!first) AppendUnchecked(delimiter);
+      AppendUnchecked(element);
+      first = false;
+    }
+    return *this;
+  }
+
+  /// Grows the builder by `length` bytes and returns a pointer to them for
+  /// the caller to fill in.
+  char* AppendUninitialized(size_t length) {
+    reserve(size_ + length);
+    char* out = data_ + size_;
+    size_ += length;
+    return out;
+  }
+
+  std::string ToString() const { return std::string(data_, size_); }
+
+  /// Returns the contents as a Cord and empties the builder. A heap buffer is
+  /// handed to the Cord as is rather than copied.
+  absl::Cord ReleaseAsCord();
+
+ private:
+  void Grow(size_t capacity);
+
+  void AppendUnchecked(std::string_view piece);
+
+  // Whether `piece` points into the contents.
+  bool Overlaps(std::string_view piece) const {
+    return !piece.empty() &&
+           std::less_equal<const char*>()(data_, piece.data()) &&
+           std::less<const char*>()(piece.data(), data_ + size_);
+  }
+
+  template <typename Range>
+  bool Overlaps(std::string_view delimiter, const Range& range) const {
+    if (Overlaps(delimiter)) return true;
+    for (const auto& element : range) {
+      if (Overlaps(element)) return true;
+    }
+    return false;
+  }
+
+  char* data_ = inline_;
+  size_t size_ = 0;
+  size_t capacity_ = kInlineCapacity;
+  char inline_[kInlineCapacity];
+};
+
+/// std::ostream that appends to a StringBuilder, for call sites that take a
+/// stream. Output goes straight into the builder without a separate buffer.
+class StringBuilderStream : public std::ostream {
+ public:
+  explicit StringBuilderStream(StringBuilder* builder)
+      : std::ostream(&buffer_), buffer_(builder) {}
+
+  StringBuilder* builder() const { return buffer_.builder(); }
+
+ private:
+  class Buffer : public std::streambuf {
+   public:
+    explicit Buffer(StringBuilder* builder) : builder_(builder) {}
+
+    StringBuilder* builder() const { return builder_; }
+
+   protected:
+    int_type overflow(int_type c) override;
+    std::streamsize xsputn(const char* s, std::streamsize n) override;
+
+   private:
+    StringBuilder* builder_;
+  };
+
+  Buffer buffer_;
+};
+
+}  // namespace string
+}  // namespace base
+
+#endif  // STRING_STRING_BUILDER_H_
@@ -2,6 +2,11 @@
 
 #include <stdlib.h>
 
+#include <charconv>
+#include <system_error>
+
+#include "absl/strings/charconv.h"
+
 namespace base {
 namespace StringConvert {
 
@@ -74,5 +79,126 @@ double ToDouble(const char *s, double fail_value, bool *success_ptr) {
   if (success_ptr) *success_ptr = false;
   return fail_value;
 }
+
+namespace {
+
+// Parses the number at the start of [first, last) into *value and returns the
+// end of it, or nullptr if there is no number or it is out of range.
+template <typename T>
+const char *ParseInteger(const char *first, const char *last, T *value,
+                         int base) {
+  const std::from_chars_result result =
+      std::from_chars(first, last, *value, base);
+  return result.ec == std::errc() ? result.ptr : nullptr;
+}
+
+const char *ParseDouble(const char *first, const char *last, double *value) {
+  // std::from_chars for floating point is missing from the NDK's libc++.
+  // absl::from_chars also takes hexadecimal after a "0x", which std does not.
+  const char *digits = first != last && *first == '-' ? first + 1 : first;
+  if (last - digits >= 2 && digits[0] == '0' &&
+      (digits[1] == 'x' || digits[1] == 'X')) {
+    return nullptr;
+  }
+  const absl::from_chars_result result = absl::from_chars(first, last, *value);
+  return result.ec == std::errc() ? result.ptr : nullptr;
+}
+
+template <typename T, typename Parse>
+bool ParseWhole(std::string_view s, T *value, Parse parse) {
+  const char *last = s.data() + s.size();
+  T parsed;
+  if (parse(s.data(), last, &parsed) != last) return false;
+  *value = parsed;
+  return true;
+}
+
+template <typename T, typename Parse>
+size_t ParseFields(std::string_view s, char delimiter, T *values,
+                   size_t capacity, Parse parse) {
+  const char *cur = s.data();
+  const char *last = cur + s.size();
+  size_t count = 0;
+  while (cur != last && count < capacity) {
+    T parsed;
+    const char *next = parse(cur, last, &parsed);
+    if (next == nullptr) break;
+    if (next != last) {
+      if (*next != delimiter) break;
+      ++next;
+    }
+    values[count++] = parsed;
+    cur = next;
+  }
+  return count;
+}
+
+bool IsValidBase(int base) { return base >= 2 && base <= 36; }
+
+template <typename T>
+bool ToInteger(std::string_view s, T *value, int base) {
+  if (!IsValidBase(base)) return false;
+  return ParseWhole(s, value,
+                    [base](const char *first, const char *last, T *parsed) {
+                      return ParseInteger(first, last, parsed, base);
+                    });
+}
+
+template <typename T>
+size_t ToIntegerArray(std::string_view s, char delimiter, T *values,
+                      size_t capacity, int base) {
+  if (!IsValidBase(base)) return 0;
+  return ParseFields(s, delimiter, values, capacity,
+                     [base](const char *first, const char *last, T *parsed) {
+                       return ParseInteger(first, last, parsed, base);
+                     });
+}
+
+}  // namespace
+
+bool ToSInt32(std::string_view s, int32_t *value, int base) {
+  return ToInteger(s, value, base);
+}
+
+bool ToUInt32(std::string_view s, uint32_t *value, int base) {
+  return ToInteger(s, value, base);
+}
+
+bool ToSInt64(std::string_view s, int64_t *value, int base) {
+  return ToInteger(s, value, base);
+}
+
+bool ToUInt64(std::string_view s, uint64_t *value, int base) {
+  return ToInteger(s, value, base);
+}
+
+bool ToDouble(std::string_view s, double *value) {
+  return ParseWhole(s, value, ParseDouble);
+}
+
+size_t ToSInt32Array(std::string_view s, char delimiter, int32_t *values,
+                     size_t capacity, int base) {
+  return ToIntegerArray(s, delimiter, values, capacity, base);
+}
+
+size_t ToUInt32Array(std::string_view s, char delimiter, uint32_t *values,
+                     size_t capacity, int base) {
+  return ToIntegerArray(s, delimiter, values, capacity, base);
+}
+
+size_t ToSInt64Array(std::string_view s, char delimiter, int64_t *values,
+                     size_t capacity, int base) {
+  return ToIntegerArray(s, delimiter, values, capacity, base);
+}
+
+size_t ToUInt64Array(std::string_view s, char delimiter, uint64_t *values,
+                     size_t capacity, int base) {
+  return ToIntegerArray(s, delimiter, values, capacity, base);
+}
+
+size_t ToDoubleArray(std::string_view s, char delimiter, double *values,
+                     size_t capacity) {
+  return ParseFields(s, delimiter, values, capacity, ParseDouble);
+}
 }  // namespace StringConvert
 }  // namespace base
@@ -1,8 +1,11 @@
 #ifndef STRING_CONVERT_H
 #define STRING_CONVERT_H
 
+#include <stddef.h>
 #include <stdint.h>
 
+#include <string_view>
+
 namespace base {
 
 namespace StringConvert {
@@ -24,6 +27,42 @@ uint64_t ToUInt64(const char *s, uint64_t fail_value = 0, int base = 0,
 
 double ToDouble(const char *s, double fail_value = 0.0,
                 bool *success_ptr = nullptr);
+
+/// Parses all of \a s, which need not be NUL-terminated, as a number.
+///
+/// Unlike the overloads above these do not depend on the C locale, skip no
+/// whitespace and accept no '+' sign or "0x" prefix: \a base (2 to 36) is
+/// always explicit. Integers may only be negative when signed. Doubles are
+/// decimal or scientific, or "inf" or "nan".
+///
+/// \return true and sets \a *value on success. Returns false and leaves
+/// \a *value unchanged if \a s is empty, has characters that are not part
+/// of the number, or is out of range for the type.
+bool ToSInt32(std::string_view s, int32_t *value, int base = 10);
+bool ToUInt32(std::string_view s, uint32_t *value, int base = 10);
+bool ToSInt64(std::string_view s, int64_t *value, int base = 10);
+bool ToUInt64(std::string_view s, uint64_t *value, int base = 10);
+bool ToDouble(std::string_view s, double *value);
+
+/// Parses the fields of \a s separated by \a delimiter into \a values, which
+/// has room for \a capacity of them, with the rules of the overloads above.
+/// A single delimiter at the end of \a s, as in a newline terminated column,
+/// is allowed.
+///
+/// \return the number of values stored. Parsing stops at the first field
+/// that does not parse or once \a capacity values are stored, so a result
+/// short of the number of fields tells the caller where the input went
+/// wrong.
+size_t ToSInt32Array(std::string_view s, char delimiter, int32_t *values,
+                     size_t capacity, int base = 10);
+size_t ToUInt32Array(std::string_view s, char delimiter, uint32_t *values,
+                     size_t capacity, int base = 10);
+size_t ToSInt64Array(std::string_view s, char delimiter, int64_t *values,
+                     size_t capacity, int base = 10);
+size_t ToUInt64Array(std::string_view s, char delimiter, uint64_t *values,
+                     size_t capacity, int base = 10);
+size_t ToDoubleArray(std::string_view s, char delimiter, double *values,
+                     size_t capacity);
 }  // namespace StringConvert
 }  // namespace base
 
@@ -0,0 +1,72 @@
+#include "string_intern_pool.h"
+
+#include <assert.h>
+
+#include "absl/hash/hash.h"
+
+namespace base {
+namespace string {
+
+StringInternPool::~StringInternPool() {
+#ifndef NDEBUG
+  for (const Shard& shard : shards_) {
+    absl::MutexLock lock(&shard.mutex);
+    assert(shard.entries.empty());
+  }
+#endif
+}
+
+StringInternPool& StringInternPool::Global() {
+  static StringInternPool* pool = new StringInternPool();
+  return *pool;
+}
+
+RefCountedString StringInternPool::Intern(std::string_view s) {
+  if (s.empty()) return RefCountedString();
+  const size_t hash = absl::Hash<std::string_view>()(s);
+  Shard& shard = ShardFor(hash);
+  absl::MutexLock lock(&shard.mutex);
+  shard.lookups++;
+  auto it = shard.entries.find(s);
+  if (it != shard.entries.end()) {
+    if (RefCountedString::TryAddReference(it->second)) {
+      shard.hits++;
+      shard.bytes_saved += s.size();
+      return RefCountedString(it->second, RefCountedString::AdoptTag());
+    }
+    // Its last reference is being dropped. Release() will find the entry
+    // replaced and leave it alone.
+    shard.bytes -= s.size();
+    shard.entries.erase(it);
+  }
+  const char* data = RefCountedString::AllocateInterned(s, this, hash);
+  shard.entries.emplace(std::string_view(data, s.size()), data);
+  shard.bytes += s.size();
+  return RefCountedString(data, RefCountedString::AdoptTag());
+}
+
+void StringInternPool::Release(std::string_view s, size_t hash) {
+  Shard& shard = ShardFor(hash);
+  absl::MutexLock lock(&shard.mutex);
+  auto it = shard.entries.find(s);
+  if (it != shard.entries.end() && it->second == s.data()) {
+    shard.bytes -= s.size();
+    shard.entries.erase(it);
+  }
+}
+
+StringInternPool::Stats StringInternPool::GetStats() const {
+  Stats stats;
+  for (const Shard& shard : shards_) {
+    absl::MutexLock lock(&shard.mutex);
+    stats.lookups += shard.lookups;
+    stats.hits += shard.hits;
+    stats.bytes_saved += shard.bytes_saved;
+    stats.entries += shard.entries.size();
+    stats.bytes += shard.bytes;
+  }
+  return stats;
+}
+
+}  // namespace string
+}  // namespace base
@@ -0,0 +1,83 @@
+#ifndef STRING_STRING_INTERN_POOL_H_
+#define STRING_STRING_INTERN_POOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string_view>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+#include "ref_counted_string.h"
+
+namespace base {
+namespace string {
+
+/// Concurrent table handing out one shared RefCountedString per distinct
+/// string, so that repeated keys (header names, JSON keys, metric names) are
+/// allocated once and interned strings from the same pool compare by pointer.
+///
+/// Entries are weak: a string leaves the pool when its last reference is
+/// dropped. The table is split into shards with a lock each.
+///
+/// A pool must outlive the strings it hands out.
+class StringInternPool {
+ public:
+  struct Stats {
+    uint64_t lookups = 0;
+    uint64_t hits = 0;
+    /// Bytes of string data that hits did not allocate.
+    uint64_t bytes_saved = 0;
+    /// Strings currently in the pool, and their total size.
+    size_t entries = 0;
+    size_t bytes = 0;
+
+    double hit_rate() const {
+      return lookups ? static_cast<double>(hits) / lookups : 0;
+    }
+  };
+
+  StringInternPool() = default;
+  ~StringInternPool();
+
+  StringInternPool(const StringInternPool&) = delete;
+  StringInternPool& operator=(const StringInternPool&) = delete;
+
+  /// Process-wide pool, never destroyed.
+  static StringInternPool& Global();
+
+  /// Returns the pooled string equal to `s`, adding it if there is none.
+  RefCountedString Intern(std::string_view s);
+
+  Stats GetStats() const;
+
+ private:
+  friend class RefCountedString;
+
+  static constexpr size_t kShardCount = 16;
+
+  struct alignas(64) Shard {
+    mutable absl::Mutex mutex;
+    // Keys point into the interned data, which outlives its entry.
+    absl::flat_hash_map<std::string_view, const char*> entries
+        ABSL_GUARDED_BY(mutex);
+    uint64_t lookups ABSL_GUARDED_BY(mutex) = 0;
+    uint64_t hits ABSL_GUARDED_BY(mutex) = 0;
+    uint64_t bytes_saved ABSL_GUARDED_BY(mutex) = 0;
+    size_t bytes ABSL_GUARDED_BY(mutex) = 0;
+  };
+
+  Shard& ShardFor(size_t hash) { return shards_[hash % kShardCount]; }
+
+  // Called when the last reference to an interned string is dropped, before
+  // its memory is freed.
+  void Release(std::string_view s, size_t hash);
+
+  Shard shards_[kShardCount];
+};
+
+}  // namespace string
+}  // namespace base
+
+#endif  // STRING_STRING_INTERN_POOL_H_
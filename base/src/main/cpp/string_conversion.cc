@@ -1,34 +1,251 @@
 #include "string_conversion.h"
 
-#include <codecvt>
-#include <locale>
-#include <sstream>
+#include <cstdint>
+#include <cstring>
 #include <string>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 namespace base {
 
-using Utf16StringConverter =
-    std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t>;
+namespace {
+
+constexpr char16_t kReplacementCharacter = 0xFFFD;
+
+// Copies the leading run of ASCII code units, 16 at a time where the
+// platform has vectors, and returns its length rounded down to the step.
+size_t CopyAsciiUtf16ToUtf8(const char16_t* src, size_t length, char* dst) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  const __m128i non_ascii = _mm_set1_epi16(static_cast<int16_t>(0xFF80));
+  for (; length - i >= 16; i += 16) {
+    const __m128i a =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    const __m128i b =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 8));
+    const __m128i high = _mm_and_si128(_mm_or_si128(a, b), non_ascii);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi16(high, _mm_setzero_si128())) !=
+        0xFFFF) {
+      break;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_packus_epi16(a, b));
+  }
+#elif defined(__aarch64__)
+  const uint16_t* units = reinterpret_cast<const uint16_t*>(src);
+  for (; length - i >= 16; i += 16) {
+    const uint16x8_t a = vld1q_u16(units + i);
+    const uint16x8_t b = vld1q_u16(units + i + 8);
+    if (vmaxvq_u16(vorrq_u16(a, b)) >= 0x80) {
+      break;
+    }
+    vst1q_u8(reinterpret_cast<uint8_t*>(dst + i),
+             vcombine_u8(vmovn_u16(a), vmovn_u16(b)));
+  }
+#else
+  for (; length - i >= 4; i += 4) {
+    uint64_t block;
+    memcpy(&block, src + i, sizeof(block));
+    if (block & 0xFF80FF80FF80FF80ULL) {
+      break;
+    }
+    for (size_t k = 0; k < 4; k++) {
+      dst[i + k] = static_cast<char>(src[i + k]);
+    }
+  }
+#endif
+  return i;
+}
+
+// Copies the leading run of ASCII bytes, 16 at a time where the platform has
+// vectors, and returns its length rounded down to the step.
+size_t CopyAsciiUtf8ToUtf16(const char* src, size_t length, char16_t* dst) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  for (; length - i >= 16; i += 16) {
+    const __m128i in =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    if (_mm_movemask_epi8(in) != 0) {
+      break;
+    }
+    const __m128i zero = _mm_setzero_si128();
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_unpacklo_epi8(in, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 8),
+                     _mm_unpackhi_epi8(in, zero));
+  }
+#elif defined(__aarch64__)
+  uint16_t* units = reinterpret_cast<uint16_t*>(dst);
+  for (; length - i >= 16; i += 16) {
+    const uint8x16_t in = vld1q_u8(reinterpret_cast<const uint8_t*>(src + i));
+    if (vmaxvq_u8(in) >= 0x80) {
+      break;
+    }
+    vst1q_u16(units + i, vmovl_u8(vget_low_u8(in)));
+    vst1q_u16(units + i + 8, vmovl_u8(vget_high_u8(in)));
+  }
+#else
+  for (; length - i >= 8; i += 8) {
+    uint64_t block;
+    memcpy(&block, src + i, sizeof(block));
+    if (block & 0x8080808080808080ULL) {
+      break;
+    }
+    for (size_t k = 0; k < 8; k++) {
+      dst[i + k] = static_cast<char16_t>(src[i + k]);
+    }
+  }
+#endif
+  return i;
+}
+
+// Decodes the non-ASCII sequence starting at |src[0]| into |code_point| and
+// returns its length in bytes. An ill-formed sequence decodes as U+FFFD and
+// consumes its maximal well-formed prefix, or one byte if there is none, as
+// recommended by Unicode chapter 3.9.
+size_t DecodeUtf8Sequence(const uint8_t* src,
+                          size_t length,
+                          uint32_t* code_point) {
+  const uint8_t lead = src[0];
+  size_t size;
+  uint32_t value;
+  // The valid range of the second byte depends on the lead byte; this also
+  // rejects overlong forms, surrogates and values above U+10FFFF.
+  uint8_t low = 0x80;
+  uint8_t high = 0xBF;
+  if (lead >= 0xC2 && lead <= 0xDF) {
+    size = 2;
+    value = lead & 0x1F;
+  } else if (lead >= 0xE0 && lead <= 0xEF) {
+    size = 3;
+    value = lead & 0x0F;
+    if (lead == 0xE0) {
+      low = 0xA0;
+    } else if (lead == 0xED) {
+      high = 0x9F;
+    }
+  } else if (lead >= 0xF0 && lead <= 0xF4) {
+    size = 4;
+    value = lead & 0x07;
+    if (lead == 0xF0) {
+      low = 0x90;
+    } else if (lead == 0xF4) {
+      high = 0x8F;
+    }
+  } else {
+    *code_point = kReplacementCharacter;
+    return 1;
+  }
+  for (size_t k = 1; k < size; k++) {
+    if (k >= length || src[k] < low || src[k] > high) {
+      *code_point = kReplacementCharacter;
+      return k;
+    }
+    value = value << 6 | (src[k] & 0x3F);
+    low = 0x80;
+    high = 0xBF;
+  }
+  *code_point = value;
+  return size;
+}
+
+}  // namespace
 
 std::string Join(const std::vector<std::string>& vec, const char* delim) {
-  std::stringstream res;
+  if (vec.empty()) return std::string();
+  const size_t delim_length = strlen(delim);
+  size_t length = delim_length * (vec.size() - 1);
+  for (const std::string& element : vec) length += element.size();
+  std::string res;
+  res.reserve(length);
   for (size_t i = 0; i < vec.size(); ++i) {
-    res << vec[i];
-    if (i < vec.size() - 1) {
-      res << delim;
+    if (i > 0) res.append(delim, delim_length);
+    res.append(vec[i]);
+  }
+  return res;
+}
+
+size_t Utf16ToUtf8(const std::u16string_view string, char* output) {
+  const char16_t* src = string.data();
+  const size_t length = string.size();
+  char* dst = output;
+  size_t i = 0;
+  while (i < length) {
+    if (src[i] < 0x80) {
+      const size_t ascii = CopyAsciiUtf16ToUtf8(src + i, length - i, dst);
+      i += ascii;
+      dst += ascii;
+      // Finish a run shorter than a step one unit at a time.
+      while (i < length && src[i] < 0x80) {
+        *dst++ = static_cast<char>(src[i++]);
+      }
+      continue;
+    }
+    uint32_t c = src[i++];
+    if (c >= 0xD800 && c <= 0xDFFF) {
+      if (c <= 0xDBFF && i < length && src[i] >= 0xDC00 && src[i] <= 0xDFFF) {
+        c = 0x10000 + ((c - 0xD800) << 10) + (src[i++] - 0xDC00);
+      } else {
+        c = kReplacementCharacter;
+      }
+    }
+    if (c < 0x800) {
+      *dst++ = static_cast<char>(0xC0 | (c >> 6));
+    } else if (c < 0x10000) {
+      *dst++ = static_cast<char>(0xE0 | (c >> 12));
+      *dst++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+    } else {
+      *dst++ = static_cast<char>(0xF0 | (c >> 18));
+      *dst++ = static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+      *dst++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+    }
+    *dst++ = static_cast<char>(0x80 | (c & 0x3F));
+  }
+  return dst - output;
+}
+
+size_t Utf8ToUtf16(const std::string_view string, char16_t* output) {
+  const uint8_t* src = reinterpret_cast<const uint8_t*>(string.data());
+  const size_t length = string.size();
+  char16_t* dst = output;
+  size_t i = 0;
+  while (i < length) {
+    if (src[i] < 0x80) {
+      const size_t ascii = CopyAsciiUtf8ToUtf16(string.data() + i,
+                                                length - i, dst);
+      i += ascii;
+      dst += ascii;
+      while (i < length && src[i] < 0x80) {
+        *dst++ = src[i++];
+      }
+      continue;
+    }
+    uint32_t c;
+    i += DecodeUtf8Sequence(src + i, length - i, &c);
+    if (c >= 0x10000) {
+      *dst++ = static_cast<char16_t>(0xD800 + ((c - 0x10000) >> 10));
+      *dst++ = static_cast<char16_t>(0xDC00 + (c & 0x3FF));
+    } else {
+      *dst++ = static_cast<char16_t>(c);
     }
   }
-  return res.str();
+  return dst - output;
 }
 
 std::string Utf16ToUtf8(const std::u16string_view string) {
-  Utf16StringConverter converter;
-  return converter.to_bytes(string.data());
+  std::string result(MaxUtf8Length(string.size()), '\0');
+  result.resize(Utf16ToUtf8(string, &result[0]));
+  return result;
 }
 
 std::u16string Utf8ToUtf16(const std::string_view string) {
-  Utf16StringConverter converter;
-  return converter.from_bytes(string.data());
+  std::u16string result(MaxUtf16Length(string.size()), u'\0');
+  result.resize(Utf8ToUtf16(string, &result[0]));
+  return result;
 }
 
 }  // namespace base
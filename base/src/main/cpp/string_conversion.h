@@ -1,7 +1,9 @@
 #ifndef BASE_STRING_CONVERSION_H_
 #define BASE_STRING_CONVERSION_H_
 
+#include <cstddef>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace base {
@@ -10,11 +12,31 @@ namespace base {
 std::string Join(const std::vector<std::string>& vec, const char* delimiter);
 
 // Returns a UTF-8 encoded equivalent of a UTF-16 encoded input string.
+// Unpaired surrogates are replaced with U+FFFD.
 std::string Utf16ToUtf8(const std::u16string_view string);
 
-// Returns a UTF-16 encoded equivalent of a UTF-8 encoded input string.
+// Returns a UTF-16 encoded equivalent of a UTF-8 encoded input string. Each
+// maximal invalid subsequence is replaced with U+FFFD.
 std::u16string Utf8ToUtf16(const std::string_view string);
 
+// The most UTF-8 bytes Utf16ToUtf8() writes for |length| UTF-16 code units.
+constexpr size_t MaxUtf8Length(size_t length) {
+  return length * 3;
+}
+
+// The most UTF-16 code units Utf8ToUtf16() writes for |length| UTF-8 bytes.
+constexpr size_t MaxUtf16Length(size_t length) {
+  return length;
+}
+
+// Converts |string| into |output|, which must have room for
+// MaxUtf8Length(string.size()) bytes. Returns the number of bytes written.
+size_t Utf16ToUtf8(const std::u16string_view string, char* output);
+
+// Converts |string| into |output|, which must have room for
+// MaxUtf16Length(string.size()) code units. Returns the number written.
+size_t Utf8ToUtf16(const std::string_view string, char16_t* output);
+
 }  // namespace base
 
 #endif  // BASE_STRING_CONVERSION_H_
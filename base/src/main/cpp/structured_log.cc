@@ -0,0 +1,238 @@
+#include "structured_log.h"
+
+#include <dirent.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+
+#include "async_logging.h"
+#include "time/time_point.h"
+
+namespace base {
+
+namespace {
+
+constexpr char kFileExtension[] = ".blog";
+
+struct SiteRegistry {
+  std::mutex mutex;
+  // The site with id n is sites[n - 1].
+  std::vector<const StructuredLogSite*> sites;
+};
+
+SiteRegistry& GetSiteRegistry() {
+  static SiteRegistry* registry = new SiteRegistry();
+  return *registry;
+}
+
+// Parses the n of a file named <name>.<n>.blog.
+bool ParseFileIndex(std::string_view file_name,
+                    std::string_view name,
+                    uint32_t* index) {
+  const std::string_view extension(kFileExtension);
+  if (file_name.size() <= name.size() + 1 + extension.size() ||
+      file_name.substr(0, name.size()) != name ||
+      file_name[name.size()] != '.' ||
+      file_name.substr(file_name.size() - extension.size()) != extension) {
+    return false;
+  }
+  const std::string digits(file_name.substr(
+      name.size() + 1, file_name.size() - name.size() - 1 - extension.size()));
+  if (digits.find_first_not_of("0123456789") != std::string::npos) {
+    return false;
+  }
+  *index = static_cast<uint32_t>(strtoul(digits.c_str(), nullptr, 10));
+  return true;
+}
+
+}  // namespace
+
+const StructuredLogSite* GetStructuredLogSite(uint32_t id) {
+  SiteRegistry& registry = GetSiteRegistry();
+  std::scoped_lock lock(registry.mutex);
+  if (id == 0 || id > registry.sites.size()) {
+    return nullptr;
+  }
+  return registry.sites[id - 1];
+}
+
+void FormatStructuredRecord(std::string_view record,
+                            string::StringBuilder* out) {
+  uint32_t id = 0;
+  if (record.size() >= binary_log::kRecordHeaderSize) {
+    memcpy(&id, record.data(), sizeof(id));
+  }
+  const StructuredLogSite* site = GetStructuredLogSite(id);
+  if (site == nullptr) {
+    out->Append("[structured log record of unknown site ", id, "]\n");
+    return;
+  }
+  AppendLogPrefix(site->severity, site->file, site->line, out);
+  binary_log::FormatArguments(site->format, site->types, site->type_count,
+                              record.substr(binary_log::kRecordHeaderSize),
+                              out);
+  out->push_back('\n');
+}
+
+namespace internal {
+
+uint32_t RegisterStructuredLogSite(StructuredLogSite* site,
+                                   const binary_log::ArgType* types,
+                                   size_t type_count) {
+  SiteRegistry& registry = GetSiteRegistry();
+  std::scoped_lock lock(registry.mutex);
+  // Another thread may have registered the site since the caller looked.
+  uint32_t id = site->id.load(std::memory_order_relaxed);
+  if (id != 0) {
+    return id;
+  }
+  site->types = types;
+  site->type_count = type_count;
+  registry.sites.push_back(site);
+  id = static_cast<uint32_t>(registry.sites.size());
+  site->id.store(id, std::memory_order_release);
+  return id;
+}
+
+void SendStructuredRecord(const StructuredLogSite& site,
+                          std::string_view record) {
+  if (site.severity < kLogFatal &&
+      SendBinaryToAsyncLog(site.severity, record)) {
+    return;
+  }
+  string::StringBuilder message;
+  binary_log::FormatArguments(site.format, site.types, site.type_count,
+                              record.substr(binary_log::kRecordHeaderSize),
+                              &message);
+  LogMessage(site.severity, site.file, site.line, nullptr).stream()
+      << message.view();
+}
+
+char* EncodeStructuredRecordHeader(char* out, uint32_t id) {
+  const int64_t ticks = TimePoint::Now().ToEpochDelta().ToNanoseconds();
+  memcpy(out, &id, sizeof(id));
+  memcpy(out + sizeof(id), &ticks, sizeof(ticks));
+  return out + binary_log::kRecordHeaderSize;
+}
+
+}  // namespace internal
+
+BinaryLogFileSink::BinaryLogFileSink(BinaryLogFileOptions options)
+    : options_(std::move(options)) {}
+
+BinaryLogFileSink::~BinaryLogFileSink() {
+  if (file_ != nullptr) {
+    fclose(file_);
+  }
+}
+
+std::unique_ptr<BinaryLogFileSink> BinaryLogFileSink::Create(
+    BinaryLogFileOptions options) {
+  std::unique_ptr<BinaryLogFileSink> sink(
+      new BinaryLogFileSink(std::move(options)));
+  // Continues the numbering of files left by earlier runs, which count
+  // toward max_files.
+  if (DIR* dir = opendir(sink->options_.directory.c_str())) {
+    while (dirent* entry = readdir(dir)) {
+      uint32_t index;
+      if (ParseFileIndex(entry->d_name, sink->options_.name, &index)) {
+        sink->indices_.push_back(index);
+      }
+    }
+    closedir(dir);
+  }
+  std::sort(sink->indices_.begin(), sink->indices_.end());
+  if (!sink->indices_.empty()) {
+    sink->next_index_ = sink->indices_.back() + 1;
+  }
+  std::scoped_lock lock(sink->mutex_);
+  if (!sink->OpenNextFile()) {
+    return nullptr;
+  }
+  return sink;
+}
+
+void BinaryLogFileSink::SendBatch(const std::string_view* records,
+                                  size_t count) {
+  std::scoped_lock lock(mutex_);
+  for (size_t i = 0; i < count && file_ != nullptr; i++) {
+    const std::string_view record = records[i];
+    uint32_t id;
+    memcpy(&id, record.data(), sizeof(id));
+    if (id >= sites_written_.size()) {
+      sites_written_.resize(id + 1);
+    }
+    if (!sites_written_[id]) {
+      if (const StructuredLogSite* site = GetStructuredLogSite(id)) {
+        WriteSite(*site, id);
+      }
+      sites_written_[id] = true;
+    }
+    const uint32_t size = static_cast<uint32_t>(record.size());
+    Write(&binary_log::kRecordEntry, 1);
+    Write(&size, sizeof(size));
+    Write(record.data(), record.size());
+    if (file_size_ >= options_.max_file_size) {
+      OpenNextFile();
+    }
+  }
+  if (file_ != nullptr) {
+    fflush(file_);
+  }
+}
+
+std::string BinaryLogFileSink::GetPath(uint32_t index) const {
+  return options_.directory + "/" + options_.name + "." +
+         std::to_string(index) + kFileExtension;
+}
+
+bool BinaryLogFileSink::OpenNextFile() {
+  if (file_ != nullptr) {
+    fclose(file_);
+  }
+  file_ = fopen(GetPath(next_index_).c_str(), "wb");
+  if (file_ == nullptr) {
+    return false;
+  }
+  indices_.push_back(next_index_++);
+  while (indices_.size() > std::max<size_t>(options_.max_files, 1)) {
+    unlink(GetPath(indices_.front()).c_str());
+    indices_.pop_front();
+  }
+  file_size_ = 0;
+  sites_written_.clear();
+  Write(binary_log::kFileMagic, sizeof(binary_log::kFileMagic));
+  Write(&binary_log::kFileVersion, sizeof(binary_log::kFileVersion));
+  return true;
+}
+
+void BinaryLogFileSink::WriteSite(const StructuredLogSite& site, uint32_t id) {
+  const int32_t severity = site.severity;
+  const int32_t line = site.line;
+  const std::string_view file(site.file);
+  const std::string_view format(site.format);
+  const uint16_t file_size =
+      static_cast<uint16_t>(std::min<size_t>(file.size(), UINT16_MAX));
+  const uint16_t format_size =
+      static_cast<uint16_t>(std::min<size_t>(format.size(), UINT16_MAX));
+  const uint8_t type_count = static_cast<uint8_t>(site.type_count);
+  Write(&binary_log::kSiteEntry, 1);
+  Write(&id, sizeof(id));
+  Write(&severity, sizeof(severity));
+  Write(&line, sizeof(line));
+  Write(&file_size, sizeof(file_size));
+  Write(file.data(), file_size);
+  Write(&format_size, sizeof(format_size));
+  Write(format.data(), format_size);
+  Write(&type_count, sizeof(type_count));
+  Write(site.types, type_count);
+}
+
+void BinaryLogFileSink::Write(const void* data, size_t size) {
+  fwrite(data, 1, size, file_);
+  file_size_ += size;
+}
+
+}  // namespace base
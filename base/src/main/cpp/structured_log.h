@@ -0,0 +1,244 @@
+#ifndef STRUCTURED_LOG_H_
+#define STRUCTURED_LOG_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "binary_log_format.h"
+#include "log_level.h"
+#include "log_sink.h"
+#include "logging.h"
+#include "string/string_builder.h"
+
+// Structured logging: BASE_SLOG(INFO, "fetched %s in %d ms", uri, millis)
+// logs like BASE_LOG, and is filtered by the same LogSettings, but formats
+// nothing on the calling thread. It records the id of its call site, a
+// timestamp and the raw argument bytes, and the text is produced later:
+//
+//  * While async logging runs (see async_logging.h) with a BinaryLogSink,
+//    records are written as they are, e.g. by BinaryLogFileSink, and decoded
+//    off the device with binary_log::DecodeBinaryLog().
+//  * While async logging runs without one, the drainer formats the records
+//    and sends them to the text sink.
+//  * Otherwise, and for FATAL, the record is formatted right away and logged
+//    through LogMessage.
+//
+// The format takes printf conversions. Arguments may be integers, enums,
+// floating point numbers, strings (const char*, std::string, std::string_view)
+// and pointers.
+
+namespace base {
+
+// A BASE_SLOG call site. Sites are constant-initialized, so they cost no
+// initialization guard; each is registered, and gets its id, the first time
+// it logs.
+struct StructuredLogSite {
+  constexpr StructuredLogSite(LogSeverity severity,
+                              const char* file,
+                              int line,
+                              const char* format)
+      : severity(severity), file(file), line(line), format(format) {}
+
+  const LogSeverity severity;
+  const char* const file;
+  const int line;
+  const char* const format;
+
+  // Set once by registration, before |id| is published.
+  const binary_log::ArgType* types = nullptr;
+  size_t type_count = 0;
+  // 0 until registered.
+  std::atomic<uint32_t> id{0};
+};
+
+// Returns the site registered under |id|, or nullptr.
+const StructuredLogSite* GetStructuredLogSite(uint32_t id);
+
+// Appends |record|, formatted the way BASE_LOG would have, to |out|.
+void FormatStructuredRecord(std::string_view record,
+                            string::StringBuilder* out);
+
+struct BinaryLogFileOptions {
+  // Directory the files are created in. Must exist.
+  std::string directory;
+  // Files are named <name>.<n>.blog, with n counting up.
+  std::string name = "base";
+  // A file is closed once it grows past this size.
+  size_t max_file_size = 4 * 1024 * 1024;
+  // The oldest files are deleted to keep at most this many.
+  size_t max_files = 4;
+};
+
+// Writes structured records to rotating files.
+class BinaryLogFileSink : public BinaryLogSink {
+ public:
+  // Returns nullptr if no file can be created in |options.directory|.
+  static std::unique_ptr<BinaryLogFileSink> Create(
+      BinaryLogFileOptions options);
+
+  ~BinaryLogFileSink() override;
+
+  void SendBatch(const std::string_view* records, size_t count) override;
+
+ private:
+  explicit BinaryLogFileSink(BinaryLogFileOptions options);
+
+  std::string GetPath(uint32_t index) const;
+  bool OpenNextFile();
+  void WriteSite(const StructuredLogSite& site, uint32_t id);
+  void Write(const void* data, size_t size);
+
+  const BinaryLogFileOptions options_;
+
+  std::mutex mutex_;
+  FILE* file_ = nullptr;
+  size_t file_size_ = 0;
+  // Indices of the files on disk, oldest first.
+  std::deque<uint32_t> indices_;
+  uint32_t next_index_ = 0;
+  // Whether the current file describes the site of each id yet.
+  std::vector<bool> sites_written_;
+};
+
+namespace internal {
+
+uint32_t RegisterStructuredLogSite(StructuredLogSite* site,
+                                   const binary_log::ArgType* types,
+                                   size_t type_count);
+
+void SendStructuredRecord(const StructuredLogSite& site,
+                          std::string_view record);
+
+char* EncodeStructuredRecordHeader(char* out, uint32_t id);
+
+template <typename T>
+constexpr bool kUnsupportedStructuredLogArg = false;
+
+// Pointers are widened to 8 bytes on every ABI.
+struct EncodedPointer {
+  uint64_t value;
+};
+
+// Reduces an argument to one of the five encoded types.
+template <typename T>
+auto NormalizeStructuredLogArg(const T& value) {
+  using U = std::decay_t<T>;
+  if constexpr (std::is_enum_v<U>) {
+    return NormalizeStructuredLogArg(
+        static_cast<std::underlying_type_t<U>>(value));
+  } else if constexpr (std::is_same_v<U, bool>) {
+    return static_cast<uint64_t>(value);
+  } else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>) {
+    return static_cast<int64_t>(value);
+  } else if constexpr (std::is_integral_v<U>) {
+    return static_cast<uint64_t>(value);
+  } else if constexpr (std::is_floating_point_v<U>) {
+    return static_cast<double>(value);
+  } else if constexpr (std::is_same_v<U, const char*> ||
+                       std::is_same_v<U, char*>) {
+    return value != nullptr ? std::string_view(value)
+                            : std::string_view("(null)");
+  } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+    return std::string_view(value);
+  } else if constexpr (std::is_pointer_v<U>) {
+    return EncodedPointer{reinterpret_cast<uintptr_t>(value)};
+  } else {
+    static_assert(kUnsupportedStructuredLogArg<T>,
+                  "BASE_SLOG argument type is not supported");
+  }
+}
+
+template <typename T>
+inline constexpr binary_log::ArgType kStructuredLogArgType =
+    binary_log::ArgType::kPointer;
+template <>
+inline constexpr binary_log::ArgType kStructuredLogArgType<int64_t> =
+    binary_log::ArgType::kSigned;
+template <>
+inline constexpr binary_log::ArgType kStructuredLogArgType<uint64_t> =
+    binary_log::ArgType::kUnsigned;
+template <>
+inline constexpr binary_log::ArgType kStructuredLogArgType<double> =
+    binary_log::ArgType::kDouble;
+template <>
+inline constexpr binary_log::ArgType kStructuredLogArgType<std::string_view> =
+    binary_log::ArgType::kString;
+
+template <typename T>
+size_t EncodedSize(const T&) {
+  return 8;
+}
+
+inline size_t EncodedSize(std::string_view value) {
+  return sizeof(uint32_t) + value.size();
+}
+
+template <typename T>
+char* Encode(char* out, const T& value) {
+  static_assert(sizeof(T) == 8);
+  memcpy(out, &value, sizeof(value));
+  return out + sizeof(value);
+}
+
+inline char* Encode(char* out, std::string_view value) {
+  const uint32_t size = static_cast<uint32_t>(value.size());
+  memcpy(out, &size, sizeof(size));
+  memcpy(out + sizeof(size), value.data(), value.size());
+  return out + sizeof(size) + value.size();
+}
+
+template <typename... Ts>
+void WriteStructuredRecord(StructuredLogSite* site, const Ts&... values) {
+  static_assert(sizeof...(Ts) <= UINT8_MAX, "Too many BASE_SLOG arguments");
+  // One more than needed, so that there is an array without arguments too.
+  static constexpr binary_log::ArgType kTypes[] = {
+      kStructuredLogArgType<Ts>..., binary_log::ArgType::kSigned};
+  uint32_t id = site->id.load(std::memory_order_acquire);
+  if (id == 0) {
+    id = RegisterStructuredLogSite(site, kTypes, sizeof...(Ts));
+  }
+  const size_t size =
+      binary_log::kRecordHeaderSize + (size_t{0} + ... + EncodedSize(values));
+  char stack_record[256];
+  std::unique_ptr<char[]> heap_record;
+  char* record = stack_record;
+  if (size > sizeof(stack_record)) {
+    heap_record.reset(new char[size]);
+    record = heap_record.get();
+  }
+  char* out = EncodeStructuredRecordHeader(record, id);
+  ((out = Encode(out, values)), ...);
+  SendStructuredRecord(*site, std::string_view(record, size));
+}
+
+}  // namespace internal
+
+template <typename... Args>
+void WriteStructuredLog(StructuredLogSite* site, const Args&... args) {
+  internal::WriteStructuredRecord(
+      site, internal::NormalizeStructuredLogArg(args)...);
+}
+
+}  // namespace base
+
+#define BASE_SLOG(severity, format, ...)                                 \
+  do {                                                                   \
+    if (BASE_LOG_IS_ON(severity)) {                                      \
+      static ::base::StructuredLogSite base_slog_site(                   \
+          ::base::LOG_##severity, __FILE__, __LINE__, format);           \
+      ::base::WriteStructuredLog(&base_slog_site, ##__VA_ARGS__);        \
+    }                                                                    \
+  } while (false)
+
+#endif  // STRUCTURED_LOG_H_
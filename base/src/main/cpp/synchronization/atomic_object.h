@@ -1,30 +1,96 @@
 #ifndef SYNCHRONIZATION_ATOMIC_OBJECT_H_
 #define SYNCHRONIZATION_ATOMIC_OBJECT_H_
 
-#include <mutex>
+#include <stddef.h>
+
+#include <atomic>
+#include <type_traits>
+#include <utility>
+
+#include "../macros.h"
+#include "hazard_pointer.h"
+#include "seq_lock.h"
 
 namespace base {
 
-// A wrapper for an object instance that can be read or written atomically.
+namespace internal {
+
+// Up to this size, trivially copyable values are cheaper to copy under a
+// SeqLock than to reach through a hazard pointer.
+constexpr size_t kMaxSeqLockObjectSize = 64;
+
 template <typename T>
+constexpr bool kUseSeqLock = std::is_trivially_copyable_v<T> &&
+                             std::is_default_constructible_v<T> &&
+                             sizeof(T) <= kMaxSeqLockObjectSize;
+
+}  // namespace internal
+
+// A wrapper for an object instance that can be read or written atomically.
+//
+// Stored objects are immutable snapshots. LoadSnapshot() gives a view of the
+// current one without locking or copying; Store() publishes a new one, and
+// the old one is deleted once no view refers to it. Small trivially copyable
+// types are instead kept in a SeqLock, and only support Load() and Store().
+template <typename T, typename Enable = void>
 class AtomicObject {
  public:
-  AtomicObject() = default;
-  explicit AtomicObject(T object) : object_(object) {}
+  // A view of the object that was current when it was taken. Valid until it
+  // is destroyed, whatever is stored meanwhile, even if the AtomicObject is
+  // destroyed first.
+  class Snapshot {
+   public:
+    explicit Snapshot(const AtomicObject& source)
+        : object_(hazard_.Protect(source.object_)) {}
+
+    const T& operator*() const { return *object_; }
+    const T* operator->() const { return object_; }
+    const T* get() const { return object_; }
+
+   private:
+    internal::HazardPointer hazard_;
+    const T* const object_;
+
+    BASE_DISALLOW_COPY_AND_ASSIGN(Snapshot);
+  };
+
+  AtomicObject() : object_(new T()) {}
+  explicit AtomicObject(T object) : object_(new T(std::move(object))) {}
 
-  T Load() const {
-    std::scoped_lock lock(mutex_);
-    return object_;
+  ~AtomicObject() { Retire(object_.load(std::memory_order_relaxed)); }
+
+  T Load() const { return *Snapshot(*this); }
+
+  Snapshot LoadSnapshot() const { return Snapshot(*this); }
+
+  void Store(T object) {
+    Retire(object_.exchange(new T(std::move(object))));
   }
 
-  void Store(const T& object) {
-    std::scoped_lock lock(mutex_);
-    object_ = object;
+ private:
+  static void Retire(const T* object) {
+    internal::RetireObject(object, [](const void* retired) {
+      delete static_cast<const T*>(retired);
+    });
   }
 
+  std::atomic<const T*> object_;
+
+  BASE_DISALLOW_COPY_AND_ASSIGN(AtomicObject);
+};
+
+template <typename T>
+class AtomicObject<T, std::enable_if_t<internal::kUseSeqLock<T>>> {
+ public:
+  AtomicObject() = default;
+  explicit AtomicObject(T object) : object_(object) {}
+
+  T Load() const { return object_.Load(); }
+
+  void Store(const T& object) { object_.Store(object); }
+
  private:
-  mutable std::mutex mutex_;
-  T object_;
+  SeqLock<T> object_;
 };
 
 }  // namespace base
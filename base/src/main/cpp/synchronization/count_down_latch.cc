@@ -1,22 +1,47 @@
 #include "count_down_latch.h"
 
+#include "../logging.h"
+#include "futex.h"
+
 namespace base {
 
-CountDownLatch::CountDownLatch(size_t count) : count_(count) {
-  if (count_ == 0) {
-    waitable_event_.Signal();
-  }
+CountDownLatch::CountDownLatch(size_t count)
+    : state_(static_cast<uint32_t>(count) * kCountUnit) {
+  BASE_DCHECK(count < (size_t{1} << 31));
 }
 
 CountDownLatch::~CountDownLatch() = default;
 
 void CountDownLatch::Wait() {
-  waitable_event_.Wait();
+  uint32_t state = state_.load(std::memory_order_acquire);
+  for (int i = 0; i < internal::kSpinCount && state >= kCountUnit; i++) {
+    internal::SpinPause();
+    state = state_.load(std::memory_order_acquire);
+  }
+  while (state >= kCountUnit) {
+    if (!(state & kHasWaiters) &&
+        !state_.compare_exchange_weak(state, state | kHasWaiters,
+                                      std::memory_order_relaxed)) {
+      continue;
+    }
+    internal::FutexWait(&state_, state | kHasWaiters, nullptr);
+    state = state_.load(std::memory_order_acquire);
+  }
 }
 
 void CountDownLatch::CountDown() {
-  if (--count_ == 0) {
-    waitable_event_.Signal();
+  // Counting down an open latch leaves it open, as it did before the count
+  // moved into |state_|; a plain fetch_sub would wrap and close it again.
+  uint32_t state = state_.load(std::memory_order_relaxed);
+  do {
+    if (state < kCountUnit) {
+      return;
+    }
+  } while (!state_.compare_exchange_weak(state, state - kCountUnit,
+                                         std::memory_order_acq_rel,
+                                         std::memory_order_relaxed));
+  if (state == (kCountUnit | kHasWaiters)) {
+    internal::FutexWake(&state_, INT32_MAX);
   }
 }
 
@@ -1,26 +1,33 @@
 #ifndef SYNCHRONIZATION_COUNT_DOWN_LATCH_H_
 #define SYNCHRONIZATION_COUNT_DOWN_LATCH_H_
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include <atomic>
 
 #include "../macros.h"
-#include "waitable_event.h"
 
 namespace base {
 
 class CountDownLatch {
  public:
+  // |count| must be below 2^31.
   explicit CountDownLatch(size_t count);
 
   ~CountDownLatch();
 
   void Wait();
 
+  // Does nothing once the count has reached zero.
   void CountDown();
 
  private:
-  std::atomic_size_t count_;
-  ManualResetWaitableEvent waitable_event_;
+  // The count, in units of |kCountUnit|, and in bit 0 whether threads are
+  // parked, so that only the last CountDown() with waiters enters the kernel.
+  static constexpr uint32_t kHasWaiters = 1;
+  static constexpr uint32_t kCountUnit = 2;
+  std::atomic<uint32_t> state_;
 
   BASE_DISALLOW_COPY_AND_ASSIGN(CountDownLatch);
 };
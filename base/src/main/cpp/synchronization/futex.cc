@@ -0,0 +1,103 @@
+#include "futex.h"
+
+#include <errno.h>
+
+#include <algorithm>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#endif
+
+namespace base {
+namespace internal {
+
+struct timespec MonotonicDeadline(TimeDelta timeout) {
+  // About 36 years past boot still fits a 32-bit time_t.
+  constexpr int64_t kMaxTimeout = int64_t{1} << 60;
+  const int64_t timeout_nanos =
+      std::clamp<int64_t>(timeout.ToNanoseconds(), 0, kMaxTimeout);
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  const int64_t nanos = now.tv_nsec + timeout_nanos % 1000000000;
+  struct timespec deadline;
+  deadline.tv_sec = now.tv_sec + timeout_nanos / 1000000000 +
+                    nanos / 1000000000;
+  deadline.tv_nsec = nanos % 1000000000;
+  return deadline;
+}
+
+#if defined(__linux__)
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+              "futex words must be plain 32-bit integers");
+
+bool FutexWait(std::atomic<uint32_t>* word,
+               uint32_t expected,
+               const struct timespec* deadline) {
+  // FUTEX_WAIT_BITSET takes an absolute CLOCK_MONOTONIC deadline, so
+  // spurious wakeups need no recomputation of the timeout.
+  const long result =
+      syscall(SYS_futex, reinterpret_cast<uint32_t*>(word),
+              FUTEX_WAIT_BITSET | FUTEX_PRIVATE_FLAG, expected, deadline,
+              nullptr, FUTEX_BITSET_MATCH_ANY);
+  return result == 0 || errno != ETIMEDOUT;
+}
+
+void FutexWake(std::atomic<uint32_t>* word, int count) {
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(word),
+          FUTEX_WAKE | FUTEX_PRIVATE_FLAG, count, nullptr, nullptr, 0);
+}
+
+#else
+
+namespace {
+
+struct alignas(64) ParkingBucket {
+  std::mutex mutex;
+  std::condition_variable cv;
+};
+
+ParkingBucket& GetParkingBucket(const void* address) {
+  static ParkingBucket* buckets = new ParkingBucket[64];
+  return buckets[(reinterpret_cast<uintptr_t>(address) >> 4) % 64];
+}
+
+}  // namespace
+
+bool FutexWait(std::atomic<uint32_t>* word,
+               uint32_t expected,
+               const struct timespec* deadline) {
+  ParkingBucket& bucket = GetParkingBucket(word);
+  std::unique_lock<std::mutex> lock(bucket.mutex);
+  if (word->load(std::memory_order_relaxed) != expected) {
+    return true;
+  }
+  if (deadline == nullptr) {
+    bucket.cv.wait(lock);
+    return true;
+  }
+  const struct timespec now = MonotonicDeadline(TimeDelta::Zero());
+  const int64_t remaining = (deadline->tv_sec - now.tv_sec) * 1000000000 +
+                            (deadline->tv_nsec - now.tv_nsec);
+  return bucket.cv.wait_for(lock, std::chrono::nanoseconds(remaining)) ==
+         std::cv_status::no_timeout;
+}
+
+void FutexWake(std::atomic<uint32_t>* word, int count) {
+  ParkingBucket& bucket = GetParkingBucket(word);
+  // Taking the lock orders the wake after a waiter's check of |word|.
+  std::scoped_lock lock(bucket.mutex);
+  // Other words share the bucket, so every waiter has to look.
+  bucket.cv.notify_all();
+}
+
+#endif
+
+}  // namespace internal
+}  // namespace base
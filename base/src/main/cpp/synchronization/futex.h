@@ -0,0 +1,46 @@
+#ifndef SYNCHRONIZATION_FUTEX_H_
+#define SYNCHRONIZATION_FUTEX_H_
+
+#include <stdint.h>
+#include <time.h>
+
+#include <atomic>
+
+#include "../time/time_delta.h"
+
+namespace base {
+namespace internal {
+
+// How many times the synchronization primitives poll before they park the
+// thread. Short enough to cost less than a futex round trip.
+constexpr int kSpinCount = 100;
+
+// Tells the CPU the calling thread is spinning.
+inline void SpinPause() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+  asm volatile("yield");
+#endif
+}
+
+// Returns the CLOCK_MONOTONIC time |timeout| from now.
+struct timespec MonotonicDeadline(TimeDelta timeout);
+
+// Blocks while |*word| is |expected|, until FutexWake() is called on |word|
+// or the CLOCK_MONOTONIC time |deadline|, if not null, passes. May also
+// return spuriously. Returns false only if the deadline passed.
+//
+// This is futex(2) on Linux and Android. Elsewhere, waiters park on one of a
+// fixed set of condition variables, picked by address.
+bool FutexWait(std::atomic<uint32_t>* word,
+               uint32_t expected,
+               const struct timespec* deadline);
+
+// Wakes up to |count| threads blocked in FutexWait() on |word|.
+void FutexWake(std::atomic<uint32_t>* word, int count);
+
+}  // namespace internal
+}  // namespace base
+
+#endif  // SYNCHRONIZATION_FUTEX_H_
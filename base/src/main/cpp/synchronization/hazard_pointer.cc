@@ -0,0 +1,168 @@
+#include "hazard_pointer.h"
+
+#include <algorithm>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace base {
+namespace internal {
+
+namespace {
+
+struct RetiredObject {
+  const void* object;
+  void (*deleter)(const void*);
+};
+
+class HazardDomain {
+ public:
+  static HazardDomain& Get() {
+    // Leaked, so that threads exiting late can still hand back records.
+    static HazardDomain* domain = new HazardDomain();
+    return *domain;
+  }
+
+  HazardRecord* Acquire() {
+    for (HazardRecord* record = head_.load(std::memory_order_acquire);
+         record != nullptr; record = record->next) {
+      bool in_use = false;
+      if (!record->in_use.load(std::memory_order_relaxed) &&
+          record->in_use.compare_exchange_strong(in_use, true,
+                                                 std::memory_order_acquire)) {
+        return record;
+      }
+    }
+    HazardRecord* record = new HazardRecord();
+    record->in_use.store(true, std::memory_order_relaxed);
+    record->next = head_.load(std::memory_order_relaxed);
+    while (!head_.compare_exchange_weak(record->next, record,
+                                        std::memory_order_release,
+                                        std::memory_order_relaxed)) {
+    }
+    return record;
+  }
+
+  void Release(HazardRecord* record) {
+    record->in_use.store(false, std::memory_order_release);
+  }
+
+  void Retire(const void* object, void (*deleter)(const void*)) {
+    std::vector<RetiredObject> reclaimable;
+    {
+      std::scoped_lock lock(mutex_);
+      retired_.push_back({object, deleter});
+      Scan(&reclaimable);
+    }
+    // Outside the lock, in case a deleter retires objects of its own.
+    Delete(reclaimable);
+  }
+
+  // Whether objects were still protected at the last scan.
+  bool HasRetired() const { return has_retired_.load(); }
+
+  // Frees the retired objects that are no longer protected. Called when a
+  // HazardPointer lets go while HasRetired(), so that objects protected at
+  // their Retire() do not wait for the next one.
+  void Rescan() {
+    std::vector<RetiredObject> reclaimable;
+    {
+      std::scoped_lock lock(mutex_);
+      Scan(&reclaimable);
+    }
+    Delete(reclaimable);
+  }
+
+ private:
+  HazardDomain() = default;
+
+  // Moves the objects in |retired_| that no hazard points to into
+  // |reclaimable|. Must hold |mutex_|.
+  void Scan(std::vector<RetiredObject>* reclaimable) {
+    // Set before the hazards are read, and sequentially consistent like the
+    // store that clears a hazard: either the scan sees a hazard cleared, or
+    // the HazardPointer that cleared it sees the flag and rescans.
+    has_retired_.store(true);
+    std::vector<const void*> hazards;
+    for (HazardRecord* record = head_.load(std::memory_order_acquire);
+         record != nullptr; record = record->next) {
+      if (const void* hazard = record->hazard.load()) {
+        hazards.push_back(hazard);
+      }
+    }
+    std::sort(hazards.begin(), hazards.end());
+    auto protected_end = std::partition(
+        retired_.begin(), retired_.end(),
+        [&hazards](const RetiredObject& retired) {
+          return std::binary_search(hazards.begin(), hazards.end(),
+                                    retired.object);
+        });
+    reclaimable->assign(protected_end, retired_.end());
+    retired_.erase(protected_end, retired_.end());
+    has_retired_.store(!retired_.empty());
+  }
+
+  static void Delete(const std::vector<RetiredObject>& reclaimable) {
+    for (const RetiredObject& retired : reclaimable) {
+      retired.deleter(retired.object);
+    }
+  }
+
+  std::atomic<HazardRecord*> head_{nullptr};
+  std::atomic<bool> has_retired_{false};
+  std::mutex mutex_;
+  // Objects that were protected when last scanned.
+  std::vector<RetiredObject> retired_;
+};
+
+// A record the calling thread keeps for its next HazardPointer. These are
+// trivially destructible, so they stay usable while other thread-locals are
+// destroyed at thread exit.
+thread_local HazardRecord* t_cached_record = nullptr;
+thread_local bool t_exiting = false;
+
+struct RecordRetirer {
+  ~RecordRetirer() {
+    if (t_cached_record != nullptr) {
+      HazardDomain::Get().Release(t_cached_record);
+    }
+    t_cached_record = nullptr;
+    t_exiting = true;
+  }
+};
+
+thread_local RecordRetirer t_retirer;
+
+HazardRecord* AcquireRecord() {
+  if (HazardRecord* record = std::exchange(t_cached_record, nullptr)) {
+    return record;
+  }
+  return HazardDomain::Get().Acquire();
+}
+
+}  // namespace
+
+HazardPointer::HazardPointer() : record_(AcquireRecord()) {}
+
+HazardPointer::~HazardPointer() {
+  // Sequentially consistent, paired with the flag set by a scan.
+  record_->hazard.store(nullptr);
+  HazardDomain& domain = HazardDomain::Get();
+  if (domain.HasRetired()) {
+    domain.Rescan();
+  }
+  if (t_cached_record == nullptr && !t_exiting) {
+    // Constructs the retirer, which hands the record back at thread exit.
+    static_cast<void>(&t_retirer);
+    t_cached_record = record_;
+  } else {
+    HazardDomain::Get().Release(record_);
+  }
+}
+
+void RetireObject(const void* object, void (*deleter)(const void*)) {
+  HazardDomain::Get().Retire(object, deleter);
+}
+
+}  // namespace internal
+}  // namespace base
@@ -0,0 +1,60 @@
+#ifndef SYNCHRONIZATION_HAZARD_POINTER_H_
+#define SYNCHRONIZATION_HAZARD_POINTER_H_
+
+#include <atomic>
+
+#include "../macros.h"
+
+namespace base {
+namespace internal {
+
+// One published hazard pointer. Records are never freed; a thread keeps one
+// cached and hands it back to the shared list when it exits.
+struct alignas(64) HazardRecord {
+  std::atomic<const void*> hazard{nullptr};
+  std::atomic<bool> in_use{false};
+  HazardRecord* next = nullptr;
+};
+
+// Keeps the object it protects from being deleted by RetireObject() until it
+// is destroyed or protects something else. Lock-free; the calling thread
+// pays one sequentially consistent store and load per Protect(), and as
+// many on destruction, which also frees retired objects nothing protects
+// any more.
+class HazardPointer {
+ public:
+  HazardPointer();
+  ~HazardPointer();
+
+  // Loads |source| and protects the object it points to. The object must
+  // only be deleted through RetireObject() once it is no longer in |source|.
+  template <typename T>
+  T* Protect(const std::atomic<T*>& source) {
+    T* object = source.load(std::memory_order_relaxed);
+    while (true) {
+      // Sequentially consistent, like the exchange and the scan of a writer:
+      // either the writer sees the hazard, or the reload sees its exchange.
+      record_->hazard.store(object);
+      T* current = source.load();
+      if (current == object) {
+        return object;
+      }
+      object = current;
+    }
+  }
+
+ private:
+  HazardRecord* const record_;
+
+  BASE_DISALLOW_COPY_AND_ASSIGN(HazardPointer);
+};
+
+// Calls |deleter| on |object|, now or when the last HazardPointer protecting
+// it is destroyed.
+// |object| must no longer be reachable by new Protect() calls.
+void RetireObject(const void* object, void (*deleter)(const void*));
+
+}  // namespace internal
+}  // namespace base
+
+#endif  // SYNCHRONIZATION_HAZARD_POINTER_H_
@@ -0,0 +1,33 @@
+#ifndef SYNCHRONIZATION_READER_SLOT_H_
+#define SYNCHRONIZATION_READER_SLOT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+namespace base {
+namespace internal {
+
+// Hands threads out round robin, so the first |slot_count| threads to take a
+// shared lock get a counter each. Shared by SyncSwitch and
+// SharedMutexDistributed; a thread keeps the same index in both.
+inline std::atomic<uint32_t> g_next_reader_slot{0};
+
+// The reader slot of the calling thread, plus one; zero until it is picked.
+inline thread_local uint32_t t_reader_slot = 0;
+
+// Returns the calling thread's index into an array of |slot_count| reader
+// counters.
+inline size_t GetReaderSlot(size_t slot_count) {
+  if (t_reader_slot == 0) {
+    t_reader_slot =
+        g_next_reader_slot.fetch_add(1, std::memory_order_relaxed) + 1;
+  }
+  return (t_reader_slot - 1) % slot_count;
+}
+
+}  // namespace internal
+}  // namespace base
+
+#endif  // SYNCHRONIZATION_READER_SLOT_H_
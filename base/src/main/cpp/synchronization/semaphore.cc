@@ -1,83 +1,57 @@
 #include "semaphore.h"
 
-#include <semaphore.h>
-#include "../eintr_wrapper.h"
-#include "../logging.h"
+#include "futex.h"
 
 namespace base {
 
-class PlatformSemaphore {
- public:
-  explicit PlatformSemaphore(uint32_t count)
-      : valid_(::sem_init(&sem_, 0 /* not shared */, count) == 0) {}
-
-  ~PlatformSemaphore() {
-    if (valid_) {
-      int result = ::sem_destroy(&sem_);
-      (void)result;
-      // Can only be EINVAL which should not be possible since we checked for
-      // validity.
-      BASE_DCHECK(result == 0);
-    }
-  }
-
-  bool IsValid() const { return valid_; }
-
-  bool Wait() {
-    if (!valid_) {
-      return false;
-    }
-
-    return BASE_HANDLE_EINTR(::sem_wait(&sem_)) == 0;
-  }
-
-  bool TryWait() {
-    if (!valid_) {
-      return false;
-    }
-
-    return BASE_HANDLE_EINTR(::sem_trywait(&sem_)) == 0;
-  }
-
-  void Signal() {
-    if (!valid_) {
-      return;
-    }
-
-    ::sem_post(&sem_);
-
-    return;
-  }
-
- private:
-  bool valid_;
-  sem_t sem_;
-
-  BASE_DISALLOW_COPY_AND_ASSIGN(PlatformSemaphore);
-};
-
-}  // namespace base
-
-namespace base {
-
-Semaphore::Semaphore(uint32_t count) : impl_(new PlatformSemaphore(count)) {}
+Semaphore::Semaphore(uint32_t count) : count_(count) {}
 
 Semaphore::~Semaphore() = default;
 
 bool Semaphore::IsValid() const {
-  return impl_->IsValid();
+  return true;
 }
 
 bool Semaphore::Wait() {
-  return impl_->Wait();
+  for (int i = 0; i < internal::kSpinCount; i++) {
+    if (TryWait()) {
+      return true;
+    }
+    internal::SpinPause();
+  }
+  // Sequentially consistent, like the accesses in Signal(): either Signal()
+  // sees this waiter, or this waiter sees the count it raised.
+  waiters_.fetch_add(1);
+  uint32_t count = count_.load();
+  while (true) {
+    if (count == 0) {
+      internal::FutexWait(&count_, 0, nullptr);
+      count = count_.load();
+    } else if (count_.compare_exchange_weak(count, count - 1)) {
+      break;
+    }
+  }
+  waiters_.fetch_sub(1, std::memory_order_relaxed);
+  return true;
 }
 
 bool Semaphore::TryWait() {
-  return impl_->TryWait();
+  uint32_t count = count_.load(std::memory_order_relaxed);
+  while (count > 0) {
+    if (count_.compare_exchange_weak(count, count - 1,
+                                     std::memory_order_acquire,
+                                     std::memory_order_relaxed)) {
+      return true;
+    }
+  }
+  return false;
 }
 
 void Semaphore::Signal() {
-  return impl_->Signal();
+  count_.fetch_add(1);
+  if (waiters_.load() > 0) {
+    internal::FutexWake(&count_, 1);
+  }
 }
 
 }  // namespace base
@@ -1,13 +1,14 @@
 #ifndef SYNCHRONIZATION_SEMAPHORE_H_
 #define SYNCHRONIZATION_SEMAPHORE_H_
 
-#include <memory>
+#include <stdint.h>
+
+#include <atomic>
+
 #include "../macros.h"
 
 namespace base {
 
-class PlatformSemaphore;
-
 //------------------------------------------------------------------------------
 /// @brief      A traditional counting semaphore.  `Wait`s decrement the counter
 ///             and `Signal` increments it.
@@ -17,15 +18,15 @@ class PlatformSemaphore;
 ///             that point, this class should become obsolete and must be
 ///             replaced.
 ///
+///             The count lives in a futex word (see futex.h): `Wait`s spin
+///             briefly before they park, and `Signal` takes no lock and only
+///             enters the kernel when a thread is parked.
+///
 class Semaphore {
  public:
   //----------------------------------------------------------------------------
   /// @brief      Initializes the counting semaphore to a specified start count.
   ///
-  /// @warning    Callers must check if the handle could be successfully created
-  ///             by calling the `IsValid` method. `Wait`s on an invalid
-  ///             semaphore will always fail and signals will fail silently.
-  ///
   /// @param[in]  count  The starting count of the counting semaphore.
   ///
   explicit Semaphore(uint32_t count);
@@ -36,20 +37,19 @@ class Semaphore {
   ~Semaphore();
 
   //----------------------------------------------------------------------------
-  /// @brief      Check if the underlying semaphore handle could be created.
-  ///             Failure modes are platform specific and may occur due to issue
-  ///             like handle exhaustion. All `Wait`s on invalid semaphore
-  ///             handles will fail and `Signal` calls will be ignored.
+  /// @brief      Futex semaphores need no handle, so there is nothing that
+  ///             can fail to be created. Kept for callers written against
+  ///             handle-based semaphores.
   ///
-  /// @return     True if valid, False otherwise.
+  /// @return     Always true.
   ///
   bool IsValid() const;
 
   //----------------------------------------------------------------------------
-  /// @brief      Decrements the count and waits indefinitely if the value is
-  ///             less than zero for a `Signal`.
+  /// @brief      Decrements the count, first waiting indefinitely for a
+  ///             `Signal` if it is zero.
   ///
-  /// @return     If the `Wait` call was successful. See `IsValid` for failure.
+  /// @return     Always true.
   ///
   [[nodiscard]] bool Wait();
 
@@ -57,10 +57,6 @@ class Semaphore {
   /// @brief      Decrement the counts if it is greater than zero. Returns false
   ///             if the counter is already at zero.
   ///
-  /// @warning    False is also returned if the semaphore handle is invalid.
-  ///             Which makes doing the validity check before this call doubly
-  ///             important.
-  ///
   /// @return     If the count could be decremented.
   ///
   [[nodiscard]] bool TryWait();
@@ -72,7 +68,9 @@ class Semaphore {
   void Signal();
 
  private:
-  std::unique_ptr<PlatformSemaphore> impl_;
+  std::atomic<uint32_t> count_;
+  // Threads parked in `Wait`, so that `Signal` can skip the wake-up call.
+  std::atomic<uint32_t> waiters_{0};
 
   BASE_DISALLOW_COPY_AND_ASSIGN(Semaphore);
 };
@@ -0,0 +1,111 @@
+#ifndef SYNCHRONIZATION_SEQ_LOCK_H_
+#define SYNCHRONIZATION_SEQ_LOCK_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <atomic>
+#include <thread>
+#include <type_traits>
+
+#include "../macros.h"
+#include "futex.h"
+
+namespace base {
+
+// A sequence lock around a small trivially copyable value. Readers never
+// write shared memory: they copy the value and retry if a writer was busy
+// meanwhile, so they scale with the number of cores but can be held back by
+// a steady stream of writes. Writers exclude each other.
+//
+//   SeqLock<Stats> stats;
+//   stats.Store({requests, bytes});  // Any thread.
+//   Stats snapshot = stats.Load();   // Any thread, never blocks a writer.
+template <typename T>
+class SeqLock {
+ public:
+  static_assert(std::is_trivially_copyable_v<T> &&
+                    std::is_default_constructible_v<T>,
+                "SeqLock copies the value with memcpy");
+
+  SeqLock() : SeqLock(T()) {}
+
+  explicit SeqLock(const T& value) { CopyIn(value); }
+
+  T Load() const {
+    for (int attempt = 1;; attempt++) {
+      const uint32_t sequence = sequence_.load(std::memory_order_acquire);
+      if (sequence & 1) {
+        Backoff(attempt);
+        continue;
+      }
+      T value = CopyOut();
+      // Orders the copy before the check that no writer interfered.
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (sequence_.load(std::memory_order_relaxed) == sequence) {
+        return value;
+      }
+    }
+  }
+
+  void Store(const T& value) {
+    uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+    for (int attempt = 1;; attempt++) {
+      if (sequence & 1) {
+        Backoff(attempt);
+        sequence = sequence_.load(std::memory_order_relaxed);
+      } else if (sequence_.compare_exchange_weak(sequence, sequence + 1,
+                                                 std::memory_order_acquire,
+                                                 std::memory_order_relaxed)) {
+        break;
+      }
+    }
+    // Orders the odd sequence before the writes that readers might see.
+    std::atomic_thread_fence(std::memory_order_release);
+    CopyIn(value);
+    sequence_.store(sequence + 2, std::memory_order_release);
+  }
+
+ private:
+  // The value lives in atomic words, so that a reader racing with a writer
+  // reads torn data it then discards rather than causing undefined behavior.
+  static constexpr size_t kWords = (sizeof(T) + 7) / 8;
+
+  // Waits for a writer to finish. Yields once spinning has not helped, in
+  // case the writer is not running.
+  static void Backoff(int attempt) {
+    if (attempt < internal::kSpinCount) {
+      internal::SpinPause();
+    } else {
+      std::this_thread::yield();
+    }
+  }
+
+  void CopyIn(const T& value) {
+    uint64_t words[kWords] = {};
+    memcpy(words, &value, sizeof(T));
+    for (size_t i = 0; i < kWords; i++) {
+      words_[i].store(words[i], std::memory_order_relaxed);
+    }
+  }
+
+  T CopyOut() const {
+    uint64_t words[kWords];
+    for (size_t i = 0; i < kWords; i++) {
+      words[i] = words_[i].load(std::memory_order_relaxed);
+    }
+    T value;
+    memcpy(&value, words, sizeof(T));
+    return value;
+  }
+
+  std::atomic<uint32_t> sequence_{0};
+  std::atomic<uint64_t> words_[kWords];
+
+  BASE_DISALLOW_COPY_AND_ASSIGN(SeqLock);
+};
+
+}  // namespace base
+
+#endif  // SYNCHRONIZATION_SEQ_LOCK_H_
@@ -0,0 +1,21 @@
+#include "shared_mutex.h"
+
+#include "shared_mutex_distributed.h"
+#include "shared_mutex_std.h"
+#include "shared_mutex_ticket.h"
+
+namespace base {
+
+SharedMutex* SharedMutex::Create(SharedMutexType type) {
+  switch (type) {
+    case SharedMutexType::kDistributed:
+      return new SharedMutexDistributed();
+    case SharedMutexType::kTicket:
+      return new SharedMutexTicket();
+    case SharedMutexType::kStd:
+      break;
+  }
+  return new SharedMutexStd();
+}
+
+}  // namespace base
@@ -3,10 +3,24 @@
 
 namespace base {
 
-// Interface for a reader/writer lock.
+// The implementations SharedMutex::Create() can pick from.
+enum class SharedMutexType {
+  // std::shared_timed_mutex. All threads share its state.
+  kStd,
+  // Readers count themselves in one of many cache-line-sized slots, so
+  // readers on different cores do not contend, at the price of writers
+  // scanning every slot. For read-mostly data read from many threads.
+  kDistributed,
+  // Writers take tickets and lock in order. A waiting writer holds back new
+  // readers, so writers never starve.
+  kTicket,
+};
+
+// Interface for a reader/writer lock. See also SeqLock, for small trivially
+// copyable data.
 class SharedMutex {
  public:
-  static SharedMutex* Create();
+  static SharedMutex* Create(SharedMutexType type = SharedMutexType::kStd);
   virtual ~SharedMutex() = default;
 
   virtual void Lock() = 0;
@@ -0,0 +1,75 @@
+// Read-mostly contention benchmark for the SharedMutex implementations and
+// SeqLock. Build with -DBASE_BUILD_BENCHMARKS=ON. Every thread does one write
+// per kWriteEvery operations and shared reads otherwise.
+
+#include <stdint.h>
+
+#include <benchmark/benchmark.h>
+
+#include "seq_lock.h"
+#include "shared_mutex.h"
+
+namespace base {
+namespace {
+
+constexpr int kWriteEvery = 1000;
+
+struct Config {
+  int64_t a;
+  int64_t b;
+  int64_t c;
+  int64_t d;
+};
+
+// One lock per type, shared by the threads of a run.
+SharedMutex& GetSharedMutex(SharedMutexType type) {
+  static SharedMutex* const mutexes[] = {
+      SharedMutex::Create(SharedMutexType::kStd),
+      SharedMutex::Create(SharedMutexType::kDistributed),
+      SharedMutex::Create(SharedMutexType::kTicket),
+  };
+  return *mutexes[static_cast<int>(type)];
+}
+
+void BM_SharedMutexReadMostly(benchmark::State& state, SharedMutexType type) {
+  static Config config;
+  SharedMutex& mutex = GetSharedMutex(type);
+  int i = 0;
+  for (auto _ : state) {
+    if (++i % kWriteEvery == 0) {
+      UniqueLock lock(mutex);
+      config.a++;
+    } else {
+      SharedLock lock(mutex);
+      benchmark::DoNotOptimize(config.a);
+    }
+  }
+}
+BENCHMARK_CAPTURE(BM_SharedMutexReadMostly, std, SharedMutexType::kStd)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+BENCHMARK_CAPTURE(BM_SharedMutexReadMostly, distributed,
+                  SharedMutexType::kDistributed)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+BENCHMARK_CAPTURE(BM_SharedMutexReadMostly, ticket, SharedMutexType::kTicket)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
+void BM_SeqLockReadMostly(benchmark::State& state) {
+  static SeqLock<Config> seq_lock;
+  int i = 0;
+  for (auto _ : state) {
+    Config config = seq_lock.Load();
+    if (++i % kWriteEvery == 0) {
+      config.a++;
+      seq_lock.Store(config);
+    } else {
+      benchmark::DoNotOptimize(config.a);
+    }
+  }
+}
+BENCHMARK(BM_SeqLockReadMostly)->ThreadRange(1, 64)->UseRealTime();
+
+}  // namespace
+}  // namespace base
@@ -0,0 +1,85 @@
+#include "shared_mutex_distributed.h"
+
+#include <limits>
+
+#include "futex.h"
+#include "reader_slot.h"
+
+namespace base {
+
+void SharedMutexDistributed::Lock() {
+  uint32_t writer = writer_.load(std::memory_order_relaxed);
+  for (int i = 0; i < internal::kSpinCount && writer != 0; i++) {
+    internal::SpinPause();
+    writer = writer_.load(std::memory_order_relaxed);
+  }
+  // Sequentially consistent, like the accesses in LockShared(): either the
+  // reader sees the writer, or the writer sees its count.
+  while (true) {
+    if (writer & kWriterLocked) {
+      WaitForWriter(writer);
+      writer = writer_.load(std::memory_order_relaxed);
+    } else if (writer_.compare_exchange_weak(writer, writer | kWriterLocked)) {
+      break;
+    }
+  }
+  for (ReaderSlot& slot : slots_) {
+    for (int i = 0; i < internal::kSpinCount && slot.readers.load() != 0;
+         i++) {
+      internal::SpinPause();
+    }
+    uint32_t count;
+    while ((count = slot.readers.load()) != 0) {
+      internal::FutexWait(&slot.readers, count, nullptr);
+    }
+  }
+}
+
+void SharedMutexDistributed::LockShared() {
+  ReaderSlot& slot = slots_[internal::GetReaderSlot(kReaderSlots)];
+  while (true) {
+    slot.readers.fetch_add(1);
+    const uint32_t writer = writer_.load();
+    if (!(writer & kWriterLocked)) {
+      return;
+    }
+    // Back off, so that the writer can drain this slot.
+    if (slot.readers.fetch_sub(1) == 1) {
+      internal::FutexWake(&slot.readers, 1);
+    }
+    for (int i = 0; i < internal::kSpinCount &&
+                    (writer_.load(std::memory_order_relaxed) & kWriterLocked);
+         i++) {
+      internal::SpinPause();
+    }
+    const uint32_t current = writer_.load(std::memory_order_relaxed);
+    if (current & kWriterLocked) {
+      WaitForWriter(current);
+    }
+  }
+}
+
+void SharedMutexDistributed::Unlock() {
+  if (writer_.exchange(0, std::memory_order_release) & kHasWaiters) {
+    internal::FutexWake(&writer_, std::numeric_limits<int>::max());
+  }
+}
+
+void SharedMutexDistributed::UnlockShared() {
+  ReaderSlot& slot = slots_[internal::GetReaderSlot(kReaderSlots)];
+  // A writer only waits on the slot once it has announced itself.
+  if (slot.readers.fetch_sub(1) == 1 && (writer_.load() & kWriterLocked)) {
+    internal::FutexWake(&slot.readers, 1);
+  }
+}
+
+void SharedMutexDistributed::WaitForWriter(uint32_t expected) {
+  if (!(expected & kHasWaiters) &&
+      !writer_.compare_exchange_strong(expected, expected | kHasWaiters,
+                                       std::memory_order_relaxed)) {
+    return;
+  }
+  internal::FutexWait(&writer_, expected | kHasWaiters, nullptr);
+}
+
+}  // namespace base
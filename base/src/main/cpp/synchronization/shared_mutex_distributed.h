@@ -0,0 +1,48 @@
+#ifndef SYNCHRONIZATION_SHARED_MUTEX_DISTRIBUTED_H_
+#define SYNCHRONIZATION_SHARED_MUTEX_DISTRIBUTED_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+#include "shared_mutex.h"
+
+namespace base {
+
+// A big-reader lock. Each thread counts itself as a reader in a slot of its
+// own, picked the first time it locks any SharedMutexDistributed, so
+// readers only write their own cache line. A writer announces itself, which
+// turns new readers away, and then waits for every slot to drain.
+class SharedMutexDistributed : public SharedMutex {
+ public:
+  void Lock() override;
+  void LockShared() override;
+  void Unlock() override;
+  void UnlockShared() override;
+
+ private:
+  friend SharedMutex* SharedMutex::Create(SharedMutexType type);
+  SharedMutexDistributed() = default;
+
+  static constexpr size_t kReaderSlots = 32;
+
+  struct alignas(64) ReaderSlot {
+    std::atomic<uint32_t> readers{0};
+  };
+
+  static constexpr uint32_t kWriterLocked = 1;
+  static constexpr uint32_t kHasWaiters = 2;
+
+  // Blocks while |writer_| is |expected|, after flagging that it waits.
+  void WaitForWriter(uint32_t expected);
+
+  // kWriterLocked while a writer holds the lock or waits for readers, and
+  // kHasWaiters while threads wait for it to clear.
+  alignas(64) std::atomic<uint32_t> writer_{0};
+  ReaderSlot slots_[kReaderSlots];
+};
+
+}  // namespace base
+
+#endif  // SYNCHRONIZATION_SHARED_MUTEX_DISTRIBUTED_H_
@@ -3,10 +3,6 @@
 
 namespace base {
 
-SharedMutex* SharedMutex::Create() {
-  return new SharedMutexStd();
-}
-
 void SharedMutexStd::Lock() {
   mutex_.lock();
 }
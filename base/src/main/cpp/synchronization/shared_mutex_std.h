@@ -14,7 +14,7 @@ class SharedMutexStd : public SharedMutex {
   virtual void UnlockShared();
 
  private:
-  friend SharedMutex* SharedMutex::Create();
+  friend SharedMutex* SharedMutex::Create(SharedMutexType type);
   SharedMutexStd() = default;
 
   std::shared_timed_mutex mutex_;
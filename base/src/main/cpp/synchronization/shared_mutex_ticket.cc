@@ -0,0 +1,91 @@
+#include "shared_mutex_ticket.h"
+
+#include <limits>
+
+#include "futex.h"
+
+namespace base {
+
+void SharedMutexTicket::Lock() {
+  // Announcing the writer first turns new readers away while it queues.
+  state_.fetch_add(kWriter, std::memory_order_relaxed);
+  const uint32_t ticket =
+      next_ticket_.fetch_add(1, std::memory_order_relaxed);
+  uint32_t serving;
+  for (int i = 0; (serving = serving_ticket_.load(
+                       std::memory_order_acquire)) != ticket;
+       i++) {
+    if (i < internal::kSpinCount) {
+      internal::SpinPause();
+    } else {
+      Wait(&serving_ticket_, serving);
+    }
+  }
+  // Only readers that locked before the announcement can remain.
+  uint32_t state;
+  for (int i = 0; ((state = state_.load(std::memory_order_acquire)) &
+                   ~kWriterMask) != 0;
+       i++) {
+    if (i < internal::kSpinCount) {
+      internal::SpinPause();
+    } else {
+      Wait(&state_, state);
+    }
+  }
+}
+
+void SharedMutexTicket::LockShared() {
+  uint32_t state = state_.load(std::memory_order_relaxed);
+  for (int i = 0;; i++) {
+    if ((state & kWriterMask) != 0) {
+      if (i < internal::kSpinCount) {
+        internal::SpinPause();
+      } else {
+        Wait(&state_, state);
+      }
+      state = state_.load(std::memory_order_relaxed);
+    } else if (state_.compare_exchange_weak(state, state + kReader,
+                                            std::memory_order_acquire,
+                                            std::memory_order_relaxed)) {
+      return;
+    }
+  }
+}
+
+void SharedMutexTicket::Unlock() {
+  // This and the other changes to the words threads wait on are
+  // sequentially consistent, like the accesses in Wait().
+  serving_ticket_.fetch_add(1);
+  WakeAll(&serving_ticket_);
+  // The last writer out lets the readers in.
+  if ((state_.fetch_sub(kWriter) & kWriterMask) == kWriter) {
+    WakeAll(&state_);
+  }
+}
+
+void SharedMutexTicket::UnlockShared() {
+  const uint32_t state = state_.fetch_sub(kReader);
+  // The last reader out lets a waiting writer in.
+  if ((state & ~kWriterMask) == kReader && (state & kWriterMask) != 0) {
+    WakeAll(&state_);
+  }
+}
+
+void SharedMutexTicket::Wait(std::atomic<uint32_t>* word,
+                             uint32_t expected) {
+  // Sequentially consistent: either the waker sees this waiter, or this
+  // waiter sees the word it changed.
+  waiters_.fetch_add(1);
+  if (word->load() == expected) {
+    internal::FutexWait(word, expected, nullptr);
+  }
+  waiters_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void SharedMutexTicket::WakeAll(std::atomic<uint32_t>* word) {
+  if (waiters_.load() != 0) {
+    internal::FutexWake(word, std::numeric_limits<int>::max());
+  }
+}
+
+}  // namespace base
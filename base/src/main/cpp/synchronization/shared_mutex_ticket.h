@@ -0,0 +1,48 @@
+#ifndef SYNCHRONIZATION_SHARED_MUTEX_TICKET_H_
+#define SYNCHRONIZATION_SHARED_MUTEX_TICKET_H_
+
+#include <stdint.h>
+
+#include <atomic>
+
+#include "shared_mutex.h"
+
+namespace base {
+
+// A writer-preferring reader/writer lock. Writers take tickets and lock in
+// ticket order. Readers lock shared whenever no writer holds the lock or
+// waits for it, so a waiting writer keeps new readers out and is never
+// starved, and readers do not wait for each other.
+class SharedMutexTicket : public SharedMutex {
+ public:
+  void Lock() override;
+  void LockShared() override;
+  void Unlock() override;
+  void UnlockShared() override;
+
+ private:
+  friend SharedMutex* SharedMutex::Create(SharedMutexType type);
+  SharedMutexTicket() = default;
+
+  // |state_| counts the writers that hold or wait for the lock in its low
+  // half, and the readers that hold it in its high half.
+  static constexpr uint32_t kWriter = 1;
+  static constexpr uint32_t kWriterMask = 0xffff;
+  static constexpr uint32_t kReader = 1 << 16;
+
+  // Blocks while |*word| is |expected|.
+  void Wait(std::atomic<uint32_t>* word, uint32_t expected);
+
+  // Wakes the threads in Wait() on |word|, if there are any.
+  void WakeAll(std::atomic<uint32_t>* word);
+
+  alignas(64) std::atomic<uint32_t> state_{0};
+  std::atomic<uint32_t> waiters_{0};
+  // The next writer ticket to hand out, and the one that may lock.
+  alignas(64) std::atomic<uint32_t> next_ticket_{0};
+  std::atomic<uint32_t> serving_ticket_{0};
+};
+
+}  // namespace base
+
+#endif  // SYNCHRONIZATION_SHARED_MUTEX_TICKET_H_
@@ -1,5 +1,10 @@
 #include "sync_switch.h"
 
+#include <algorithm>
+
+#include "futex.h"
+#include "reader_slot.h"
+
 namespace base {
 
 SyncSwitch::Handlers& SyncSwitch::Handlers::SetIfTrue(
@@ -15,39 +20,97 @@ SyncSwitch::Handlers& SyncSwitch::Handlers::SetIfFalse(
 }
 
 SyncSwitch::SyncSwitch(bool value)
-    : mutex_(std::unique_ptr<base::SharedMutex>(base::SharedMutex::Create())),
-      value_(value) {}
+    : state_(value ? 1 : 0),
+      observers_(std::make_shared<const std::vector<Observer*>>()) {}
 
 void SyncSwitch::Execute(const SyncSwitch::Handlers& handlers) const {
-  base::SharedLock lock(*mutex_);
-  if (value_) {
+  ReaderSlot& slot = slots_[internal::GetReaderSlot(kReaderSlots)];
+  // Registering and then finding |state_| unchanged means SetSwitch() had not
+  // flipped it yet, so it will wait for this reader. All of these accesses
+  // are sequentially consistent, like the flip and the scan in SetSwitch().
+  uint32_t state = state_.load();
+  std::atomic<uint32_t>* readers;
+  while (true) {
+    readers = &slot.readers[(state >> 1) & 1];
+    readers->fetch_add(1);
+    const uint32_t current = state_.load();
+    if (current == state) {
+      break;
+    }
+    // The writer that flipped |state_| may already wait for this count.
+    if (readers->fetch_sub(1) == 1) {
+      internal::FutexWake(readers, 1);
+    }
+    state = current;
+  }
+
+  if (state & 1) {
     handlers.true_handler();
   } else {
     handlers.false_handler();
   }
+
+  // A writer only waits after flipping |state_|, so the last reader of a
+  // parity wakes it only if it can see the flip.
+  if (readers->fetch_sub(1) == 1 && state_.load() != state) {
+    internal::FutexWake(readers, 1);
+  }
 }
 
 void SyncSwitch::SetSwitch(bool value) {
   {
-    base::UniqueLock lock(*mutex_);
-    value_ = value;
+    std::scoped_lock lock(write_mutex_);
+    const uint32_t state = state_.load(std::memory_order_relaxed);
+    if ((state & 1) != (value ? 1u : 0u)) {
+      // The generation keeps a reader that saw |state| two writes ago from
+      // registering under the current parity.
+      state_.store(((state >> 1) + 1) << 1 | (value ? 1 : 0));
+      WaitForReaders((state >> 1) & 1);
+    }
   }
-  for (Observer* observer : observers_) {
+  std::shared_ptr<const std::vector<Observer*>> observers;
+  {
+    std::scoped_lock lock(observers_mutex_);
+    observers = observers_;
+  }
+  for (Observer* observer : *observers) {
     observer->OnSyncSwitchUpdate(value);
   }
 }
 
+void SyncSwitch::WaitForReaders(uint32_t parity) const {
+  for (ReaderSlot& slot : slots_) {
+    std::atomic<uint32_t>& readers = slot.readers[parity];
+    for (int i = 0; i < internal::kSpinCount && readers.load() != 0; i++) {
+      internal::SpinPause();
+    }
+    uint32_t count;
+    while ((count = readers.load()) != 0) {
+      internal::FutexWait(&readers, count, nullptr);
+    }
+  }
+}
+
 void SyncSwitch::AddObserver(Observer* observer) const {
-  base::UniqueLock lock(*mutex_);
-  if (std::find(observers_.begin(), observers_.end(), observer) ==
-      observers_.end()) {
-    observers_.push_back(observer);
+  std::scoped_lock lock(observers_mutex_);
+  if (std::find(observers_->begin(), observers_->end(), observer) ==
+      observers_->end()) {
+    auto observers = std::make_shared<std::vector<Observer*>>(*observers_);
+    observers->push_back(observer);
+    observers_ = std::move(observers);
   }
 }
 
 void SyncSwitch::RemoveObserver(Observer* observer) const {
-  base::UniqueLock lock(*mutex_);
-  observers_.erase(std::remove(observers_.begin(), observers_.end(), observer),
-                   observers_.end());
+  std::scoped_lock lock(observers_mutex_);
+  if (std::find(observers_->begin(), observers_->end(), observer) !=
+      observers_->end()) {
+    auto observers = std::make_shared<std::vector<Observer*>>(*observers_);
+    observers->erase(
+        std::remove(observers->begin(), observers->end(), observer),
+        observers->end());
+    observers_ = std::move(observers);
+  }
 }
+
 }  // namespace base
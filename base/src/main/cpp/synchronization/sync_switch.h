@@ -1,20 +1,29 @@
 #ifndef SYNCHRONIZATION_SYNC_SWITCH_H_
 #define SYNCHRONIZATION_SYNC_SWITCH_H_
 
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include "../macros.h"
-#include "shared_mutex.h"
 
 namespace base {
 
 /// A threadsafe structure that allows you to switch between 2 different
 /// execution paths.
 ///
-/// Execution and setting the switch is exclusive, i.e. only one will happen
-/// at a time.
+/// Execution and setting the switch is exclusive: once |SetSwitch| returns,
+/// no handler that saw the old value is still running, and every later
+/// |Execute| sees the new value.
+///
+/// Reads are RCU-style. |Execute| never blocks; it registers with one of a
+/// few per-switch reader counters, and |SetSwitch| publishes the new value
+/// and then waits for the readers registered under the old one to drain.
 class SyncSwitch {
  public:
   /// Observes changes to the SyncSwitch.
@@ -46,15 +55,17 @@ class SyncSwitch {
 
   /// Diverge execution between true and false values of the SyncSwitch.
   ///
-  /// This can be called on any thread.  Note that attempting to call
-  /// |SetSwitch| inside of the handlers will result in a self deadlock.
+  /// This can be called on any thread, and from inside the handlers of any
+  /// |SyncSwitch|. Note that attempting to call |SetSwitch| inside of the
+  /// handlers will result in a self deadlock.
   ///
   /// @param[in]  handlers  Called for the correct value of the |SyncSwitch|.
   void Execute(const Handlers& handlers) const;
 
   /// Set the value of the SyncSwitch.
   ///
-  /// This can be called on any thread.
+  /// This can be called on any thread. Observers are notified after the
+  /// switch has flipped, outside of any lock.
   ///
   /// @param[in]  value  New value for the |SyncSwitch|.
   void SetSwitch(bool value);
@@ -66,9 +77,27 @@ class SyncSwitch {
   void RemoveObserver(Observer* observer) const;
 
  private:
-  mutable std::unique_ptr<base::SharedMutex> mutex_;
-  mutable std::vector<Observer*> observers_;
-  bool value_;
+  static constexpr size_t kReaderSlots = 8;
+
+  // Readers that saw an even or odd generation of |state_|. Threads are
+  // spread over the slots so that they seldom share a cache line.
+  struct alignas(64) ReaderSlot {
+    std::atomic<uint32_t> readers[2] = {};
+  };
+
+  // Waits until no reader registered under |parity| remains.
+  void WaitForReaders(uint32_t parity) const;
+
+  // The value in the low bit, and in the rest a generation bumped whenever
+  // |SetSwitch| changes the value.
+  std::atomic<uint32_t> state_;
+  mutable ReaderSlot slots_[kReaderSlots];
+  // Serializes |SetSwitch|.
+  std::mutex write_mutex_;
+  // Guards replacing |observers_|, which is copied on write so that
+  // |SetSwitch| can notify a snapshot without holding the lock.
+  mutable std::mutex observers_mutex_;
+  mutable std::shared_ptr<const std::vector<Observer*>> observers_;
 
   BASE_DISALLOW_COPY_AND_ASSIGN(SyncSwitch);
 };
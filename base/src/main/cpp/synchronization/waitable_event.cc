@@ -1,171 +1,145 @@
 #include "waitable_event.h"
 
-#include <cerrno>
-#include <ctime>
-#include "../time/time_delta.h"
-#include "../time/time_point.h"
 #include "../logging.h"
+#include "futex.h"
 
 namespace base {
 
-// Waits with a timeout on |condition()|. Returns true on timeout, or false if
-// |condition()| ever returns true. |condition()| should have no side effects
-// (and will always be called with |*mutex| held).
-template <typename ConditionFn>
-bool WaitWithTimeoutImpl(std::unique_lock<std::mutex>* locker,
-                         std::condition_variable* cv,
-                         ConditionFn condition,
-                         TimeDelta timeout) {
-  BASE_DCHECK(locker->owns_lock());
-
-  if (condition()) {
-    return false;
-  }
-
-  // We may get spurious wakeups.
-  TimeDelta wait_remaining = timeout;
-  TimePoint start = TimePoint::Now();
-  while (true) {
-    if (std::cv_status::timeout ==
-        cv->wait_for(*locker, std::chrono::nanoseconds(
-                                  wait_remaining.ToNanoseconds()))) {
-      return true;  // Definitely timed out.
-    }
-
-    // We may have been awoken.
-    if (condition()) {
-      return false;
-    }
-
-    // Or the wakeup may have been spurious.
-    TimePoint now = TimePoint::Now();
-    BASE_DCHECK(now >= start);
-    TimeDelta elapsed = now - start;
-    // It's possible that we may have timed out anyway.
-    if (elapsed >= timeout) {
-      return true;
-    }
-
-    // Otherwise, recalculate the amount that we have left to wait.
-    wait_remaining = timeout - elapsed;
-  }
-}
-
 // AutoResetWaitableEvent ------------------------------------------------------
 
 void AutoResetWaitableEvent::Signal() {
-  std::scoped_lock locker(mutex_);
-  signaled_ = true;
-  cv_.notify_one();
+  uint32_t state = state_.load(std::memory_order_relaxed);
+  do {
+    if (state & kSignaled) {
+      return;
+    }
+  } while (!state_.compare_exchange_weak(state, state | kSignaled,
+                                         std::memory_order_release,
+                                         std::memory_order_relaxed));
+  if (state >= kWaiter) {
+    internal::FutexWake(&state_, 1);
+  }
 }
 
 void AutoResetWaitableEvent::Reset() {
-  std::scoped_lock locker(mutex_);
-  signaled_ = false;
+  state_.fetch_and(~kSignaled, std::memory_order_relaxed);
 }
 
 void AutoResetWaitableEvent::Wait() {
-  std::unique_lock<std::mutex> locker(mutex_);
-  while (!signaled_) {
-    cv_.wait(locker);
-  }
-  signaled_ = false;
+  WaitUntil(nullptr);
 }
 
 bool AutoResetWaitableEvent::WaitWithTimeout(TimeDelta timeout) {
-  std::unique_lock<std::mutex> locker(mutex_);
-
-  if (signaled_) {
-    signaled_ = false;
-    return false;
-  }
-
-  // We may get spurious wakeups.
-  TimeDelta wait_remaining = timeout;
-  TimePoint start = TimePoint::Now();
-  while (true) {
-    if (std::cv_status::timeout ==
-        cv_.wait_for(
-            locker, std::chrono::nanoseconds(wait_remaining.ToNanoseconds()))) {
-      return true;  // Definitely timed out.
-    }
+  const struct timespec deadline = internal::MonotonicDeadline(timeout);
+  return !WaitUntil(&deadline);
+}
 
-    // We may have been awoken.
-    if (signaled_) {
-      break;
-    }
+bool AutoResetWaitableEvent::IsSignaledForTest() {
+  return state_.load(std::memory_order_relaxed) & kSignaled;
+}
 
-    // Or the wakeup may have been spurious.
-    TimePoint now = TimePoint::Now();
-    BASE_DCHECK(now >= start);
-    TimeDelta elapsed = now - start;
-    // It's possible that we may have timed out anyway.
-    if (elapsed >= timeout) {
+bool AutoResetWaitableEvent::TryConsumeSignal() {
+  uint32_t state = state_.load(std::memory_order_relaxed);
+  while (state & kSignaled) {
+    if (state_.compare_exchange_weak(state, state & ~kSignaled,
+                                     std::memory_order_acquire,
+                                     std::memory_order_relaxed)) {
       return true;
     }
-
-    // Otherwise, recalculate the amount that we have left to wait.
-    wait_remaining = timeout - elapsed;
   }
-
-  signaled_ = false;
   return false;
 }
 
-bool AutoResetWaitableEvent::IsSignaledForTest() {
-  std::scoped_lock locker(mutex_);
-  return signaled_;
+// Returns false on timeout.
+bool AutoResetWaitableEvent::WaitUntil(const struct timespec* deadline) {
+  for (int i = 0; i < internal::kSpinCount; i++) {
+    if (TryConsumeSignal()) {
+      return true;
+    }
+    internal::SpinPause();
+  }
+
+  uint32_t state = state_.fetch_add(kWaiter, std::memory_order_relaxed);
+  state += kWaiter;
+  bool timed_out = false;
+  while (true) {
+    if (state & kSignaled) {
+      // Consumes the signal and stops counting as a waiter at once.
+      if (state_.compare_exchange_weak(state, (state & ~kSignaled) - kWaiter,
+                                       std::memory_order_acquire,
+                                       std::memory_order_relaxed)) {
+        return true;
+      }
+    } else if (timed_out) {
+      // Leaves the signal that may still come for the next waiter, and a
+      // wakeup meant for this thread is not lost: it would have come with
+      // the signaled bit, which is checked first.
+      if (state_.compare_exchange_weak(state, state - kWaiter,
+                                       std::memory_order_relaxed)) {
+        return false;
+      }
+    } else {
+      timed_out = !internal::FutexWait(&state_, state, deadline);
+      state = state_.load(std::memory_order_relaxed);
+    }
+  }
 }
 
 // ManualResetWaitableEvent ----------------------------------------------------
 
 void ManualResetWaitableEvent::Signal() {
-  std::scoped_lock locker(mutex_);
-  signaled_ = true;
-  signal_id_++;
-  cv_.notify_all();
+  uint32_t state = state_.load(std::memory_order_relaxed);
+  // Parked waiters all wake up, so the waiter bit is cleared.
+  while (!state_.compare_exchange_weak(
+      state, ((state + kSignalCountUnit) & ~kHasWaiters) | kSignaled,
+      std::memory_order_release, std::memory_order_relaxed)) {
+  }
+  if (state & kHasWaiters) {
+    internal::FutexWake(&state_, INT32_MAX);
+  }
 }
 
 void ManualResetWaitableEvent::Reset() {
-  std::scoped_lock locker(mutex_);
-  signaled_ = false;
+  state_.fetch_and(~kSignaled, std::memory_order_relaxed);
 }
 
 void ManualResetWaitableEvent::Wait() {
-  std::unique_lock<std::mutex> locker(mutex_);
-
-  if (signaled_) {
-    return;
-  }
-
-  auto last_signal_id = signal_id_;
-  do {
-    cv_.wait(locker);
-  } while (signal_id_ == last_signal_id);
+  WaitUntil(nullptr);
 }
 
 bool ManualResetWaitableEvent::WaitWithTimeout(TimeDelta timeout) {
-  std::unique_lock<std::mutex> locker(mutex_);
-
-  auto last_signal_id = signal_id_;
-  // Disable thread-safety analysis for the lambda: We could annotate it with
-  // |BASE_EXCLUSIVE_LOCKS_REQUIRED(mutex_)|, but then the analyzer currently
-  // isn't able to figure out that |WaitWithTimeoutImpl()| calls it while
-  // holding |mutex_|.
-  bool rv = WaitWithTimeoutImpl(
-      &locker, &cv_,
-      [this, last_signal_id]() {
-        // Also check |signaled_| in case we're already signaled.
-        return signaled_ || signal_id_ != last_signal_id;
-      },
-      timeout);
-  BASE_DCHECK(rv || signaled_ || signal_id_ != last_signal_id);
-  return rv;
+  const struct timespec deadline = internal::MonotonicDeadline(timeout);
+  return !WaitUntil(&deadline);
 }
 
 bool ManualResetWaitableEvent::IsSignaledForTest() {
-  std::scoped_lock locker(mutex_);
-  return signaled_;
+  return state_.load(std::memory_order_relaxed) & kSignaled;
+}
+
+// Returns false on timeout.
+bool ManualResetWaitableEvent::WaitUntil(const struct timespec* deadline) {
+  uint32_t state = state_.load(std::memory_order_acquire);
+  const uint32_t signal_count = state & ~(kSignaled | kHasWaiters);
+  auto signaled = [signal_count](uint32_t state) {
+    return (state & kSignaled) ||
+           (state & ~(kSignaled | kHasWaiters)) != signal_count;
+  };
+  for (int i = 0; i < internal::kSpinCount && !signaled(state); i++) {
+    internal::SpinPause();
+    state = state_.load(std::memory_order_acquire);
+  }
+  while (!signaled(state)) {
+    if (!(state & kHasWaiters) &&
+        !state_.compare_exchange_weak(state, state | kHasWaiters,
+                                      std::memory_order_relaxed)) {
+      continue;
+    }
+    if (!internal::FutexWait(&state_, state | kHasWaiters, deadline)) {
+      return signaled(state_.load(std::memory_order_acquire));
+    }
+    state = state_.load(std::memory_order_acquire);
+  }
+  return true;
 }
 
 }  // namespace base
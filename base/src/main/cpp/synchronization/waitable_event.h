@@ -1,8 +1,10 @@
 #ifndef SYNCHRONIZATION_WAITABLE_EVENT_H_
 #define SYNCHRONIZATION_WAITABLE_EVENT_H_
 
-#include <condition_variable>
-#include <mutex>
+#include <stdint.h>
+#include <time.h>
+
+#include <atomic>
 
 #include "../macros.h"
 #include "../time/time_delta.h"
@@ -16,6 +18,10 @@ namespace base {
 // to Windows's auto-reset Event, which is also imitated by Chromium's
 // auto-reset |base::WaitableEvent|. However, there are some limitations -- see
 // |Signal()|.) This class is thread-safe.
+//
+// Both events keep their state in one futex word (see futex.h): waiters spin
+// briefly before they park, and |Signal()| takes no lock and only enters the
+// kernel when a thread is parked.
 class AutoResetWaitableEvent final {
  public:
   AutoResetWaitableEvent() {}
@@ -29,7 +35,7 @@ class AutoResetWaitableEvent final {
   //   call to |Signal()|.
   // * A |Signal()|, followed by a |Reset()|, may cause *no* waiting thread to
   //   be unblocked.
-  // * We rely on pthreads's queueing for picking which waiting thread to
+  // * We rely on the kernel's queueing for picking which waiting thread to
   //   unblock, rather than enforcing FIFO ordering.
   void Signal();
 
@@ -44,7 +50,7 @@ class AutoResetWaitableEvent final {
 
   // Like |Wait()|, but with a timeout. Also unblocks if |timeout| expires
   // without being signaled in which case it returns true (otherwise, it returns
-  // false).
+  // false). |timeout| is measured on CLOCK_MONOTONIC.
   bool WaitWithTimeout(TimeDelta timeout);
 
   // Returns whether this event is in a signaled state or not. For use in tests
@@ -53,11 +59,15 @@ class AutoResetWaitableEvent final {
   bool IsSignaledForTest();
 
  private:
-  std::condition_variable cv_;
-  std::mutex mutex_;
+  // Consumes the signal, if set, and returns whether it did.
+  bool TryConsumeSignal();
+  bool WaitUntil(const struct timespec* deadline);
 
-  // True if this event is in the signaled state.
-  bool signaled_ = false;
+  // Bit 0 is set while the event is signaled. The other bits count the
+  // parked waiters, in units of |kWaiter|.
+  static constexpr uint32_t kSignaled = 1;
+  static constexpr uint32_t kWaiter = 2;
+  std::atomic<uint32_t> state_{0};
 
   BASE_DISALLOW_COPY_AND_ASSIGN(AutoResetWaitableEvent);
 };
@@ -87,7 +97,7 @@ class ManualResetWaitableEvent final {
 
   // Like |Wait()|, but with a timeout. Also unblocks if |timeout| expires
   // without being signaled in which case it returns true (otherwise, it returns
-  // false).
+  // false). |timeout| is measured on CLOCK_MONOTONIC.
   bool WaitWithTimeout(TimeDelta timeout);
 
   // Returns whether this event is in a signaled state or not. For use in tests
@@ -95,20 +105,18 @@ class ManualResetWaitableEvent final {
   bool IsSignaledForTest();
 
  private:
-  std::condition_variable cv_;
-  std::mutex mutex_;
-
-  // True if this event is in the signaled state.
-  bool signaled_ = false;
-
-  // While |std::condition_variable::notify_all()| (|pthread_cond_broadcast()|)
-  // will wake all waiting threads, one has to deal with spurious wake-ups.
-  // Checking |signaled_| isn't sufficient, since another thread may have been
-  // awoken and (manually) reset |signaled_|. This is a counter that is
-  // incremented in |Signal()| before calling
-  // |std::condition_variable::notify_all()|. A waiting thread knows it was
-  // awoken if |signal_id_| is different from when it started waiting.
-  unsigned signal_id_ = 0u;
+  bool WaitUntil(const struct timespec* deadline);
+
+  // Bit 0 is set while the event is signaled, and bit 1 while threads are
+  // parked. Checking the signaled bit isn't sufficient for a waiter, since
+  // another thread may have (manually) reset the event before the waiter got
+  // to run, so the remaining bits count the |Signal()| calls. A waiting
+  // thread knows it was signaled if the count differs from when it started
+  // waiting.
+  static constexpr uint32_t kSignaled = 1;
+  static constexpr uint32_t kHasWaiters = 2;
+  static constexpr uint32_t kSignalCountUnit = 4;
+  std::atomic<uint32_t> state_{0};
 
   BASE_DISALLOW_COPY_AND_ASSIGN(ManualResetWaitableEvent);
 };
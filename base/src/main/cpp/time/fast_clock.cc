@@ -0,0 +1,281 @@
+#include "fast_clock.h"
+
+#include <stdint.h>
+#include <time.h>
+
+#include <algorithm>
+#include <mutex>
+#include <tuple>
+#include <utility>
+
+#include "../synchronization/seq_lock.h"
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define BASE_FAST_CLOCK_COUNTER 1
+#elif defined(__aarch64__)
+#define BASE_FAST_CLOCK_COUNTER 1
+#endif
+
+namespace base {
+
+namespace {
+
+constexpr int64_t kNanosPerSecond = 1000000000;
+
+int64_t MonotonicNanos(clockid_t clock) {
+  struct timespec now;
+  clock_gettime(clock, &now);
+  return int64_t{now.tv_sec} * kNanosPerSecond + now.tv_nsec;
+}
+
+#if defined(BASE_FAST_CLOCK_COUNTER)
+
+// How long the first calibration measures the counter rate for.
+constexpr int64_t kInitialCalibrationNanos = 2000000;
+
+// How long a calibration is used for before the counter is measured against
+// CLOCK_MONOTONIC again. The first one, from the short initial measurement,
+// is refined sooner.
+constexpr int64_t kCalibrationNanos = kNanosPerSecond;
+constexpr int64_t kFirstCalibrationNanos = 50000000;
+
+// How much of a calibration period the clock may lose to catch up with
+// CLOCK_MONOTONIC when it is ahead, e.g. after the counter ran on during
+// suspend.
+constexpr int64_t kMaxSlewNanos = kCalibrationNanos / 10;
+
+// Ordered after earlier loads, like the kernel's rdtsc_ordered(): otherwise
+// the counter could be read before the calibration it is converted with, and
+// a newer calibration applied to an older reading could run backwards.
+inline uint64_t ReadCounter() {
+#if defined(__x86_64__)
+  _mm_lfence();
+  return __rdtsc();
+#else
+  uint64_t counter;
+  asm volatile("isb; mrs %0, cntvct_el0" : "=r"(counter) : : "memory");
+  return counter;
+#endif
+}
+
+bool CounterIsInvariant() {
+#if defined(__x86_64__)
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) {
+    return false;
+  }
+  // Invariant TSC: constant rate in every P-, C- and T-state.
+  return (edx & (1u << 8)) != 0;
+#else
+  // The generic timer runs at a constant rate by definition.
+  return true;
+#endif
+}
+
+// Maps counter readings from |counter| to |counter| + |valid_ticks| to
+// nanoseconds, along the line through (|counter|, |nanos|) with slope
+// |nanos_per_tick|. Rates are 32.32 fixed-point numbers.
+struct Calibration {
+  uint64_t counter;
+  int64_t nanos;
+  uint64_t nanos_per_tick;
+  int64_t valid_ticks;
+  // The measured rate of the counter, before slewing.
+  uint64_t rate;
+  // The CLOCK_MONOTONIC sample the rate is next measured from, and
+  // SuspendedNanos() at the time.
+  uint64_t sample_counter;
+  int64_t sample_nanos;
+  int64_t sample_suspended_nanos;
+};
+
+int64_t ToNanos(const Calibration& calibration, uint64_t counter) {
+  const __int128 ticks = static_cast<int64_t>(counter - calibration.counter);
+  return calibration.nanos +
+         static_cast<int64_t>(
+             (ticks * static_cast<__int128>(calibration.nanos_per_tick)) >>
+             32);
+}
+
+uint64_t Rate(int64_t nanos, uint64_t ticks) {
+  return std::max<uint64_t>(
+      static_cast<uint64_t>(
+          (static_cast<unsigned __int128>(nanos) << 32) / ticks),
+      1);
+}
+
+int64_t TicksFor(int64_t nanos, uint64_t nanos_per_tick) {
+  return static_cast<int64_t>(
+      (static_cast<unsigned __int128>(nanos) << 32) / nanos_per_tick);
+}
+
+// How long the system has been suspended since boot. CLOCK_MONOTONIC stops
+// meanwhile; the counter may not.
+int64_t SuspendedNanos() {
+#if defined(CLOCK_BOOTTIME)
+  return MonotonicNanos(CLOCK_BOOTTIME) - MonotonicNanos(CLOCK_MONOTONIC);
+#else
+  return 0;
+#endif
+}
+
+// Reads the counter and CLOCK_MONOTONIC at about the same time: the closest
+// of a few tries, in case the thread was interrupted.
+std::pair<uint64_t, int64_t> Sample() {
+  std::pair<uint64_t, int64_t> sample;
+  uint64_t best_spread = UINT64_MAX;
+  for (int i = 0; i < 5; i++) {
+    const uint64_t before = ReadCounter();
+    const int64_t nanos = MonotonicNanos(CLOCK_MONOTONIC);
+    const uint64_t after = ReadCounter();
+    if (after - before < best_spread) {
+      best_spread = after - before;
+      sample = {before + (after - before) / 2, nanos};
+    }
+  }
+  return sample;
+}
+
+class FastClock {
+ public:
+  static FastClock& Get() {
+    // Leaked, so that threads reading the clock during exit never see it
+    // destroyed.
+    static FastClock* clock = new FastClock();
+    return *clock;
+  }
+
+  bool has_counter() const { return has_counter_; }
+
+  int64_t NowNanos() {
+    const Calibration calibration = calibration_.Load();
+    const uint64_t counter = ReadCounter();
+    // Readings may precede the calibration a little, but not by a whole
+    // period unless the counter was reset, e.g. by a resume.
+    const int64_t ticks = static_cast<int64_t>(counter - calibration.counter);
+    if (ticks > calibration.valid_ticks || ticks < -calibration.valid_ticks) {
+      return Recalibrate();
+    }
+    return ToNanos(calibration, counter);
+  }
+
+ private:
+  FastClock() : has_counter_(CounterIsInvariant()) {
+    if (!has_counter_) {
+      return;
+    }
+    const auto [start_counter, start_nanos] = Sample();
+    uint64_t counter;
+    int64_t nanos;
+    do {
+      std::tie(counter, nanos) = Sample();
+    } while (nanos - start_nanos < kInitialCalibrationNanos);
+    Calibration calibration;
+    calibration.counter = counter;
+    calibration.nanos = nanos;
+    calibration.rate = Rate(nanos - start_nanos, counter - start_counter);
+    calibration.nanos_per_tick = calibration.rate;
+    calibration.valid_ticks =
+        TicksFor(kFirstCalibrationNanos, calibration.rate);
+    calibration.sample_counter = counter;
+    calibration.sample_nanos = nanos;
+    calibration.sample_suspended_nanos = SuspendedNanos();
+    calibration_.Store(calibration);
+  }
+
+  // Starts a new calibration, unless another thread just did, and returns
+  // the current time.
+  int64_t Recalibrate() {
+    std::scoped_lock lock(mutex_);
+    const Calibration old = calibration_.Load();
+    const auto [sample_counter, nanos] = Sample();
+    const int64_t ticks = static_cast<int64_t>(sample_counter - old.counter);
+    if (ticks >= 0 && ticks <= old.valid_ticks) {
+      return ToNanos(old, sample_counter);
+    }
+    const int64_t suspended_nanos = SuspendedNanos();
+    // The rate cannot be measured across a suspend or a counter reset.
+    const bool suspended =
+        suspended_nanos - old.sample_suspended_nanos > kInitialCalibrationNanos;
+    const uint64_t rate = suspended || ticks < 0
+                              ? old.rate
+                              : Rate(nanos - old.sample_nanos,
+                                     sample_counter - old.sample_counter);
+    Calibration calibration;
+    calibration.counter = sample_counter;
+    // Not below the last value the old calibration can have returned, so
+    // the clock never goes backwards. If that puts it ahead of
+    // CLOCK_MONOTONIC, it runs slower until it is back in step; if it is
+    // behind, it steps forward.
+    calibration.nanos =
+        std::max(nanos, ToNanos(old, old.counter + old.valid_ticks));
+    const int64_t slew =
+        std::min(calibration.nanos - nanos, kMaxSlewNanos);
+    calibration.rate = rate;
+    calibration.nanos_per_tick = static_cast<uint64_t>(
+        static_cast<unsigned __int128>(rate) *
+        static_cast<uint64_t>(kCalibrationNanos - slew) / kCalibrationNanos);
+    calibration.valid_ticks =
+        TicksFor(kCalibrationNanos, calibration.nanos_per_tick);
+    calibration.sample_counter = sample_counter;
+    calibration.sample_nanos = nanos;
+    calibration.sample_suspended_nanos = suspended_nanos;
+    calibration_.Store(calibration);
+    return calibration.nanos;
+  }
+
+  const bool has_counter_;
+  SeqLock<Calibration> calibration_;
+  // Serializes recalibration.
+  std::mutex mutex_;
+};
+
+#endif  // defined(BASE_FAST_CLOCK_COUNTER)
+
+}  // namespace
+
+TimePoint FastClockNow() {
+#if defined(BASE_FAST_CLOCK_COUNTER)
+  FastClock& clock = FastClock::Get();
+  if (clock.has_counter()) {
+    return TimePoint::FromTicks(clock.NowNanos());
+  }
+#endif
+  return TimePoint::FromTicks(MonotonicNanos(CLOCK_MONOTONIC));
+}
+
+TimePoint CoarseClockNow() {
+#if defined(CLOCK_MONOTONIC_COARSE)
+  return TimePoint::FromTicks(MonotonicNanos(CLOCK_MONOTONIC_COARSE));
+#else
+  return TimePoint::FromTicks(MonotonicNanos(CLOCK_MONOTONIC));
+#endif
+}
+
+bool HasFastClockCounter() {
+#if defined(BASE_FAST_CLOCK_COUNTER)
+  return FastClock::Get().has_counter();
+#else
+  return false;
+#endif
+}
+
+bool UseFastClock() {
+  if (!HasFastClockCounter()) {
+    return false;
+  }
+  TimePoint::SetClockSource(FastClockNow);
+  return true;
+}
+
+FastClockTimestampProvider::FastClockTimestampProvider() = default;
+
+FastClockTimestampProvider::~FastClockTimestampProvider() = default;
+
+base::TimePoint FastClockTimestampProvider::Now() {
+  return FastClockNow();
+}
+
+}  // namespace base
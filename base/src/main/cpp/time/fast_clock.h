@@ -0,0 +1,58 @@
+#ifndef TIME_FAST_CLOCK_H_
+#define TIME_FAST_CLOCK_H_
+
+#include "../macros.h"
+#include "time_point.h"
+#include "timestamp_provider.h"
+
+namespace base {
+
+// Clock sources for TimePoint::SetClockSource(). Both tick on the timeline
+// of the default source, CLOCK_MONOTONIC, so TimePoints from either compare
+// with those from TimePoint::Now().
+
+// Reads the CPU's own counter, the invariant TSC on x86-64 or CNTVCT_EL0 on
+// ARM64, and scales it to nanoseconds without entering the kernel. The
+// scale is recalibrated against CLOCK_MONOTONIC about once a second. The
+// clock steps forward when it falls behind CLOCK_MONOTONIC, and runs slower
+// to let it catch up when it gets ahead, e.g. because the counter kept
+// running during suspend, so it never goes backwards. Where no such counter
+// exists, this is CLOCK_MONOTONIC.
+//
+// The first call calibrates for a couple of milliseconds; call
+// UseFastClock() at startup to pay for that up front.
+TimePoint FastClockNow();
+
+// CLOCK_MONOTONIC_COARSE where available: as cheap as reading memory, but
+// only as precise as the scheduler tick (1-10 ms). For timeouts and other
+// deadlines that do not need better.
+TimePoint CoarseClockNow();
+
+// Whether FastClockNow() reads a CPU counter.
+bool HasFastClockCounter();
+
+// Calibrates FastClockNow() and makes it the TimePoint::Now() source.
+// Returns false, leaving the source alone, if there is no CPU counter.
+bool UseFastClock();
+
+/// TimestampProvider implementation that is backed by FastClockNow().
+class FastClockTimestampProvider : public TimestampProvider {
+ public:
+  static FastClockTimestampProvider& Instance() {
+    static FastClockTimestampProvider instance;
+    return instance;
+  }
+
+  ~FastClockTimestampProvider() override;
+
+  base::TimePoint Now() override;
+
+ private:
+  FastClockTimestampProvider();
+
+  BASE_DISALLOW_COPY_AND_ASSIGN(FastClockTimestampProvider);
+};
+
+}  // namespace base
+
+#endif  // TIME_FAST_CLOCK_H_
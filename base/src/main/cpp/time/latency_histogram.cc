@@ -0,0 +1,334 @@
+#include "latency_histogram.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace base {
+
+namespace {
+
+// "HIST", little-endian.
+constexpr uint32_t kBinaryMagic = 0x54534948;
+constexpr uint32_t kBinaryVersion = 1;
+
+std::atomic<uint32_t> g_next_shard{0};
+
+// The shard of the calling thread, plus one; zero until it is picked.
+thread_local uint32_t t_shard = 0;
+
+size_t GetShardIndex(size_t shard_count) {
+  if (t_shard == 0) {
+    t_shard = g_next_shard.fetch_add(1, std::memory_order_relaxed) + 1;
+  }
+  return (t_shard - 1) % shard_count;
+}
+
+// Counts and sums stop at the largest value rather than wrap.
+uint64_t SaturatedAdd(uint64_t a, uint64_t b) {
+  return a > UINT64_MAX - b ? UINT64_MAX : a + b;
+}
+
+int64_t SaturatedAdd(int64_t a, int64_t b) {
+  return a > INT64_MAX - b ? INT64_MAX : a + b;
+}
+
+template <typename T>
+void AppendValue(T value, string::StringBuilder* out) {
+  memcpy(out->AppendUninitialized(sizeof(T)), &value, sizeof(T));
+}
+
+class Reader {
+ public:
+  explicit Reader(std::string_view data) : data_(data) {}
+
+  bool empty() const { return data_.empty(); }
+
+  template <typename T>
+  bool Read(T* value) {
+    if (data_.size() < sizeof(T)) {
+      return false;
+    }
+    memcpy(value, data_.data(), sizeof(T));
+    data_.remove_prefix(sizeof(T));
+    return true;
+  }
+
+ private:
+  std::string_view data_;
+};
+
+}  // namespace
+
+int64_t HistogramSnapshot::BucketLowerBound(size_t index) {
+  if (index < (size_t{2} << kSubBucketBits)) {
+    return static_cast<int64_t>(index);
+  }
+  const int shift = static_cast<int>(index >> kSubBucketBits) - 1;
+  return static_cast<int64_t>(index - (static_cast<size_t>(shift)
+                                       << kSubBucketBits))
+         << shift;
+}
+
+int64_t HistogramSnapshot::BucketUpperBound(size_t index) {
+  return index + 1 < kBucketCount ? BucketLowerBound(index + 1) - 1
+                                  : INT64_MAX;
+}
+
+HistogramSnapshot::HistogramSnapshot() : counts_(kBucketCount) {}
+
+TimeDelta HistogramSnapshot::min() const {
+  return TimeDelta::FromNanoseconds(count_ == 0 ? 0 : min_);
+}
+
+TimeDelta HistogramSnapshot::mean() const {
+  return TimeDelta::FromNanoseconds(
+      count_ == 0 ? 0
+                  : static_cast<int64_t>(static_cast<uint64_t>(sum_) / count_));
+}
+
+TimeDelta HistogramSnapshot::Percentile(double percentile) const {
+  if (count_ == 0) {
+    return TimeDelta::Zero();
+  }
+  if (percentile <= 0) {
+    return min();
+  }
+  if (percentile >= 100) {
+    return max();
+  }
+  // A count near UINT64_MAX can round up past it as a double.
+  const double position = std::ceil(percentile / 100 * count_);
+  const uint64_t rank =
+      position >= 18446744073709551615.0
+          ? count_
+          : std::max<uint64_t>(static_cast<uint64_t>(position), 1);
+  uint64_t seen = 0;
+  for (size_t index = 0; index < kBucketCount; index++) {
+    seen = SaturatedAdd(seen, counts_[index]);
+    if (seen >= rank) {
+      // The middle of the bucket, within what was actually recorded.
+      const int64_t lower = BucketLowerBound(index);
+      const int64_t upper = BucketUpperBound(index);
+      return TimeDelta::FromNanoseconds(
+          std::clamp(lower + (upper - lower) / 2, min_, max_));
+    }
+  }
+  return max();
+}
+
+void HistogramSnapshot::Merge(const HistogramSnapshot& other) {
+  for (size_t index = 0; index < kBucketCount; index++) {
+    counts_[index] = SaturatedAdd(counts_[index], other.counts_[index]);
+  }
+  count_ = SaturatedAdd(count_, other.count_);
+  sum_ = SaturatedAdd(sum_, other.sum_);
+  min_ = std::min(min_, other.min_);
+  max_ = std::max(max_, other.max_);
+}
+
+void HistogramSnapshot::AppendJson(string::StringBuilder* out) const {
+  out->Append("{\"count\":", count_, ",\"sum_ns\":", sum_,
+              ",\"min_ns\":", min().ToNanoseconds(),
+              ",\"max_ns\":", max_, ",\"mean_ns\":", mean().ToNanoseconds());
+  static constexpr std::pair<const char*, double> kPercentiles[] = {
+      {"p50", 50}, {"p90", 90}, {"p99", 99}, {"p999", 99.9}};
+  for (const auto& [name, percentile] : kPercentiles) {
+    out->Append(",\"", name, "_ns\":", Percentile(percentile).ToNanoseconds());
+  }
+  out->Append(",\"buckets\":[");
+  bool first = true;
+  for (size_t index = 0; index < kBucketCount; index++) {
+    if (counts_[index] == 0) {
+      continue;
+    }
+    if (!first) {
+      out->push_back(',');
+    }
+    first = false;
+    out->Append("[", BucketLowerBound(index), ",", counts_[index], "]");
+  }
+  out->Append("]}");
+}
+
+// The layout is:
+//
+//   u32 magic | u32 version | u8 sub-bucket bits | u8 max value bits
+//       | i64 sum | i64 min | i64 max | u32 bucket count
+//       | (u32 index | u64 count)...
+//
+// listing the non-empty buckets only, in increasing order. Values are
+// little-endian, as on every Android ABI.
+void HistogramSnapshot::AppendBinary(string::StringBuilder* out) const {
+  AppendValue(kBinaryMagic, out);
+  AppendValue(kBinaryVersion, out);
+  AppendValue(static_cast<uint8_t>(kSubBucketBits), out);
+  AppendValue(static_cast<uint8_t>(kMaxValueBits), out);
+  AppendValue(sum_, out);
+  AppendValue(min_, out);
+  AppendValue(max_, out);
+  const uint32_t buckets = static_cast<uint32_t>(
+      std::count_if(counts_.begin(), counts_.end(),
+                    [](uint64_t count) { return count != 0; }));
+  AppendValue(buckets, out);
+  for (size_t index = 0; index < kBucketCount; index++) {
+    if (counts_[index] != 0) {
+      AppendValue(static_cast<uint32_t>(index), out);
+      AppendValue(counts_[index], out);
+    }
+  }
+}
+
+bool HistogramSnapshot::ParseBinary(std::string_view data,
+                                    HistogramSnapshot* snapshot) {
+  Reader reader(data);
+  uint32_t magic, version, buckets, previous = 0;
+  uint8_t sub_bucket_bits, max_value_bits;
+  HistogramSnapshot result;
+  if (!reader.Read(&magic) || magic != kBinaryMagic ||
+      !reader.Read(&version) || version != kBinaryVersion ||
+      !reader.Read(&sub_bucket_bits) || sub_bucket_bits != kSubBucketBits ||
+      !reader.Read(&max_value_bits) || max_value_bits != kMaxValueBits ||
+      !reader.Read(&result.sum_) || !reader.Read(&result.min_) ||
+      !reader.Read(&result.max_) || !reader.Read(&buckets)) {
+    return false;
+  }
+  for (uint32_t i = 0; i < buckets; i++) {
+    uint32_t index;
+    uint64_t count;
+    // Buckets are listed once each, in increasing order.
+    if (!reader.Read(&index) || index >= kBucketCount ||
+        (i != 0 && index <= previous) || !reader.Read(&count) ||
+        count == 0) {
+      return false;
+    }
+    previous = index;
+    result.counts_[index] = count;
+    result.count_ = SaturatedAdd(result.count_, count);
+  }
+  if (!reader.empty() || !result.HasConsistentTotals()) {
+    return false;
+  }
+  *snapshot = std::move(result);
+  return true;
+}
+
+bool HistogramSnapshot::HasConsistentTotals() const {
+  if (count_ == 0) {
+    return sum_ == 0 && min_ == INT64_MAX && max_ == 0;
+  }
+  size_t first = 0;
+  while (counts_[first] == 0) {
+    first++;
+  }
+  size_t last = kBucketCount - 1;
+  while (counts_[last] == 0) {
+    last--;
+  }
+  return sum_ >= 0 && min_ <= max_ && min_ >= BucketLowerBound(first) &&
+         min_ <= BucketUpperBound(first) && max_ >= BucketLowerBound(last) &&
+         max_ <= BucketUpperBound(last);
+}
+
+void HistogramSnapshot::MakeTotalsConsistent() {
+  if (count_ == 0) {
+    sum_ = 0;
+    min_ = INT64_MAX;
+    max_ = 0;
+    return;
+  }
+  size_t first = 0;
+  while (counts_[first] == 0) {
+    first++;
+  }
+  size_t last = kBucketCount - 1;
+  while (counts_[last] == 0) {
+    last--;
+  }
+  min_ = std::clamp(min_, BucketLowerBound(first), BucketUpperBound(first));
+  max_ = std::clamp(max_, BucketLowerBound(last), BucketUpperBound(last));
+  // Only possible if both are in the same bucket.
+  min_ = std::min(min_, max_);
+}
+
+struct LatencyHistogram::Shard {
+  std::atomic<uint64_t> counts[HistogramSnapshot::kBucketCount] = {};
+  std::atomic<int64_t> sum{0};
+  std::atomic<int64_t> min{INT64_MAX};
+  std::atomic<int64_t> max{0};
+};
+
+LatencyHistogram::LatencyHistogram() = default;
+
+LatencyHistogram::~LatencyHistogram() {
+  for (std::atomic<Shard*>& shard : shards_) {
+    delete shard.load(std::memory_order_relaxed);
+  }
+}
+
+void LatencyHistogram::Record(TimeDelta latency) {
+  const int64_t nanos = std::max<int64_t>(latency.ToNanoseconds(), 0);
+  Shard* shard = GetShard();
+  shard->counts[HistogramSnapshot::BucketIndex(nanos)].fetch_add(
+      1, std::memory_order_relaxed);
+  // Uncontended unless threads share the shard, so hardly dearer than a
+  // fetch_add, which would wrap.
+  int64_t sum = shard->sum.load(std::memory_order_relaxed);
+  while (!shard->sum.compare_exchange_weak(sum, SaturatedAdd(sum, nanos),
+                                           std::memory_order_relaxed)) {
+  }
+  // New extremes get rare quickly, so these seldom write.
+  int64_t min = shard->min.load(std::memory_order_relaxed);
+  while (nanos < min && !shard->min.compare_exchange_weak(
+                            min, nanos, std::memory_order_relaxed)) {
+  }
+  int64_t max = shard->max.load(std::memory_order_relaxed);
+  while (nanos > max && !shard->max.compare_exchange_weak(
+                            max, nanos, std::memory_order_relaxed)) {
+  }
+}
+
+HistogramSnapshot LatencyHistogram::GetSnapshot() const {
+  HistogramSnapshot snapshot;
+  for (const std::atomic<Shard*>& slot : shards_) {
+    const Shard* shard = slot.load(std::memory_order_acquire);
+    if (shard == nullptr) {
+      continue;
+    }
+    for (size_t index = 0; index < HistogramSnapshot::kBucketCount;
+         index++) {
+      const uint64_t count =
+          shard->counts[index].load(std::memory_order_relaxed);
+      snapshot.counts_[index] = SaturatedAdd(snapshot.counts_[index], count);
+      snapshot.count_ = SaturatedAdd(snapshot.count_, count);
+    }
+    snapshot.sum_ = SaturatedAdd(snapshot.sum_,
+                                 shard->sum.load(std::memory_order_relaxed));
+    snapshot.min_ =
+        std::min(snapshot.min_, shard->min.load(std::memory_order_relaxed));
+    snapshot.max_ =
+        std::max(snapshot.max_, shard->max.load(std::memory_order_relaxed));
+  }
+  snapshot.MakeTotalsConsistent();
+  return snapshot;
+}
+
+LatencyHistogram::Shard* LatencyHistogram::GetShard() {
+  std::atomic<Shard*>& slot = shards_[GetShardIndex(kShardCount)];
+  Shard* shard = slot.load(std::memory_order_acquire);
+  if (shard != nullptr) {
+    return shard;
+  }
+  Shard* created = new Shard();
+  if (slot.compare_exchange_strong(shard, created,
+                                   std::memory_order_acq_rel,
+                                   std::memory_order_acquire)) {
+    return created;
+  }
+  // Another thread sharing the slot got there first.
+  delete created;
+  return shard;
+}
+
+}  // namespace base
@@ -0,0 +1,140 @@
+#ifndef TIME_LATENCY_HISTOGRAM_H_
+#define TIME_LATENCY_HISTOGRAM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <string_view>
+#include <vector>
+
+#include "../macros.h"
+#include "../string/string_builder.h"
+#include "time_delta.h"
+
+namespace base {
+
+// The contents of a LatencyHistogram at one point, or several merged.
+//
+// Latencies are counted in log-linear buckets: each power of two of
+// nanoseconds is split into 2^kSubBucketBits equal buckets, so a bucket is
+// at most 1/32 (about 3%) as wide as the values in it, and values below 64
+// ns are exact. Latencies beyond 2^kMaxValueBits ns (about 18 minutes) count
+// in the last bucket; negative ones count as zero.
+class HistogramSnapshot {
+ public:
+  static constexpr int kSubBucketBits = 5;
+  static constexpr int kMaxValueBits = 40;
+  static constexpr size_t kBucketCount =
+      static_cast<size_t>(kMaxValueBits - kSubBucketBits + 1)
+      << kSubBucketBits;
+
+  // The bucket |nanos| counts in.
+  static size_t BucketIndex(int64_t nanos) {
+    if (nanos < (int64_t{2} << kSubBucketBits)) {
+      return nanos < 0 ? 0 : static_cast<size_t>(nanos);
+    }
+    if (nanos >= (int64_t{1} << kMaxValueBits)) {
+      return kBucketCount - 1;
+    }
+    const int shift = 63 - __builtin_clzll(static_cast<uint64_t>(nanos)) -
+                      kSubBucketBits;
+    return (static_cast<size_t>(shift) << kSubBucketBits) +
+           static_cast<size_t>(nanos >> shift);
+  }
+
+  // The smallest latency, in nanoseconds, that counts in bucket |index|.
+  static int64_t BucketLowerBound(size_t index);
+
+  // The largest latency, in nanoseconds, that counts in bucket |index|.
+  static int64_t BucketUpperBound(size_t index);
+
+  HistogramSnapshot();
+
+  // The count and sum saturate rather than overflow.
+  uint64_t count() const { return count_; }
+  TimeDelta sum() const { return TimeDelta::FromNanoseconds(sum_); }
+  // Zero if the histogram is empty, like max() and mean().
+  TimeDelta min() const;
+  TimeDelta max() const { return TimeDelta::FromNanoseconds(max_); }
+  TimeDelta mean() const;
+
+  uint64_t bucket_count(size_t index) const { return counts_[index]; }
+
+  // The latency |percentile| percent of the recorded ones are at or below,
+  // to within the width of its bucket. Percentile(0) is min() and
+  // Percentile(100) is max().
+  TimeDelta Percentile(double percentile) const;
+
+  // Adds the latencies counted in |other|.
+  void Merge(const HistogramSnapshot& other);
+
+  // Appends a JSON object with the count, sum, min, max, mean and common
+  // percentiles, in nanoseconds, and the non-empty buckets as
+  // [lower bound, count] pairs.
+  void AppendJson(string::StringBuilder* out) const;
+
+  // Appends a compact binary encoding that ParseBinary() reads back.
+  void AppendBinary(string::StringBuilder* out) const;
+
+  // Decodes AppendBinary() output into |snapshot|. Returns false if |data|
+  // is damaged, uses a different bucket layout, or has a min or max outside
+  // the first or last non-empty bucket.
+  static bool ParseBinary(std::string_view data, HistogramSnapshot* snapshot);
+
+ private:
+  friend class LatencyHistogram;
+
+  // Whether the sum and extremes agree with the buckets: those of an empty
+  // histogram if none is counted in, otherwise within the first and last
+  // non-empty buckets.
+  bool HasConsistentTotals() const;
+
+  // Makes the sum and extremes agree with the buckets, which a merge of
+  // shards being recorded into may leave them out of step with.
+  void MakeTotalsConsistent();
+
+  std::vector<uint64_t> counts_;
+  uint64_t count_ = 0;
+  int64_t sum_ = 0;
+  int64_t min_ = INT64_MAX;
+  int64_t max_ = 0;
+};
+
+// A histogram of latencies that any thread can record into without locking.
+// Threads record into one of a few shards, allocated as threads first use
+// them, each with a relaxed increment of a bucket and of the sum; reads
+// merge the shards.
+//
+//   static LatencyHistogram* request_latency = new LatencyHistogram();
+//   request_latency->Record(TimePoint::Now() - start);
+//   ...
+//   HistogramSnapshot snapshot = request_latency->GetSnapshot();
+//   BASE_LOG(INFO) << "p99 " << snapshot.Percentile(99).ToMilliseconds();
+class LatencyHistogram {
+ public:
+  LatencyHistogram();
+  ~LatencyHistogram();
+
+  void Record(TimeDelta latency);
+
+  // Merges the shards. Latencies recorded meanwhile may be missing from the
+  // buckets or the sum independently; the extremes are then narrowed or
+  // widened to the buckets the snapshot has.
+  HistogramSnapshot GetSnapshot() const;
+
+ private:
+  static constexpr size_t kShardCount = 8;
+
+  struct Shard;
+
+  Shard* GetShard();
+
+  std::atomic<Shard*> shards_[kShardCount] = {};
+
+  BASE_DISALLOW_COPY_AND_ASSIGN(LatencyHistogram);
+};
+
+}  // namespace base
+
+#endif  // TIME_LATENCY_HISTOGRAM_H_
@@ -21,8 +21,9 @@ void TimePoint::SetClockSource(ClockSource source) {
 }
 
 TimePoint TimePoint::Now() {
-  if (gSteadyClockSource) {
-    return gSteadyClockSource.load()();
+  const ClockSource source = gSteadyClockSource.load(std::memory_order_relaxed);
+  if (source) {
+    return source();
   }
   const int64_t nanos = NanosSinceEpoch(std::chrono::steady_clock::now());
   return TimePoint(nanos);
@@ -0,0 +1,369 @@
+#include "trace_event.h"
+
+#include <stdio.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "time/time_point.h"
+
+namespace base {
+
+namespace internal {
+
+std::atomic<bool> g_tracing_enabled{false};
+
+int64_t NowTicks() {
+  return TimePoint::Now().ToEpochDelta().ToNanoseconds();
+}
+
+}  // namespace internal
+
+namespace {
+
+constexpr size_t kChunkEvents = 1024;
+
+int CurrentThreadId() {
+  return static_cast<int>(syscall(SYS_gettid));
+}
+
+// The events of one thread in one recording. Only the owning thread appends;
+// the exporter reads the published prefix of each chunk concurrently.
+class ThreadBuffer {
+ public:
+  ThreadBuffer(uint32_t session, int thread_id, size_t max_events)
+      : session(session), thread_id(thread_id), max_events_(max_events) {}
+
+  ~ThreadBuffer() {
+    Chunk* chunk = head_.next.load(std::memory_order_relaxed);
+    while (chunk != nullptr) {
+      Chunk* next = chunk->next.load(std::memory_order_relaxed);
+      delete chunk;
+      chunk = next;
+    }
+  }
+
+  void Append(const TraceEvent& event) {
+    const uint32_t size = tail_->size.load(std::memory_order_relaxed);
+    if (size == kChunkEvents) {
+      if (event_count_ >= max_events_) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+      Chunk* chunk = new Chunk();
+      chunk->events[0] = event;
+      chunk->size.store(1, std::memory_order_relaxed);
+      tail_->next.store(chunk, std::memory_order_release);
+      tail_ = chunk;
+    } else {
+      tail_->events[size] = event;
+      tail_->size.store(size + 1, std::memory_order_release);
+    }
+    event_count_++;
+  }
+
+  // Calls |visit| with each event appended so far.
+  template <typename Visitor>
+  void ForEach(Visitor visit) const {
+    for (const Chunk* chunk = &head_; chunk != nullptr;
+         chunk = chunk->next.load(std::memory_order_acquire)) {
+      const uint32_t size = chunk->size.load(std::memory_order_acquire);
+      for (uint32_t i = 0; i < size; i++) {
+        visit(chunk->events[i]);
+      }
+    }
+  }
+
+  const uint32_t session;
+  const int thread_id;
+  // Set when the owning thread exits; nothing appends afterwards.
+  std::atomic<bool> orphaned{false};
+  std::atomic<uint64_t> dropped{0};
+
+ private:
+  struct Chunk {
+    std::atomic<uint32_t> size{0};
+    std::atomic<Chunk*> next{nullptr};
+    TraceEvent events[kChunkEvents];
+  };
+
+  const size_t max_events_;
+  size_t event_count_ = 0;
+  Chunk head_;
+  Chunk* tail_ = &head_;
+};
+
+// The calling thread's buffer. These are trivially destructible, so they
+// stay usable while other thread-locals are destroyed at thread exit.
+thread_local ThreadBuffer* t_buffer = nullptr;
+thread_local bool t_exiting = false;
+
+struct BufferRetirer {
+  ~BufferRetirer() {
+    if (t_buffer != nullptr) {
+      t_buffer->orphaned.store(true, std::memory_order_release);
+    }
+    t_buffer = nullptr;
+    t_exiting = true;
+  }
+};
+
+thread_local BufferRetirer t_retirer;
+
+class Tracer {
+ public:
+  static Tracer& Get() {
+    // Leaked, so that threads tracing during exit never see it destroyed.
+    static Tracer* tracer = new Tracer();
+    return *tracer;
+  }
+
+  bool Start(const TraceOptions& options) {
+    std::scoped_lock lock(mutex_);
+    if (internal::g_tracing_enabled.load(std::memory_order_relaxed)) {
+      return false;
+    }
+    // Buffers of live threads are replaced by their owners, who may still be
+    // appending to them; the rest can go now.
+    buffers_.erase(
+        std::remove_if(buffers_.begin(), buffers_.end(),
+                       [](const std::unique_ptr<ThreadBuffer>& buffer) {
+                         return buffer->orphaned.load(
+                             std::memory_order_acquire);
+                       }),
+        buffers_.end());
+    max_events_ = std::max<size_t>(options.max_events_per_thread, 1);
+    session_.fetch_add(1, std::memory_order_relaxed);
+    internal::g_tracing_enabled.store(true, std::memory_order_release);
+    return true;
+  }
+
+  void Stop() {
+    std::scoped_lock lock(mutex_);
+    internal::g_tracing_enabled.store(false, std::memory_order_release);
+  }
+
+  void Add(const TraceEvent& event) {
+    if (t_exiting) {
+      return;
+    }
+    ThreadBuffer* buffer = t_buffer;
+    if (buffer == nullptr ||
+        buffer->session != session_.load(std::memory_order_relaxed)) {
+      // Constructs the retirer, whose destructor orphans the buffer.
+      static_cast<void>(&t_retirer);
+      buffer = ReplaceBuffer(buffer);
+      t_buffer = buffer;
+    }
+    buffer->Append(event);
+  }
+
+  void SetThreadName(std::string_view name) {
+    std::scoped_lock lock(mutex_);
+    thread_names_[CurrentThreadId()] = std::string(name);
+  }
+
+  uint64_t NewId() { return next_id_.fetch_add(1, std::memory_order_relaxed); }
+
+  void Export(string::StringBuilder* out) {
+    const int pid = static_cast<int>(getpid());
+    std::scoped_lock lock(mutex_);
+    const uint32_t session = session_.load(std::memory_order_relaxed);
+    out->Append("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    bool first = true;
+    auto separate = [&first, out] {
+      if (!first) {
+        out->push_back(',');
+      }
+      first = false;
+    };
+    for (const auto& [thread_id, name] : thread_names_) {
+      separate();
+      out->Append("{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":", pid,
+                  ",\"tid\":", thread_id, ",\"args\":{\"name\":");
+      AppendJsonString(name, out);
+      out->Append("}}");
+    }
+    for (const auto& buffer : buffers_) {
+      if (buffer->session != session) {
+        continue;
+      }
+      buffer->ForEach([&](const TraceEvent& event) {
+        separate();
+        AppendEvent(event, pid, buffer->thread_id, out);
+      });
+    }
+    out->Append("]}\n");
+  }
+
+  uint64_t GetDroppedCount() {
+    std::scoped_lock lock(mutex_);
+    const uint32_t session = session_.load(std::memory_order_relaxed);
+    uint64_t dropped = 0;
+    for (const auto& buffer : buffers_) {
+      if (buffer->session == session) {
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+      }
+    }
+    return dropped;
+  }
+
+ private:
+  Tracer() = default;
+
+  // Registers a buffer for the current recording in place of |old_buffer|,
+  // which only the calling thread appends to.
+  ThreadBuffer* ReplaceBuffer(ThreadBuffer* old_buffer) {
+    std::scoped_lock lock(mutex_);
+    if (old_buffer != nullptr) {
+      buffers_.erase(
+          std::find_if(buffers_.begin(), buffers_.end(),
+                       [old_buffer](const std::unique_ptr<ThreadBuffer>& b) {
+                         return b.get() == old_buffer;
+                       }));
+    }
+    buffers_.push_back(std::make_unique<ThreadBuffer>(
+        session_.load(std::memory_order_relaxed), CurrentThreadId(),
+        max_events_));
+    return buffers_.back().get();
+  }
+
+  static void AppendJsonString(std::string_view value,
+                               string::StringBuilder* out) {
+    static constexpr char kHexDigits[] = "0123456789abcdef";
+    out->push_back('"');
+    for (const char c : value) {
+      if (c == '"' || c == '\\') {
+        out->push_back('\\').push_back(c);
+      } else if (static_cast<unsigned char>(c) < 0x20) {
+        out->Append("\\u00").push_back(kHexDigits[c >> 4]).push_back(
+            kHexDigits[c & 0xf]);
+      } else {
+        out->push_back(c);
+      }
+    }
+    out->push_back('"');
+  }
+
+  // Chrome traces count in microseconds; the fraction keeps the nanoseconds.
+  static void AppendMicroseconds(int64_t nanos, string::StringBuilder* out) {
+    if (nanos < 0) {
+      out->push_back('-');
+      nanos = -nanos;
+    }
+    const int64_t fraction = nanos % 1000;
+    out->Append(nanos / 1000, ".");
+    out->push_back(static_cast<char>('0' + fraction / 100))
+        .push_back(static_cast<char>('0' + fraction / 10 % 10))
+        .push_back(static_cast<char>('0' + fraction % 10));
+  }
+
+  static void AppendEvent(const TraceEvent& event,
+                          int pid,
+                          int thread_id,
+                          string::StringBuilder* out) {
+    out->Append("{\"ph\":\"");
+    out->push_back(static_cast<char>(event.phase));
+    out->Append("\",\"cat\":");
+    AppendJsonString(event.category, out);
+    out->Append(",\"name\":");
+    AppendJsonString(event.name, out);
+    out->Append(",\"pid\":", pid, ",\"tid\":", thread_id, ",\"ts\":");
+    AppendMicroseconds(event.ticks, out);
+    switch (event.phase) {
+      case TracePhase::kComplete:
+        out->Append(",\"dur\":");
+        AppendMicroseconds(event.value, out);
+        break;
+      case TracePhase::kInstant:
+        out->Append(",\"s\":\"t\"");
+        break;
+      case TracePhase::kCounter:
+        out->Append(",\"args\":{\"value\":", event.value, "}");
+        break;
+      case TracePhase::kFlowEnd:
+        // Binds to the enclosing span rather than the next one to start.
+        out->Append(",\"bp\":\"e\"");
+        [[fallthrough]];
+      case TracePhase::kAsyncBegin:
+      case TracePhase::kAsyncEnd:
+      case TracePhase::kFlowBegin:
+        out->Append(",\"id\":\"0x", absl::Hex(event.value), "\"");
+        break;
+    }
+    out->push_back('}');
+  }
+
+  std::mutex mutex_;
+  // Buffers of the current recording, and of earlier ones whose threads
+  // have not replaced them yet.
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+  std::unordered_map<int, std::string> thread_names_;
+  size_t max_events_ = 0;
+  std::atomic<uint32_t> session_{0};
+  std::atomic<uint64_t> next_id_{1};
+};
+
+}  // namespace
+
+bool StartTracing(const TraceOptions& options) {
+  return Tracer::Get().Start(options);
+}
+
+void StopTracing() {
+  Tracer::Get().Stop();
+}
+
+uint64_t NewTraceId() {
+  return Tracer::Get().NewId();
+}
+
+void SetTraceThreadName(std::string_view name) {
+  Tracer::Get().SetThreadName(name);
+}
+
+void AddTraceEvent(const TraceEvent& event) {
+  if (IsTracingEnabled()) {
+    Tracer::Get().Add(event);
+  }
+}
+
+void AddTraceEvent(TracePhase phase,
+                   const char* category,
+                   const char* name,
+                   int64_t value) {
+  AddTraceEvent({category, name, internal::NowTicks(), value, phase});
+}
+
+void ExportChromeTrace(string::StringBuilder* out) {
+  Tracer::Get().Export(out);
+}
+
+bool WriteChromeTraceFile(const std::string& path) {
+  string::StringBuilder json;
+  ExportChromeTrace(&json);
+  FILE* file = fopen(path.c_str(), "wb");
+  if (file == nullptr) {
+    return false;
+  }
+  const bool written = fwrite(json.data(), 1, json.size(), file) == json.size();
+  return fclose(file) == 0 && written;
+}
+
+uint64_t GetDroppedTraceEventCount() {
+  return Tracer::Get().GetDroppedCount();
+}
+
+void ScopedTraceEvent::End() {
+  const int64_t end_ticks = internal::NowTicks();
+  AddTraceEvent(
+      {category_, name_, start_ticks_, end_ticks - start_ticks_,
+       TracePhase::kComplete});
+}
+
+}  // namespace base
@@ -0,0 +1,192 @@
+#ifndef TRACE_EVENT_H_
+#define TRACE_EVENT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "macros.h"
+#include "string/string_builder.h"
+
+// Tracing: while StartTracing() is in effect, the BASE_TRACE_* macros record
+// timestamped events into a buffer owned by the calling thread, without
+// taking a lock. ExportChromeTrace() turns the events of all threads into
+// Chrome trace event JSON, which chrome://tracing and ui.perfetto.dev load,
+// so work handed from one thread to another shows up on one timeline.
+//
+//   void Fetch() {
+//     BASE_TRACE_EVENT("http", "Fetch");  // A span until the end of scope.
+//     BASE_TRACE_COUNTER("http", "InFlight", in_flight);
+//   }
+//
+// Categories and names must be string literals, or otherwise outlive the
+// recording. While tracing is off, each macro costs one relaxed load.
+
+namespace base {
+
+// The Chrome trace event phase of an event.
+enum class TracePhase : char {
+  kComplete = 'X',
+  kInstant = 'i',
+  kCounter = 'C',
+  kAsyncBegin = 'b',
+  kAsyncEnd = 'e',
+  kFlowBegin = 's',
+  kFlowEnd = 'f',
+};
+
+struct TraceEvent {
+  const char* category;
+  const char* name;
+  // TimePoint::Now() ticks, in nanoseconds.
+  int64_t ticks;
+  // The duration in nanoseconds of a kComplete event, the value of a
+  // kCounter event and the id of async and flow events.
+  int64_t value;
+  TracePhase phase;
+};
+
+struct TraceOptions {
+  // Events past this many on one thread, rounded up to a multiple of 1024,
+  // are dropped.
+  size_t max_events_per_thread = 64 * 1024;
+};
+
+// Discards the previous recording and starts a new one. Returns false if
+// tracing is already on.
+bool StartTracing(const TraceOptions& options = {});
+
+// Stops recording. The recording can be exported until tracing starts again.
+void StopTracing();
+
+namespace internal {
+
+extern std::atomic<bool> g_tracing_enabled;
+
+// TimePoint::Now() ticks.
+int64_t NowTicks();
+
+}  // namespace internal
+
+inline bool IsTracingEnabled() {
+  return internal::g_tracing_enabled.load(std::memory_order_relaxed);
+}
+
+// Returns an id for async and flow events that is unique in the process.
+uint64_t NewTraceId();
+
+// Names the calling thread in exported traces. Can be called whether or not
+// tracing is on.
+void SetTraceThreadName(std::string_view name);
+
+// Records |event| on the calling thread. Does nothing while tracing is off.
+void AddTraceEvent(const TraceEvent& event);
+
+// Records an event of |phase| that happens now.
+void AddTraceEvent(TracePhase phase,
+                   const char* category,
+                   const char* name,
+                   int64_t value);
+
+// Appends the current recording, as a Chrome trace event JSON object, to
+// |out|. Can be called while tracing is on, and includes the events recorded
+// by threads that have exited since.
+void ExportChromeTrace(string::StringBuilder* out);
+
+// Writes ExportChromeTrace() to the file at |path|. Returns false on error.
+bool WriteChromeTraceFile(const std::string& path);
+
+// Number of events dropped from the current recording because a thread hit
+// TraceOptions::max_events_per_thread.
+uint64_t GetDroppedTraceEventCount();
+
+// Records a kComplete event spanning its lifetime. Use BASE_TRACE_EVENT.
+class ScopedTraceEvent {
+ public:
+  ScopedTraceEvent(const char* category, const char* name)
+      : category_(category), name_(name) {
+    if (IsTracingEnabled()) {
+      start_ticks_ = internal::NowTicks();
+    }
+  }
+
+  ~ScopedTraceEvent() {
+    if (start_ticks_ != kNotRecording) {
+      End();
+    }
+  }
+
+ private:
+  static constexpr int64_t kNotRecording = INT64_MIN;
+
+  void End();
+
+  const char* const category_;
+  const char* const name_;
+  int64_t start_ticks_ = kNotRecording;
+
+  BASE_DISALLOW_COPY_AND_ASSIGN(ScopedTraceEvent);
+};
+
+// Wraps |task|, a closure handed to another thread, so that running it
+// records a |name| span linked by a flow arrow to the span the caller is in.
+// Returns |task| unchanged while tracing is off.
+template <typename Task>
+Task TraceTask(const char* category, const char* name, Task task) {
+  if (!IsTracingEnabled()) {
+    return task;
+  }
+  const int64_t id = static_cast<int64_t>(NewTraceId());
+  AddTraceEvent(TracePhase::kFlowBegin, category, name, id);
+  return Task([category, name, id, task = std::move(task)]() mutable {
+    ScopedTraceEvent event(category, name);
+    AddTraceEvent(TracePhase::kFlowEnd, category, name, id);
+    task();
+  });
+}
+
+}  // namespace base
+
+#define BASE_TRACE_CONCAT_INNER(a, b) a##b
+#define BASE_TRACE_CONCAT(a, b) BASE_TRACE_CONCAT_INNER(a, b)
+
+// Records a span from here to the end of the enclosing scope.
+#define BASE_TRACE_EVENT(category, name)                                   \
+  ::base::ScopedTraceEvent BASE_TRACE_CONCAT(base_trace_event_, __LINE__)( \
+      category, name)
+
+#define BASE_TRACE_EVENT_WITH_PHASE(phase, category, name, value)        \
+  do {                                                                   \
+    if (::base::IsTracingEnabled()) {                                    \
+      ::base::AddTraceEvent(::base::TracePhase::phase, category, name,   \
+                            static_cast<int64_t>(value));                \
+    }                                                                    \
+  } while (false)
+
+#define BASE_TRACE_INSTANT(category, name) \
+  BASE_TRACE_EVENT_WITH_PHASE(kInstant, category, name, 0)
+
+#define BASE_TRACE_COUNTER(category, name, value) \
+  BASE_TRACE_EVENT_WITH_PHASE(kCounter, category, name, value)
+
+// An async span may begin and end on different threads; both ends take the
+// same NewTraceId().
+#define BASE_TRACE_ASYNC_BEGIN(category, name, id) \
+  BASE_TRACE_EVENT_WITH_PHASE(kAsyncBegin, category, name, id)
+
+#define BASE_TRACE_ASYNC_END(category, name, id) \
+  BASE_TRACE_EVENT_WITH_PHASE(kAsyncEnd, category, name, id)
+
+// A flow arrow from the span that records the begin to the one that records
+// the end. See also TraceTask().
+#define BASE_TRACE_FLOW_BEGIN(category, name, id) \
+  BASE_TRACE_EVENT_WITH_PHASE(kFlowBegin, category, name, id)
+
+#define BASE_TRACE_FLOW_END(category, name, id) \
+  BASE_TRACE_EVENT_WITH_PHASE(kFlowEnd, category, name, id)
+
+#endif  // TRACE_EVENT_H_
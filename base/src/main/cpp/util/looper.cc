@@ -12,6 +12,7 @@
 
 #include "../log_settings.h"
 #include "../logging.h"
+#include "../trace_event.h"
 
 namespace base {
 namespace utils {
@@ -42,13 +43,15 @@ LooperThread* LooperThread::GetCurrentLooper() { return current_looper_thread; }
 
 // Enqueues the given closure to be run on the looper.
 bool LooperThread::Post(std::function<void()>&& runnable) {
+  BASE_TRACE_EVENT("looper", "LooperThread::Post");
   {
     absl::MutexLock l(&mutex_);
     if (lameduck_) {
       BASE_LOG(ERROR) << "Tried to Post to stopped Looper: " << name_;
       return false;
     }
-    queue_.emplace_back(runnable);
+    queue_.emplace_back(
+        TraceTask("looper", "LooperThread::Task", std::move(runnable)));
   }
   queue_changed_.SignalAll();
   return true;
@@ -98,6 +101,7 @@ std::optional<std::function<void()>> LooperThread::Dequeue() {
 
 void LooperThread::Loop() {
   current_looper_thread = this;
+  SetTraceThreadName("Looper: " + name_);
 #ifdef __APPLE__
   // Set a name for the thread to make debugging in Xcode nicer.
   std::string label = "Looper: " + name_;
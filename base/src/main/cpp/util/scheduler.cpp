@@ -1,5 +1,6 @@
 #include "scheduler.hpp"
 
+#include "../trace_event.h"
 #include "android/scheduler.hpp"
 #include "functional.hpp"
 #include "generic/scheduler.hpp"
@@ -40,11 +41,14 @@ class DummyScheduler : public base::util::Scheduler {
 }  // anonymous namespace
 
 void InvocationQueue::push(util::UniqueFunction<void()>&& fn) {
+  BASE_TRACE_EVENT("scheduler", "Scheduler::invoke");
+  auto task = TraceTask("scheduler", "Scheduler task", std::move(fn));
   std::lock_guard lock(m_mutex);
-  m_functions.push_back(std::move(fn));
+  m_functions.push_back(std::move(task));
 }
 
 void InvocationQueue::invoke_all() {
+  BASE_TRACE_EVENT("scheduler", "InvocationQueue::invoke_all");
   std::vector<util::UniqueFunction<void()>> functions;
   {
     std::lock_guard lock(m_mutex);
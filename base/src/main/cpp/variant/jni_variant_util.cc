@@ -1,5 +1,6 @@
 #include <cassert>
 #include "jni_variant_util.h"
+#include "variant_hash_map.h"
 
 // Check for JNI exceptions, report them if any, and clear them.
 bool CheckAndClearJniExceptions(JNIEnv* env) {
@@ -575,6 +576,8 @@ jobject VariantToJavaObject(JNIEnv* env, const FOREVER::Variant& variant) {
     return VariantVectorToJavaList(env, variant.vector());
   } else if (variant.is_map()) {
     return VariantMapToJavaMap(env, variant.map());
+  } else if (variant.is_hash_map()) {
+    return VariantMapToJavaMap(env, variant.hash_map());
   } else {
     // Unsupported type.
     assert("Variant cannot be converted to Java Object, returning null.");
@@ -603,12 +606,12 @@ jobject VariantVectorToJavaList(
   return java_list;
 }
 
-// Converts a `std::map<Variant, Variant>` to a `java.util.Map<Object, Object>`.
-// Returns a local ref to a Map.
-jobject VariantMapToJavaMap(
-    JNIEnv* env,
-    const std::map<FOREVER::Variant, FOREVER::Variant>& variant_map) {
-  jclass hash_map = env->FindClass("java/util/HashMap");
+// Puts the entries of a `std::map<Variant, Variant>` or `VariantHashMap` into a
+// new instance of `map_class_name`. Returns a local ref to a Map.
+template <typename MapType>
+static jobject MapEntriesToJavaMap(JNIEnv* env, const MapType& variant_map,
+                                   const char* map_class_name) {
+  jclass hash_map = env->FindClass(map_class_name);
   jmethodID hash_map_constructor_method_id =
       env->GetMethodID(hash_map, "<init>", "()V");
   jmethodID hash_map_put_method_id = env->GetMethodID(
@@ -628,6 +631,24 @@ jobject VariantMapToJavaMap(
   return java_map;
 }
 
+// Converts a `std::map<Variant, Variant>` to a `java.util.Map<Object, Object>`.
+// Returns a local ref to a Map.
+jobject VariantMapToJavaMap(
+    JNIEnv* env,
+    const std::map<FOREVER::Variant, FOREVER::Variant>& variant_map) {
+  return MapEntriesToJavaMap(env, variant_map, "java/util/HashMap");
+}
+
+// Converts a `VariantHashMap` to a `java.util.Map<Object, Object>`, keeping
+// insertion order if the map does. Returns a local ref to a Map.
+jobject VariantMapToJavaMap(JNIEnv* env,
+                            const FOREVER::VariantHashMap& variant_map) {
+  return MapEntriesToJavaMap(env, variant_map,
+                             variant_map.insertion_ordered()
+                                 ? "java/util/LinkedHashMap"
+                                 : "java/util/HashMap");
+}
+
 FOREVER::Variant JavaObjectToVariant(JNIEnv* env, jobject object) {
   if (object == nullptr) return FOREVER::Variant();
   jclass string_class = env->FindClass("java/lang/String");
@@ -155,6 +155,8 @@ jobject VariantVectorToJavaList(
 jobject VariantMapToJavaMap(
     JNIEnv* env,
     const std::map<FOREVER::Variant, FOREVER::Variant>& variant_map);
+jobject VariantMapToJavaMap(JNIEnv* env,
+                            const FOREVER::VariantHashMap& variant_map);
 // Convert a generic Java object into our Variant class.
 // Can be recursive. That is, Variant might be a map of Variants, which are
 // array of Variants, etc.
@@ -3,13 +3,114 @@
 #include <limits.h>
 #include <stdlib.h>
 
+#include <algorithm>
+#include <functional>
 #include <iomanip>
 #include <sstream>
+#include <string_view>
+#include <utility>
+
+#include "variant_hash_map.h"
 
 namespace FOREVER {
 
+namespace {
+
+uint64_t MixHash(uint64_t h) {
+  // Finalizer of MurmurHash3, so that identity-like std::hash results still
+  // spread over the whole word.
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+uint64_t CombineHash(uint64_t seed, uint64_t value) {
+  return seed ^ (MixHash(value) + 0x9e3779b97f4a7c15ULL + (seed << 6) +
+                 (seed >> 2));
+}
+
+typedef std::vector<std::pair<const Variant*, const Variant*>> SortedEntries;
+
+// Entries of a Map or HashMap variant, ordered by key.
+SortedEntries GetSortedEntries(const Variant& variant) {
+  SortedEntries entries;
+  if (variant.is_map()) {
+    entries.reserve(variant.map().size());
+    for (const auto& entry : variant.map()) {
+      entries.emplace_back(&entry.first, &entry.second);
+    }
+  } else {
+    entries.reserve(variant.hash_map().size());
+    for (const auto& entry : variant.hash_map()) {
+      entries.emplace_back(&entry.first, &entry.second);
+    }
+    std::sort(entries.begin(), entries.end(),
+              [](const SortedEntries::value_type& a,
+                 const SortedEntries::value_type& b) {
+                return *a.first < *b.first;
+              });
+  }
+  return entries;
+}
+
+// Compares a Map and a HashMap, in either order, by content.
+bool MixedMapsEqual(const Variant& a, const Variant& b) {
+  const Variant& map = a.is_map() ? a : b;
+  const VariantHashMap& hash_map = a.is_map() ? b.hash_map() : a.hash_map();
+  if (map.map().size() != hash_map.size()) return false;
+  for (const auto& entry : map.map()) {
+    const Variant* value = hash_map.Find(entry.first);
+    if (value == nullptr || *value != entry.second) return false;
+  }
+  return true;
+}
+
+}  // namespace
+
 Variant& Variant::operator=(const Variant& other) {
   if (this != &other) {
+    switch (other.type_) {
+      case kInternalTypeMutableString:
+      case kInternalTypeVector:
+      case kInternalTypeMap:
+      case kInternalTypeHashMap: {
+        // Share the payload instead of copying it. Take the reference before
+        // releasing ours, in case both already point to the same one, and
+        // read |other| only before Clear(), which may free it if it is an
+        // element of our own payload.
+        const InternalType type = other.type_;
+        Value shared = other.value_;
+        switch (type) {
+          case kInternalTypeMutableString:
+            Share(shared.mutable_string_value);
+            break;
+          case kInternalTypeVector:
+            Share(shared.vector_value);
+            break;
+          case kInternalTypeMap:
+            Share(shared.map_value);
+            break;
+          default:
+            Share(shared.hash_map_value);
+            break;
+        }
+        Clear();
+        type_ = type;
+        value_ = shared;
+        return *this;
+      }
+      default:
+        break;
+    }
+    if (is_container_type()) {
+      // |other| may be an element of the payload Clear() frees; copy it out
+      // first.
+      Variant copy(other);
+      return *this = std::move(copy);
+    }
     Clear(static_cast<Type>(other.type_));
     switch (type_) {
       case kInternalTypeNull: {
@@ -31,22 +132,16 @@ Variant& Variant::operator=(const Variant& other) {
         set_string_value(other.string_value());
         break;
       }
-      case kInternalTypeMutableString: {
-        set_mutable_string(other.mutable_string());
-        break;
-      }
       case kInternalTypeSmallString: {
         strcpy(value_.small_string, other.value_.small_string);  // NOLINT
         break;
       }
-      case kInternalTypeVector: {
-        set_vector(other.vector());
+      case kInternalTypeMutableString:
+      case kInternalTypeVector:
+      case kInternalTypeMap:
+      case kInternalTypeHashMap:
+        // Shared above.
         break;
-      }
-      case kInternalTypeMap: {
-        set_map(other.map());
-        break;
-      }
       case kInternalTypeStaticBlob: {
         set_blob_pointer(other.value_.blob_value.ptr,
                          other.value_.blob_value.size);
@@ -67,6 +162,12 @@ Variant& Variant::operator=(const Variant& other) {
 
 Variant& Variant::operator=(Variant&& other) noexcept {
   if (this != &other) {
+    if (is_container_type()) {
+      // As in the copy assignment, |other| may live in our own payload.
+      Variant moved(std::move(other));
+      Clear();
+      return *this = std::move(moved);
+    }
     Clear();
     type_ = other.type_;
     other.type_ = kInternalTypeNull;
@@ -112,6 +213,11 @@ Variant& Variant::operator=(Variant&& other) noexcept {
         other.value_.map_value = nullptr;
         break;
       }
+      case kInternalTypeHashMap: {
+        value_.hash_map_value = other.value_.hash_map_value;
+        other.value_.hash_map_value = nullptr;
+        break;
+      }
       case kInternalTypeStaticBlob: {
         set_static_blob(other.value_.blob_value.ptr,
                         other.value_.blob_value.size);
@@ -133,9 +239,11 @@ Variant& Variant::operator=(Variant&& other) noexcept {
 }
 
 bool Variant::operator==(const Variant& other) const {
-  // If types don't match and we aren't both strings or blobs, fail.
+  // If types don't match and we aren't both strings, blobs or maps, fail.
+  const bool both_maps = (is_map() || is_hash_map()) &&
+                         (other.is_map() || other.is_hash_map());
   if (type_ != other.type_ && !(is_string() && other.is_string()) &&
-      !(is_blob() && other.is_blob()))
+      !(is_blob() && other.is_blob()) && !both_maps)
     return false;
   // Now we know their types are equivalent. So:
   switch (type_) {
@@ -153,11 +261,19 @@ bool Variant::operator==(const Variant& other) const {
       // string == performs string comparison
       return strcmp(string_value(), other.string_value()) == 0;
     case kInternalTypeVector:
+      // Copies share their payload, which is then trivially equal.
+      if (value_.vector_value == other.value_.vector_value) return true;
       // std::vector == performs element-by-element comparison
       return vector() == other.vector();
     case kInternalTypeMap:
+      if (other.is_hash_map()) return MixedMapsEqual(*this, other);
+      if (value_.map_value == other.value_.map_value) return true;
       // std::map == performs element-by-element comparison
       return map() == other.map();
+    case kInternalTypeHashMap:
+      if (other.is_map()) return MixedMapsEqual(*this, other);
+      if (value_.hash_map_value == other.value_.hash_map_value) return true;
+      return hash_map() == other.hash_map();
     case kInternalTypeStaticBlob:
     case kInternalTypeMutableBlob:
       // Return true if both are static blobs with the same pointers, otherwise
@@ -201,6 +317,14 @@ bool Variant::operator<(const Variant& other) const {
     right_type = kTypeStaticBlob;
   }
 
+  // Both map types order by content.
+  if (is_hash_map()) {
+    left_type = kTypeMap;
+  }
+  if (other.is_hash_map()) {
+    right_type = kTypeMap;
+  }
+
   // If the types don't match (except count both string types as matching, and
   // both blob types as matching), compare the types.
   if (left_type != right_type)
@@ -235,7 +359,19 @@ bool Variant::operator<(const Variant& other) const {
       if (i != vector().end() && j == other.vector().end()) return false;
       return false;  // Equal!
     }
-    case kInternalTypeMap: {
+    case kInternalTypeMap:
+    case kInternalTypeHashMap: {
+      if (is_hash_map() || other.is_hash_map()) {
+        const SortedEntries left = GetSortedEntries(*this);
+        const SortedEntries right = GetSortedEntries(other);
+        auto i = left.begin();
+        auto j = right.begin();
+        for (; i != left.end() && j != right.end(); ++i, ++j) {
+          if (*i->first != *j->first) return *i->first < *j->first;
+          if (*i->second != *j->second) return *i->second < *j->second;
+        }
+        return i == left.end() && j != right.end();
+      }
       auto i = map().begin();
       auto j = other.map().begin();
       for (; i != map().end() && j != other.map().end(); ++i, ++j) {
@@ -283,11 +419,12 @@ void Variant::Clear(Type new_type) {
     }
     case kInternalTypeMutableString: {
       if (new_type != kTypeMutableString ||
-          value_.mutable_string_value == nullptr) {
-        delete value_.mutable_string_value;
+          value_.mutable_string_value == nullptr ||
+          IsShared(value_.mutable_string_value)) {
+        Release(value_.mutable_string_value);
         value_.mutable_string_value = nullptr;
       } else {
-        value_.mutable_string_value->clear();
+        value_.mutable_string_value->value.clear();
       }
       break;
     }
@@ -296,20 +433,32 @@ void Variant::Clear(Type new_type) {
       break;
     }
     case kInternalTypeVector: {
-      if (new_type != kTypeVector || value_.vector_value == nullptr) {
-        delete value_.vector_value;
+      if (new_type != kTypeVector || value_.vector_value == nullptr ||
+          IsShared(value_.vector_value)) {
+        Release(value_.vector_value);
         value_.vector_value = nullptr;
       } else {
-        value_.vector_value->clear();
+        value_.vector_value->value.clear();
       }
       break;
     }
     case kInternalTypeMap: {
-      if (new_type != kTypeMap || value_.map_value == nullptr) {
-        delete value_.map_value;
+      if (new_type != kTypeMap || value_.map_value == nullptr ||
+          IsShared(value_.map_value)) {
+        Release(value_.map_value);
         value_.map_value = nullptr;
       } else {
-        value_.map_value->clear();
+        value_.map_value->value.clear();
+      }
+      break;
+    }
+    case kInternalTypeHashMap: {
+      if (new_type != kTypeHashMap || value_.hash_map_value == nullptr ||
+          IsShared(value_.hash_map_value)) {
+        Release(value_.hash_map_value);
+        value_.hash_map_value = nullptr;
+      } else {
+        value_.hash_map_value->value.clear();
       }
       break;
     }
@@ -353,7 +502,7 @@ void Variant::Clear(Type new_type) {
     case kInternalTypeMutableString: {
       if (old_type != kInternalTypeMutableString ||
           value_.mutable_string_value == nullptr) {
-        value_.mutable_string_value = new std::string();
+        value_.mutable_string_value = new SharedPayload<std::string>();
       }
       break;
     }
@@ -363,13 +512,20 @@ void Variant::Clear(Type new_type) {
     }
     case kInternalTypeVector: {
       if (old_type != kInternalTypeVector || value_.vector_value == nullptr) {
-        value_.vector_value = new std::vector<Variant>(0);
+        value_.vector_value = new SharedPayload<std::vector<Variant>>();
       }
       break;
     }
     case kInternalTypeMap: {
       if (old_type != kInternalTypeMap || value_.map_value == nullptr) {
-        value_.map_value = new std::map<Variant, Variant>();
+        value_.map_value = new SharedPayload<std::map<Variant, Variant>>();
+      }
+      break;
+    }
+    case kInternalTypeHashMap: {
+      if (old_type != kInternalTypeHashMap ||
+          value_.hash_map_value == nullptr) {
+        value_.hash_map_value = new SharedPayload<VariantHashMap>();
       }
       break;
     }
@@ -391,7 +547,8 @@ const char* const Variant::kTypeNames[] = {
     // In case you want to iterate through these for some reason.
     "Null",         "Int64",         "Double",      "Bool",
     "StaticString", "MutableString", "Vector",      "Map",
-    "StaticBlob",   "MutableBlob",   "SmallString", nullptr,
+    "StaticBlob",   "MutableBlob",   "HashMap",     "SmallString",
+    nullptr,
 };
 
 void Variant::assert_is_type(Variant::Type type) const {
@@ -426,6 +583,96 @@ void Variant::assert_is_blob() const {
 
 #define INT64FORMAT "%jd"
 
+Variant Variant::EmptyHashMap(bool insertion_ordered) {
+  Variant v;
+  v.type_ = kInternalTypeHashMap;
+  v.value_.hash_map_value =
+      new SharedPayload<VariantHashMap>(insertion_ordered);
+  return v;
+}
+
+VariantHashMap& Variant::hash_map() {
+  assert_is_type(kTypeHashMap);
+  return Unshare(&value_.hash_map_value);
+}
+
+const VariantHashMap& Variant::hash_map() const {
+  assert_is_type(kTypeHashMap);
+  return value_.hash_map_value->value;
+}
+
+size_t Variant::HashString(const char* data, size_t size) {
+  return static_cast<size_t>(CombineHash(
+      kTypeStaticString, std::hash<std::string_view>()(
+                             std::string_view(data, size))));
+}
+
+size_t Variant::Hash::operator()(const Variant& variant) const {
+  uint64_t hash = 0;
+  switch (variant.type_) {
+    case kInternalTypeNull: {
+      hash = MixHash(kTypeNull);
+      break;
+    }
+    case kInternalTypeInt64: {
+      hash = CombineHash(kTypeInt64, variant.int64_value());
+      break;
+    }
+    case kInternalTypeDouble: {
+      // 0.0 == -0.0, so they must hash the same.
+      double value = variant.double_value();
+      hash = CombineHash(kTypeDouble,
+                         std::hash<double>()(value == 0 ? 0.0 : value));
+      break;
+    }
+    case kInternalTypeBool: {
+      hash = CombineHash(kTypeBool, variant.bool_value());
+      break;
+    }
+    case kInternalTypeMutableString:
+    case kInternalTypeStaticString:
+    case kInternalTypeSmallString: {
+      const char* str = variant.string_value();
+      return HashString(str, strlen(str));
+    }
+    case kInternalTypeVector: {
+      hash = kTypeVector;
+      for (const Variant& item : variant.vector()) {
+        hash = CombineHash(hash, (*this)(item));
+      }
+      break;
+    }
+    case kInternalTypeMap:
+    case kInternalTypeHashMap: {
+      // Order-independent, so that both map types agree.
+      uint64_t sum = 0;
+      if (variant.is_map()) {
+        for (const auto& entry : variant.map()) {
+          sum += CombineHash((*this)(entry.first), (*this)(entry.second));
+        }
+      } else {
+        for (const auto& entry : variant.hash_map()) {
+          sum += CombineHash((*this)(entry.first), (*this)(entry.second));
+        }
+      }
+      hash = CombineHash(kTypeMap, sum);
+      break;
+    }
+    case kInternalTypeStaticBlob:
+    case kInternalTypeMutableBlob: {
+      hash = CombineHash(
+          kTypeStaticBlob,
+          std::hash<std::string_view>()(std::string_view(
+              reinterpret_cast<const char*>(variant.blob_data()),
+              variant.blob_size())));
+      break;
+    }
+    case kMaxTypeValue:
+      break;
+  }
+  return static_cast<size_t>(hash);
+}
+
 Variant Variant::AsString() const {
   static const size_t kBufferSize = 64;
   switch (type_) {
@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 
+#include <atomic>
 #include <cstring>
 #include <map>
 #include <string>
@@ -15,6 +16,7 @@ namespace FOREVER {
 namespace INTERNAL {
 class VariantInternal;
 }
+class VariantHashMap;
 }  // namespace FOREVER
 
 namespace FOREVER {
@@ -54,6 +56,10 @@ class Variant {
     /// Variant::FromMutableBlob() to create a Variant of this type, and copy
     /// binary data from an existing source.
     kTypeMutableBlob,
+    /// A VariantHashMap, mapping Variant to Variant through a hash table.
+    /// Never constructed by default. Use Variant::EmptyHashMap() to create a
+    /// Variant of this type.
+    kTypeHashMap,
 
     // Note: If you add new types update enum InternalType;
   };
@@ -200,12 +206,18 @@ class Variant {
     }
   }
 
-  /// @brief Copy constructor. Performs a deep copy.
+  /// @brief Copy constructor.
+  ///
+  /// Vectors, maps and mutable strings are not copied: both Variants share
+  /// the same reference-counted payload, which is copied the first time
+  /// either of them is accessed through a mutable accessor (copy-on-write).
+  /// Copies can therefore be handed to other threads in O(1).
   ///
   /// @param[in] other Source Variant to copy from.
   Variant(const Variant& other) : type_(kInternalTypeNull) { *this = other; }
 
-  /// @brief Copy assignment operator. Performs a deep copy.
+  /// @brief Copy assignment operator. Shares payloads like the copy
+  /// constructor.
   ///
   /// @param[in] other Source Variant to copy from.
   Variant& operator=(const Variant& other);
@@ -381,6 +393,15 @@ class Variant {
     return v;
   }
 
+  /// @brief Get a Variant containing an empty hash map. You can immediately
+  /// call hash_map() on it to work with the map it contains.
+  ///
+  /// @param[in] insertion_ordered Whether iteration should follow insertion
+  /// order. Otherwise the order is unspecified, which makes erasing cheaper.
+  ///
+  /// @return A Variant of type HashMap, containing no elements.
+  static Variant EmptyHashMap(bool insertion_ordered = false);
+
   /// @brief Return a Variant containing an empty mutable blob of the requested
   /// size, filled with 0-bytes.
   ///
@@ -440,6 +461,11 @@ class Variant {
   /// @return True if the Variant's type is Map, false otherwise.
   bool is_map() const { return type() == kTypeMap; }
 
+  /// @brief Get whether this Variant contains a hash map.
+  ///
+  /// @return True if the Variant's type is HashMap, false otherwise.
+  bool is_hash_map() const { return type() == kTypeHashMap; }
+
   /// @brief Get whether this Variant contains a static string.
   ///
   /// @return True if the Variant's type is StaticString, false otherwise.
@@ -496,10 +522,14 @@ class Variant {
     return is_int64() || is_double() || is_string() || is_bool() || is_null();
   }
 
-  /// @brief Get whether this Variant contains a container type: Vector or Map.
+  /// @brief Get whether this Variant contains a container type: Vector, Map or
+  /// HashMap.
   ///
-  /// @return True if the Variant's type is Vector or Map; false otherwise.
-  bool is_container_type() const { return is_vector() || is_map(); }
+  /// @return True if the Variant's type is Vector, Map or HashMap; false
+  /// otherwise.
+  bool is_container_type() const {
+    return is_vector() || is_map() || is_hash_map();
+  }
 
   /// @brief Get the current Variant converted into a string. Only valid for
   /// fundamental types.
@@ -550,6 +580,9 @@ class Variant {
   /// @return Reference to the string contained in this Variant.
   ///
   /// @note If the Variant is not one of the two String types, this will assert.
+  ///
+  /// @note If the string is shared with a copy of this Variant it is copied
+  /// first. The reference must not be used after this Variant is copied.
   std::string& mutable_string() {
     if (type_ == kInternalTypeStaticString ||
         type_ == kInternalTypeSmallString) {
@@ -557,7 +590,7 @@ class Variant {
       set_mutable_string(string_value(), false);
     }
     assert_is_type(kTypeMutableString);
-    return *value_.mutable_string_value;
+    return Unshare(&value_.mutable_string_value);
   }
 
   /// @brief Get the size of a blob. This method works with both static
@@ -615,20 +648,39 @@ class Variant {
   /// @return Reference to the vector contained in this Variant.
   ///
   /// @note If the Variant is not of Vector type, this will assert.
+  ///
+  /// @note If the vector is shared with a copy of this Variant it is copied
+  /// first. The reference must not be used after this Variant is copied.
   std::vector<Variant>& vector() {
     assert_is_type(kTypeVector);
-    return *value_.vector_value;
+    return Unshare(&value_.vector_value);
   }
   /// @brief Mutable accessor for a Variant containing a map of Variant data.
   ///
   /// @return Reference to the map contained in this Variant.
   ///
   /// @note If the Variant is not of Map type, this will assert.
+  ///
+  /// @note If the map is shared with a copy of this Variant it is copied
+  /// first. The reference must not be used after this Variant is copied.
   std::map<Variant, Variant>& map() {
     assert_is_type(kTypeMap);
-    return *value_.map_value;
+    return Unshare(&value_.map_value);
   }
 
+  /// @brief Mutable accessor for a Variant containing a hash map.
+  ///
+  /// @return Reference to the hash map contained in this Variant.
+  ///
+  /// @note If the Variant is not of HashMap type, this will assert.
+  ///
+  /// @note If the map is shared with a copy of this Variant it is copied
+  /// first. The reference must not be used after this Variant is copied.
+  ///
+  /// @note Entries are stored in a vector, so inserting into the map
+  /// invalidates references to its values; see VariantHashMap.
+  VariantHashMap& hash_map();
+
   /// @brief Const accessor for a Variant containing an integer.
   ///
   /// @return The integer contained in this Variant.
@@ -671,13 +723,24 @@ class Variant {
   const char* string_value() const {
     assert_is_string();
     if (type_ == kInternalTypeMutableString)
-      return value_.mutable_string_value->c_str();
+      return value_.mutable_string_value->value.c_str();
     else if (type_ == kInternalTypeStaticString)
       return value_.static_string_value;
     else  // if (type_ == kInternalTypeSmallString)
       return value_.small_string;
   }
 
+  /// @brief Get the length of the string contained in this Variant.
+  ///
+  /// @return Number of characters in the string, which for a mutable string
+  /// may exceed strlen(string_value()) if it contains NUL characters.
+  size_t string_length() const {
+    assert_is_string();
+    if (type_ == kInternalTypeMutableString)
+      return value_.mutable_string_value->value.size();
+    return strlen(string_value());
+  }
+
   /// @brief Const accessor for a Variant containing a string.
   ///
   /// @note Unlike the non-const accessor, this accessor cannot "promote" a
@@ -695,9 +758,12 @@ class Variant {
   /// @return Reference to the vector contained in this Variant.
   ///
   /// @note If the Variant is not of Vector type, this will assert.
+  ///
+  /// @note The vector may be shared with copies of this Variant. The
+  /// reference goes stale once this Variant is modified or destroyed.
   const std::vector<Variant>& vector() const {
     assert_is_type(kTypeVector);
-    return *value_.vector_value;
+    return value_.vector_value->value;
   }
 
   /// @brief Const accessor for a Variant containing a map of strings to
@@ -707,11 +773,24 @@ class Variant {
   /// @return Reference to the map contained in this Variant.
   ///
   /// @note If the Variant is not of Map type, this will assert.
+  ///
+  /// @note The map may be shared with copies of this Variant. The reference
+  /// goes stale once this Variant is modified or destroyed.
   const std::map<Variant, Variant>& map() const {
     assert_is_type(kTypeMap);
-    return *value_.map_value;
+    return value_.map_value->value;
   }
 
+  /// @brief Const accessor for a Variant containing a hash map.
+  ///
+  /// @return Reference to the hash map contained in this Variant.
+  ///
+  /// @note If the Variant is not of HashMap type, this will assert.
+  ///
+  /// @note The map may be shared with copies of this Variant. The reference
+  /// goes stale once this Variant is modified or destroyed.
+  const VariantHashMap& hash_map() const;
+
   /// @brief Sets the Variant value to null.
   ///
   /// The Variant's type will be Null.
@@ -803,7 +882,7 @@ class Variant {
       strncpy(value_.small_string, value.data(), value.size() + 1);
     } else {
       Clear(kTypeMutableString);
-      *value_.mutable_string_value = value;
+      value_.mutable_string_value->value = value;
     }
   }
 
@@ -850,7 +929,7 @@ class Variant {
 
   void set_vector(const std::vector<Variant>& value) {
     Clear(kTypeVector);
-    *value_.vector_value = value;
+    value_.vector_value->value = value;
   }
 
   /// @brief Sets the Variant to a copy of the given map.
@@ -860,14 +939,16 @@ class Variant {
   /// @param[in] value The STL map to copy into the Variant.
   void set_map(const std::map<Variant, Variant>& value) {
     Clear(kTypeMap);
-    *value_.map_value = value;
+    value_.map_value->value = value;
   }
 
   /// @brief Assigns an existing string which was allocated on the heap into the
   /// Variant without performing a copy. This object will take over ownership of
   /// the pointer, and will set the std::string* you pass in to NULL.
   ///
-  /// The Variant's type will be set to MutableString.
+  /// The Variant's type will be set to MutableString. The contents are moved
+  /// into the Variant's reference-counted payload and the passed object is
+  /// deleted.
   ///
   /// @param[in, out] str Pointer to a pointer to an STL string. The Variant
   /// will take over ownership of the pointer to the string, and set the
@@ -876,7 +957,9 @@ class Variant {
   void AssignMutableString(std::string** str) {
     Clear(kTypeNull);
     type_ = kInternalTypeMutableString;
-    value_.mutable_string_value = *str;
+    value_.mutable_string_value =
+        new SharedPayload<std::string>(std::move(**str));
+    delete *str;
     *str = NULL;  // NOLINT
   }
 
@@ -884,7 +967,8 @@ class Variant {
   /// Variant without performing a copy. This object will take over ownership of
   /// the pointer, and will set the std::vector* you pass in to NULL.
   ///
-  /// The Variant's type will be set to Vector.
+  /// The Variant's type will be set to Vector. The contents are moved into the
+  /// Variant's reference-counted payload and the passed object is deleted.
   ///
   /// @param[in, out] vect Pointer to a pointer to an STL vector. The Variant
   /// will take over ownership of the pointer to the vector, and set the
@@ -893,7 +977,9 @@ class Variant {
   void AssignVector(std::vector<Variant>** vect) {
     Clear(kTypeNull);
     type_ = kInternalTypeVector;
-    value_.vector_value = *vect;
+    value_.vector_value =
+        new SharedPayload<std::vector<Variant>>(std::move(**vect));
+    delete *vect;
     *vect = NULL;  // NOLINT
   }
 
@@ -902,7 +988,8 @@ class Variant {
   /// of
   /// the map, and will set the std::map** you pass in to NULL.
   ///
-  /// The Variant's type will be set to Map.
+  /// The Variant's type will be set to Map. The contents are moved into the
+  /// Variant's reference-counted payload and the passed object is deleted.
   ///
   /// @param[in, out] map Pointer to a pointer to an STL map. The Variant will
   /// take over ownership of the pointer to the map, and set the pointer you
@@ -910,7 +997,9 @@ class Variant {
   void AssignMap(std::map<Variant, Variant>** map) {
     Clear(kTypeNull);
     type_ = kInternalTypeMap;
-    value_.map_value = *map;
+    value_.map_value =
+        new SharedPayload<std::map<Variant, Variant>>(std::move(**map));
+    delete *map;
     *map = NULL;  // NOLINT
   }
 
@@ -1014,6 +1103,19 @@ class Variant {
   /// debugging. For example "Int64" or "MutableString".
   static const char* TypeName(Type type);
 
+  /// @brief Hash functor consistent with operator==.
+  ///
+  /// Equal Variants hash equally: all string types hash by content, as do both
+  /// blob types, and a Map and a HashMap with the same entries hash the same.
+  /// Use it to key hash containers by Variant.
+  struct Hash {
+    size_t operator()(const Variant& variant) const;
+  };
+
+  /// @brief Hash of a string's contents, as Hash computes it for string
+  /// Variants. Lets hash containers be probed without building a Variant.
+  static size_t HashString(const char* data, size_t size);
+
  private:
   // Internal Type of data that this variant object contains to avoid breaking
   // API
@@ -1042,9 +1144,11 @@ class Variant {
     /// Variant::FromMutableBlob() to create a Variant of this type, and copy
     /// binary data from an existing source.
     kInternalTypeMutableBlob = kTypeMutableBlob,
+    /// A VariantHashMap, mapping Variant to Variant through a hash table.
+    kInternalTypeHashMap = kTypeHashMap,
     // A c string stored in the Variant internal data blob as opposed to be
     // newed as a std::string. Max size is 16 bytes on x64 and 8 bytes on x86.
-    kInternalTypeSmallString = kTypeMutableBlob + 1,
+    kInternalTypeSmallString = kTypeHashMap + 1,
     // Not a valid type. Used to get the total number of Variant types.
     kMaxTypeValue,
   };
@@ -1084,6 +1188,50 @@ class Variant {
   // Get whether this Variant contains a small string.
   bool is_small_string() const { return type_ == kInternalTypeSmallString; }
 
+  // Heap payload of a vector, map, hash map or mutable string. Copies of a
+  // Variant point to the same payload; mutable accessors go through Unshare()
+  // so that a shared payload is never written to.
+  template <typename T>
+  struct SharedPayload {
+    template <typename... Args>
+    explicit SharedPayload(Args&&... args)
+        : value(std::forward<Args>(args)...) {}
+
+    std::atomic<int32_t> ref_count{1};
+    T value;
+  };
+
+  template <typename T>
+  static SharedPayload<T>* Share(SharedPayload<T>* payload) {
+    payload->ref_count.fetch_add(1, std::memory_order_relaxed);
+    return payload;
+  }
+
+  template <typename T>
+  static void Release(SharedPayload<T>* payload) {
+    if (payload != nullptr &&
+        payload->ref_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete payload;
+    }
+  }
+
+  // Whether `payload` is referenced by another Variant as well.
+  template <typename T>
+  static bool IsShared(const SharedPayload<T>* payload) {
+    return payload->ref_count.load(std::memory_order_acquire) != 1;
+  }
+
+  // Gives `*payload` a private copy if it is shared, and returns its value.
+  template <typename T>
+  static T& Unshare(SharedPayload<T>** payload) {
+    if (IsShared(*payload)) {
+      SharedPayload<T>* copy = new SharedPayload<T>((*payload)->value);
+      Release(*payload);
+      *payload = copy;
+    }
+    return (*payload)->value;
+  }
+
   // Current type contained in this Variant.
   InternalType type_;
 
@@ -1100,9 +1248,10 @@ class Variant {
     double double_value;
     bool bool_value;
     const char* static_string_value;
-    std::string* mutable_string_value;
-    std::vector<Variant>* vector_value;
-    std::map<Variant, Variant>* map_value;
+    SharedPayload<std::string>* mutable_string_value;
+    SharedPayload<std::vector<Variant>>* vector_value;
+    SharedPayload<std::map<Variant, Variant>>* map_value;
+    SharedPayload<VariantHashMap>* hash_map_value;
     BlobValue blob_value;
     char small_string[sizeof(BlobValue)];
   } value_;
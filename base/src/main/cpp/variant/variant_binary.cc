@@ -0,0 +1,322 @@
+#include "variant_binary.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "variant_hash_map.h"
+
+namespace FOREVER {
+namespace UTIL {
+
+namespace {
+
+constexpr uint8_t kFormatVersion = 1;
+constexpr int kMaxDepth = 128;
+constexpr uint64_t kMaxReserve = 1024;
+// A two-byte interned string ref can stand for a string as long as the whole
+// input, so the bytes they expand to are capped at this multiple of its size.
+constexpr uint64_t kMaxRefExpansion = 64;
+
+enum Tag : uint8_t {
+  kTagNull = 0,
+  kTagFalse = 1,
+  kTagTrue = 2,
+  kTagInt64 = 3,
+  kTagDouble = 4,
+  kTagString = 5,
+  kTagBlob = 6,
+  kTagVector = 7,
+  kTagMap = 8,
+  kTagInternedString = 9,
+  kTagInternedStringRef = 10,
+};
+
+class BinaryWriter {
+ public:
+  BinaryWriter(bool intern_keys, std::vector<uint8_t>* out)
+      : intern_keys_(intern_keys), out_(out) {}
+
+  void Write(const Variant& variant, bool is_key) {
+    switch (variant.type()) {
+      case Variant::kTypeNull: {
+        out_->push_back(kTagNull);
+        break;
+      }
+      case Variant::kTypeInt64: {
+        out_->push_back(kTagInt64);
+        const uint64_t value = static_cast<uint64_t>(variant.int64_value());
+        // Zigzag so that small negative numbers stay short.
+        WriteVarint((value << 1) ^ (variant.int64_value() < 0 ? ~0ULL : 0));
+        break;
+      }
+      case Variant::kTypeDouble: {
+        out_->push_back(kTagDouble);
+        const double value = variant.double_value();
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        for (int i = 0; i < 8; i++) {
+          out_->push_back(static_cast<uint8_t>(bits >> (8 * i)));
+        }
+        break;
+      }
+      case Variant::kTypeBool: {
+        out_->push_back(variant.bool_value() ? kTagTrue : kTagFalse);
+        break;
+      }
+      case Variant::kTypeStaticString:
+      case Variant::kTypeMutableString: {
+        // Mutable strings may hold NUL characters, so take the real length
+        // rather than strlen(); a const mutable_string() would return a copy.
+        const char* str = variant.string_value();
+        const size_t len = variant.string_length();
+        if (is_key && intern_keys_) {
+          auto inserted = interned_.emplace(std::string_view(str, len),
+                                            interned_.size());
+          if (!inserted.second) {
+            out_->push_back(kTagInternedStringRef);
+            WriteVarint(inserted.first->second);
+            break;
+          }
+          out_->push_back(kTagInternedString);
+        } else {
+          out_->push_back(kTagString);
+        }
+        WriteBytes(str, len);
+        break;
+      }
+      case Variant::kTypeVector: {
+        out_->push_back(kTagVector);
+        WriteVarint(variant.vector().size());
+        for (const Variant& item : variant.vector()) {
+          Write(item, false);
+        }
+        break;
+      }
+      case Variant::kTypeMap: {
+        WriteMap(variant.map());
+        break;
+      }
+      case Variant::kTypeHashMap: {
+        WriteMap(variant.hash_map());
+        break;
+      }
+      case Variant::kTypeStaticBlob:
+      case Variant::kTypeMutableBlob: {
+        out_->push_back(kTagBlob);
+        WriteBytes(variant.blob_data(), variant.blob_size());
+        break;
+      }
+    }
+  }
+
+ private:
+  template <typename MapType>
+  void WriteMap(const MapType& map) {
+    out_->push_back(kTagMap);
+    WriteVarint(map.size());
+    for (const auto& entry : map) {
+      Write(entry.first, true);
+      Write(entry.second, false);
+    }
+  }
+
+  void WriteVarint(uint64_t value) {
+    while (value >= 0x80) {
+      out_->push_back(static_cast<uint8_t>(value) | 0x80);
+      value >>= 7;
+    }
+    out_->push_back(static_cast<uint8_t>(value));
+  }
+
+  void WriteBytes(const void* data, size_t size) {
+    WriteVarint(size);
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    out_->insert(out_->end(), bytes, bytes + size);
+  }
+
+  const bool intern_keys_;
+  std::vector<uint8_t>* out_;
+  // Points into the strings of the Variant being written, which outlives the
+  // writer.
+  std::unordered_map<std::string_view, uint64_t> interned_;
+};
+
+class BinaryReader {
+ public:
+  BinaryReader(const uint8_t* data, size_t size)
+      : cur_(data),
+        end_(data + size),
+        ref_budget_(static_cast<uint64_t>(size) * kMaxRefExpansion) {}
+
+  bool Read(Variant* out, int depth) {
+    if (depth > kMaxDepth) return false;
+    uint8_t tag;
+    if (!ReadByte(&tag)) return false;
+    switch (tag) {
+      case kTagNull: {
+        out->set_null();
+        return true;
+      }
+      case kTagFalse:
+      case kTagTrue: {
+        out->set_bool_value(tag == kTagTrue);
+        return true;
+      }
+      case kTagInt64: {
+        uint64_t value;
+        if (!ReadVarint(&value)) return false;
+        out->set_int64_value(
+            static_cast<int64_t>((value >> 1) ^ (~(value & 1) + 1)));
+        return true;
+      }
+      case kTagDouble: {
+        if (Remaining() < 8) return false;
+        uint64_t bits = 0;
+        for (int i = 0; i < 8; i++) {
+          bits |= static_cast<uint64_t>(cur_[i]) << (8 * i);
+        }
+        cur_ += 8;
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        out->set_double_value(value);
+        return true;
+      }
+      case kTagString:
+      case kTagInternedString: {
+        std::string_view str;
+        if (!ReadBytes(&str)) return false;
+        if (tag == kTagInternedString) interned_.push_back(str);
+        SetString(str, out);
+        return true;
+      }
+      case kTagInternedStringRef: {
+        uint64_t index;
+        if (!ReadVarint(&index) || index >= interned_.size()) return false;
+        const std::string_view str = interned_[index];
+        if (str.size() > ref_budget_) return false;
+        ref_budget_ -= str.size();
+        SetString(str, out);
+        return true;
+      }
+      case kTagBlob: {
+        std::string_view blob;
+        if (!ReadBytes(&blob)) return false;
+        out->set_mutable_blob(blob.data(), blob.size());
+        return true;
+      }
+      case kTagVector: {
+        uint64_t count;
+        // Every element takes at least one byte.
+        if (!ReadVarint(&count) || count > Remaining()) return false;
+        out->Clear(Variant::kTypeVector);
+        std::vector<Variant>& vector = out->vector();
+        // Grow as elements are actually read so that a forged count cannot
+        // allocate more than the input justifies at every nesting level.
+        vector.reserve(std::min<uint64_t>(count, kMaxReserve));
+        for (uint64_t i = 0; i < count; i++) {
+          vector.emplace_back();
+          if (!Read(&vector.back(), depth + 1)) return false;
+        }
+        return true;
+      }
+      case kTagMap: {
+        uint64_t count;
+        if (!ReadVarint(&count) || count > Remaining() / 2) return false;
+        out->Clear(Variant::kTypeMap);
+        std::map<Variant, Variant>& map = out->map();
+        for (uint64_t i = 0; i < count; i++) {
+          Variant key;
+          Variant value;
+          if (!Read(&key, depth + 1) || !Read(&value, depth + 1)) return false;
+          map[std::move(key)] = std::move(value);
+        }
+        return true;
+      }
+      default:
+        return false;
+    }
+  }
+
+  bool ReadByte(uint8_t* value) {
+    if (cur_ == end_) return false;
+    *value = *cur_++;
+    return true;
+  }
+
+  bool at_end() const { return cur_ == end_; }
+
+ private:
+  size_t Remaining() const { return static_cast<size_t>(end_ - cur_); }
+
+  static void SetString(std::string_view str, Variant* out) {
+    // Small strings are NUL-terminated, so only strings without embedded NULs
+    // may use them.
+    out->set_mutable_string(std::string(str),
+                            str.find('\0') == std::string_view::npos);
+  }
+
+  bool ReadVarint(uint64_t* value) {
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      uint8_t byte;
+      if (!ReadByte(&byte)) return false;
+      // The tenth byte may only carry the top bit.
+      if (shift == 63 && byte > 1) return false;
+      result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if (!(byte & 0x80)) {
+        *value = result;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool ReadBytes(std::string_view* bytes) {
+    uint64_t size;
+    if (!ReadVarint(&size) || size > Remaining()) return false;
+    *bytes = std::string_view(reinterpret_cast<const char*>(cur_), size);
+    cur_ += size;
+    return true;
+  }
+
+  const uint8_t* cur_;
+  const uint8_t* const end_;
+  // Bytes that interned string refs may still expand to.
+  uint64_t ref_budget_;
+  // Points into the input buffer.
+  std::vector<std::string_view> interned_;
+};
+
+}  // namespace
+
+std::vector<uint8_t> VariantToBinary(const Variant& variant,
+                                     bool intern_keys) {
+  std::vector<uint8_t> out;
+  VariantToBinary(variant, intern_keys, &out);
+  return out;
+}
+
+void VariantToBinary(const Variant& variant, bool intern_keys,
+                     std::vector<uint8_t>* out) {
+  out->push_back(kFormatVersion);
+  BinaryWriter(intern_keys, out).Write(variant, false);
+}
+
+bool BinaryToVariant(const uint8_t* data, size_t size, Variant* variant) {
+  BinaryReader reader(data, size);
+  uint8_t version;
+  if (!reader.ReadByte(&version) || version != kFormatVersion ||
+      !reader.Read(variant, 0) || !reader.at_end()) {
+    variant->set_null();
+    return false;
+  }
+  return true;
+}
+
+}  // namespace UTIL
+// NOLINTNEXTLINE - allow namespace overridden
+}  // namespace FOREVER
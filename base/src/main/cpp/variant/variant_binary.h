@@ -0,0 +1,51 @@
+#ifndef VARIANT_BINARY_H_
+#define VARIANT_BINARY_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "variant.h"
+
+namespace FOREVER {
+namespace UTIL {
+
+// Compact binary encoding of a Variant, produced and consumed in a single pass
+// without an intermediate builder. Unlike JSON and Flexbuffers it represents
+// every Variant type, including blobs.
+//
+// Layout: one format version byte followed by one value. Each value is a tag
+// byte and a payload:
+//   null, false, true      no payload
+//   int64                  zigzag varint
+//   double                 8 bytes, little endian
+//   string, blob           varint length, then the bytes
+//   vector                 varint count, then count values
+//   map                    varint count, then count key/value pairs
+//   interned string        varint length and bytes, remembered in a table
+//   interned string ref    varint index into that table
+// Static and mutable strings (and blobs) encode identically and decode as
+// mutable. Hash maps encode as maps and decode as ordered maps.
+
+// Converts a Variant to the compact binary encoding. When `intern_keys` is set,
+// string map keys are written once and referenced by index afterwards, which
+// shrinks documents made of many maps with the same shape.
+std::vector<uint8_t> VariantToBinary(const Variant& variant,
+                                     bool intern_keys = false);
+
+// Appends the compact binary encoding of `variant` to `out`.
+void VariantToBinary(const Variant& variant, bool intern_keys,
+                     std::vector<uint8_t>* out);
+
+// Converts from the compact binary encoding to a Variant. The input may be
+// untrusted: truncated or malformed data, oversized lengths, nesting deeper
+// than 128 levels and interned string refs expanding to more than 64 times
+// `size` bytes in total are rejected. Returns true on success, false
+// otherwise, in which case `variant` is set to null.
+bool BinaryToVariant(const uint8_t* data, size_t size, Variant* variant);
+
+}  // namespace UTIL
+// NOLINTNEXTLINE - allow namespace overridden
+}  // namespace FOREVER
+
+#endif  // VARIANT_BINARY_H_
@@ -0,0 +1,146 @@
+#include "variant_hash_map.h"
+
+#include <string.h>
+
+namespace FOREVER {
+
+VariantHashMap::VariantHashMap(bool insertion_ordered)
+    : insertion_ordered_(insertion_ordered),
+      index_(0, IndexHash{this}, IndexEq{this}) {}
+
+VariantHashMap::VariantHashMap(const std::map<Variant, Variant>& map,
+                               bool insertion_ordered)
+    : VariantHashMap(insertion_ordered) {
+  reserve(map.size());
+  for (const auto& entry : map) {
+    Emplace(entry.first, entry.second);
+  }
+}
+
+VariantHashMap::VariantHashMap(const VariantHashMap& other)
+    : insertion_ordered_(other.insertion_ordered_),
+      entries_(other.entries_),
+      hashes_(other.hashes_),
+      index_(0, IndexHash{this}, IndexEq{this}) {
+  RebuildIndex();
+}
+
+VariantHashMap& VariantHashMap::operator=(const VariantHashMap& other) {
+  if (this != &other) {
+    insertion_ordered_ = other.insertion_ordered_;
+    index_.clear();
+    entries_ = other.entries_;
+    hashes_ = other.hashes_;
+    RebuildIndex();
+  }
+  return *this;
+}
+
+void VariantHashMap::clear() {
+  index_.clear();
+  entries_.clear();
+  hashes_.clear();
+}
+
+void VariantHashMap::reserve(size_t size) {
+  entries_.reserve(size);
+  hashes_.reserve(size);
+  index_.reserve(size);
+}
+
+const Variant* VariantHashMap::Find(const Variant& key) const {
+  return FindProbe(Probe{&key, std::string_view(), Variant::Hash()(key)});
+}
+
+Variant* VariantHashMap::Find(const Variant& key) {
+  return const_cast<Variant*>(
+      static_cast<const VariantHashMap*>(this)->Find(key));
+}
+
+const Variant* VariantHashMap::FindString(std::string_view key) const {
+  return FindProbe(
+      Probe{nullptr, key, Variant::HashString(key.data(), key.size())});
+}
+
+Variant* VariantHashMap::FindString(std::string_view key) {
+  return const_cast<Variant*>(
+      static_cast<const VariantHashMap*>(this)->FindString(key));
+}
+
+std::pair<Variant*, bool> VariantHashMap::Emplace(const Variant& key,
+                                                  Variant value) {
+  const size_t hash = Variant::Hash()(key);
+  auto it = index_.find(Probe{&key, std::string_view(), hash});
+  if (it != index_.end()) {
+    return std::make_pair(&entries_[*it].second, false);
+  }
+  entries_.emplace_back(key, std::move(value));
+  hashes_.push_back(hash);
+  index_.insert(entries_.size() - 1);
+  return std::make_pair(&entries_.back().second, true);
+}
+
+bool VariantHashMap::Erase(const Variant& key) {
+  auto it = index_.find(Probe{&key, std::string_view(), Variant::Hash()(key)});
+  if (it == index_.end()) return false;
+  const size_t position = *it;
+  index_.erase(it);
+  if (insertion_ordered_) {
+    entries_.erase(entries_.begin() + position);
+    hashes_.erase(hashes_.begin() + position);
+    // Every later position shifted down by one.
+    RebuildIndex();
+    return true;
+  }
+  const size_t last = entries_.size() - 1;
+  if (position != last) {
+    index_.erase(last);
+    entries_[position] = std::move(entries_[last]);
+    hashes_[position] = hashes_[last];
+  }
+  entries_.pop_back();
+  hashes_.pop_back();
+  if (position != last) index_.insert(position);
+  return true;
+}
+
+std::map<Variant, Variant> VariantHashMap::ToMap() const {
+  std::map<Variant, Variant> map;
+  for (const Entry& entry : entries_) {
+    map.emplace(entry.first, entry.second);
+  }
+  return map;
+}
+
+bool VariantHashMap::operator==(const VariantHashMap& other) const {
+  if (size() != other.size()) return false;
+  for (size_t i = 0; i < entries_.size(); i++) {
+    const Variant* value = other.FindProbe(
+        Probe{&entries_[i].first, std::string_view(), hashes_[i]});
+    if (value == nullptr || *value != entries_[i].second) return false;
+  }
+  return true;
+}
+
+bool VariantHashMap::Matches(size_t position, const Probe& probe) const {
+  if (hashes_[position] != probe.hash) return false;
+  const Variant& key = entries_[position].first;
+  if (probe.key != nullptr) return key == *probe.key;
+  return key.is_string() && probe.string_key == key.string_value();
+}
+
+const Variant* VariantHashMap::FindProbe(const Probe& probe) const {
+  auto it = index_.find(probe);
+  return it == index_.end() ? nullptr : &entries_[*it].second;
+}
+
+void VariantHashMap::RebuildIndex() {
+  index_.clear();
+  index_.reserve(entries_.size());
+  for (size_t i = 0; i < entries_.size(); i++) {
+    index_.insert(i);
+  }
+}
+
+// NOLINTNEXTLINE - allow namespace overridden
+}  // namespace FOREVER
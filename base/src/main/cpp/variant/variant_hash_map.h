@@ -0,0 +1,137 @@
+#ifndef VARIANT_HASH_MAP_H_
+#define VARIANT_HASH_MAP_H_
+
+#include <stddef.h>
+
+#include <map>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "variant.h"
+
+namespace FOREVER {
+
+/// @brief Hash table mapping Variant to Variant, held by Variants of type
+/// HashMap.
+///
+/// Entries are stored densely and indexed by an open-addressing table. The
+/// hash of each key is computed once on insertion and cached, so lookups and
+/// rehashes never rehash string or blob payloads, and string keys can be
+/// looked up with FindString() without building a Variant.
+///
+/// In insertion-ordered mode iteration follows insertion order and Erase() is
+/// O(n). Otherwise the iteration order is unspecified and Erase() moves the
+/// last entry into the hole.
+///
+/// Unlike std::map, entries live in a vector: inserting, reserve() and Erase()
+/// may move them, invalidating iterators and pointers or references to keys
+/// and values, including those returned by Find(), operator[] and Emplace().
+class VariantHashMap {
+ public:
+  typedef std::pair<Variant, Variant> Entry;
+  typedef std::vector<Entry>::const_iterator const_iterator;
+
+  explicit VariantHashMap(bool insertion_ordered = false);
+
+  /// @brief Build a hash map with the entries of `map`.
+  explicit VariantHashMap(const std::map<Variant, Variant>& map,
+                          bool insertion_ordered = false);
+
+  VariantHashMap(const VariantHashMap& other);
+  VariantHashMap& operator=(const VariantHashMap& other);
+
+  bool insertion_ordered() const { return insertion_ordered_; }
+  size_t size() const { return entries_.size(); }
+  bool empty() const { return entries_.empty(); }
+  void clear();
+  void reserve(size_t size);
+
+  const_iterator begin() const { return entries_.begin(); }
+  const_iterator end() const { return entries_.end(); }
+
+  /// @brief Get the value for `key`, or nullptr if there is none.
+  const Variant* Find(const Variant& key) const;
+  Variant* Find(const Variant& key);
+
+  /// @brief Get the value for the string key `key`, or nullptr if there is
+  /// none. Matches keys of any string type.
+  const Variant* FindString(std::string_view key) const;
+  Variant* FindString(std::string_view key);
+
+  bool Contains(const Variant& key) const { return Find(key) != nullptr; }
+
+  /// @brief Get the value for `key`, inserting a null value if there is none.
+  ///
+  /// @note The reference is invalidated by the next insertion, so
+  /// `map[a] = map[b]` can write through a dangling reference unless both
+  /// keys are already present.
+  Variant& operator[](const Variant& key) { return *Emplace(key).first; }
+
+  /// @brief Insert `key` with `value` unless `key` is already present.
+  ///
+  /// @return The value stored for `key`, and whether it was inserted. The
+  /// pointer is invalidated by the next insertion or Erase().
+  std::pair<Variant*, bool> Emplace(const Variant& key,
+                                    Variant value = Variant());
+
+  /// @brief Remove `key`.
+  ///
+  /// @return True if `key` was present.
+  bool Erase(const Variant& key);
+
+  /// @brief Copy the entries into an ordered map.
+  std::map<Variant, Variant> ToMap() const;
+
+  /// @brief Whether both maps hold the same entries, in any order.
+  bool operator==(const VariantHashMap& other) const;
+  bool operator!=(const VariantHashMap& other) const {
+    return !(*this == other);
+  }
+
+ private:
+  // A key being looked up: either a Variant or, if `key` is null, a string.
+  struct Probe {
+    const Variant* key;
+    std::string_view string_key;
+    size_t hash;
+  };
+
+  // The index stores positions into entries_; hashing and comparing them
+  // goes through the owning map.
+  struct IndexHash {
+    using is_transparent = void;
+    size_t operator()(size_t position) const {
+      return map->hashes_[position];
+    }
+    size_t operator()(const Probe& probe) const { return probe.hash; }
+    const VariantHashMap* map;
+  };
+  struct IndexEq {
+    using is_transparent = void;
+    bool operator()(size_t a, size_t b) const { return a == b; }
+    bool operator()(size_t position, const Probe& probe) const {
+      return map->Matches(position, probe);
+    }
+    bool operator()(const Probe& probe, size_t position) const {
+      return map->Matches(position, probe);
+    }
+    const VariantHashMap* map;
+  };
+  typedef absl::flat_hash_set<size_t, IndexHash, IndexEq> Index;
+
+  bool Matches(size_t position, const Probe& probe) const;
+  const Variant* FindProbe(const Probe& probe) const;
+  void RebuildIndex();
+
+  bool insertion_ordered_;
+  std::vector<Entry> entries_;
+  std::vector<size_t> hashes_;
+  Index index_;
+};
+
+// NOLINTNEXTLINE - allow namespace overridden
+}  // namespace FOREVER
+
+#endif  // VARIANT_HASH_MAP_H_
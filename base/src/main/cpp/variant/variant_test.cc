@@ -0,0 +1,55 @@
+#include "variant.h"
+
+#include <string>
+#include <utility>
+
+#include <gtest/gtest.h>
+
+namespace FOREVER {
+namespace {
+
+// Long enough not to fit a small string, so that it gets a shared payload.
+const char kLongString[] = "a string too long for the small string buffer";
+
+TEST(VariantTest, CopyAssignOwnVectorElement) {
+  Variant variant = Variant::EmptyVector();
+  variant.vector().push_back(Variant(std::string(kLongString)));
+  variant.vector().push_back(Variant(int64_t{2}));
+  variant = variant.vector()[0];
+  EXPECT_EQ(variant, Variant(std::string(kLongString)));
+
+  variant = Variant::EmptyVector();
+  variant.vector().push_back(Variant(int64_t{1}));
+  variant = variant.vector()[0];
+  EXPECT_EQ(variant, Variant(int64_t{1}));
+}
+
+TEST(VariantTest, CopyAssignOwnMapValue) {
+  Variant variant = Variant::EmptyMap();
+  Variant inner = Variant::EmptyVector();
+  inner.vector().push_back(Variant(int64_t{3}));
+  variant.map()[Variant("key")] = inner;
+  variant = variant.map()[Variant("key")];
+  EXPECT_EQ(variant, inner);
+}
+
+TEST(VariantTest, MoveAssignOwnVectorElement) {
+  Variant variant = Variant::EmptyVector();
+  variant.vector().push_back(Variant(std::string(kLongString)));
+  variant = std::move(variant.vector()[0]);
+  EXPECT_EQ(variant, Variant(std::string(kLongString)));
+}
+
+TEST(VariantTest, CopyAssignSharesPayload) {
+  Variant a = Variant::EmptyVector();
+  a.vector().push_back(Variant(int64_t{1}));
+  Variant b;
+  b = a;
+  b.vector().push_back(Variant(int64_t{2}));
+  EXPECT_EQ(a.vector().size(), 1u);
+  EXPECT_EQ(b.vector().size(), 2u);
+}
+
+}  // namespace
+// NOLINTNEXTLINE - allow namespace overridden
+}  // namespace FOREVER
@@ -1,7 +1,7 @@
 #include "variant_util.h"
 
-#include <sstream>
-
+#include "variant_hash_map.h"
+#include "absl/strings/str_format.h"
 #include "flatbuffers/flatbuffers.h"
 #include "flatbuffers/flexbuffers.h"
 #include "flatbuffers/idl.h"
@@ -9,45 +9,51 @@
 
 #include "../logging.h"
 #include "../log_settings.h"
+#include "../string/string_builder.h"
 
 #define FLEXBUFFER_BUILDER_STARTING_SIZE 512
 
 namespace FOREVER {
 namespace UTIL {
 
-// Forward declarations for stringstream variations of the *ToJson functions
+using base::string::StringBuilder;
+
+// Forward declarations for StringBuilder variations of the *ToJson functions
 // since these aren't made available in the header. These return true on success
 // and false on failure. Failure is a result of using binary blobs in the
 // variant, or using types that cannot be coerced to a string as a key in a map.
 static bool VariantToJson(const Variant& variant, bool prettyPrint,
-                          const std::string& indent, std::stringstream* ss);
-static bool StdMapToJson(const std::map<Variant, Variant>& map,
-                         bool prettyPrint, const std::string& indent,
-                         std::stringstream* ss);
+                          const std::string& indent, StringBuilder* out);
+template <typename MapType>
+static bool StdMapToJson(const MapType& map, bool prettyPrint,
+                         const std::string& indent, StringBuilder* out);
 static bool StdVectorToJson(const std::vector<Variant>& vector,
                             bool prettyPrint, const std::string& indent,
-                            std::stringstream* ss);
+                            StringBuilder* out);
 
 static bool VariantToJson(const Variant& variant, bool prettyPrint,
-                          const std::string& indent, std::stringstream* ss) {
+                          const std::string& indent, StringBuilder* out) {
   switch (variant.type()) {
     case Variant::kTypeNull: {
-      *ss << "null";
+      out->Append("null");
       break;
     }
     case Variant::kTypeInt64: {
-      *ss << variant.int64_value();
+      out->Append(variant.int64_value());
       break;
     }
     case Variant::kTypeDouble: {
       // IEEE 754 double-precision binary floating-point format: binary64 — The
       // 53-bit significand precision gives from 15 to 17 significant decimal
       // digits Default 32-bit only keeps 7 digit precision
-      *ss << std::setprecision(17) << variant.double_value();
+      char buffer[32];
+      const int length = absl::SNPrintF(buffer, sizeof(buffer), "%.17g",
+                                        variant.double_value());
+      out->Append(absl::string_view(buffer, length));
       break;
     }
     case Variant::kTypeBool: {
-      *ss << (variant.bool_value() ? "true" : "false");
+      out->Append(variant.bool_value() ? "true" : "false");
       break;
     }
     case Variant::kTypeStaticString:
@@ -57,17 +63,23 @@ static bool VariantToJson(const Variant& variant, bool prettyPrint,
       size_t len = variant.is_mutable_string() ? variant.mutable_string().size()
                                                : strlen(str);
       flatbuffers::EscapeString(str, len, &escaped_string, true, false);
-      *ss << escaped_string;
+      out->Append(escaped_string);
       break;
     }
     case Variant::kTypeVector: {
-      if (!StdVectorToJson(variant.vector(), prettyPrint, indent, ss)) {
+      if (!StdVectorToJson(variant.vector(), prettyPrint, indent, out)) {
         return false;
       }
       break;
     }
     case Variant::kTypeMap: {
-      if (!StdMapToJson(variant.map(), prettyPrint, indent, ss)) {
+      if (!StdMapToJson(variant.map(), prettyPrint, indent, out)) {
+        return false;
+      }
+      break;
+    }
+    case Variant::kTypeHashMap: {
+      if (!StdMapToJson(variant.hash_map(), prettyPrint, indent, out)) {
         return false;
       }
       break;
@@ -81,14 +93,15 @@ static bool VariantToJson(const Variant& variant, bool prettyPrint,
   return true;
 }
 
-static bool StdMapToJson(const std::map<Variant, Variant>& map,
-                         bool prettyPrint, const std::string& indent,
-                         std::stringstream* ss) {
-  *ss << '{';
+// Works on both std::map<Variant, Variant> and VariantHashMap.
+template <typename MapType>
+static bool StdMapToJson(const MapType& map, bool prettyPrint,
+                         const std::string& indent, StringBuilder* out) {
+  out->push_back('{');
   std::string nextIndent = indent + "  ";
   for (auto iter = map.begin(); iter != map.end();) {
     if (prettyPrint) {
-      *ss << '\n' << nextIndent;
+      out->Append("\n", nextIndent);
     }
     // JSON only supports string keys, return false if the key is not a type
     // that can be coerced to a string.
@@ -97,47 +110,47 @@ static bool StdMapToJson(const std::map<Variant, Variant>& map,
           "Variants of non-fundamental types may not be used as map keys.");
       return false;
     }
-    if (!VariantToJson(iter->first.AsString(), prettyPrint, nextIndent, ss)) {
+    if (!VariantToJson(iter->first.AsString(), prettyPrint, nextIndent, out)) {
       return false;
     }
-    *ss << ':';
+    out->push_back(':');
     if (prettyPrint) {
-      *ss << ' ';
+      out->push_back(' ');
     }
-    if (!VariantToJson(iter->second, prettyPrint, nextIndent, ss)) {
+    if (!VariantToJson(iter->second, prettyPrint, nextIndent, out)) {
       return false;
     }
     if (++iter != map.end()) {
-      *ss << ',';
+      out->push_back(',');
     }
   }
   if (prettyPrint) {
-    *ss << '\n' << indent;
+    out->Append("\n", indent);
   }
-  *ss << '}';
+  out->push_back('}');
   return true;
 }
 
 static bool StdVectorToJson(const std::vector<Variant>& vector,
                             bool prettyPrint, const std::string& indent,
-                            std::stringstream* ss) {
-  *ss << '[';
+                            StringBuilder* out) {
+  out->push_back('[');
   std::string nextIndent = indent + "  ";
   for (auto iter = vector.begin(); iter != vector.end();) {
     if (prettyPrint) {
-      *ss << '\n' << nextIndent;
+      out->Append("\n", nextIndent);
     }
-    if (!VariantToJson(*iter, prettyPrint, nextIndent, ss)) {
+    if (!VariantToJson(*iter, prettyPrint, nextIndent, out)) {
       return false;
     }
     if (++iter != vector.end()) {
-      *ss << ',';
+      out->push_back(',');
     }
   }
   if (prettyPrint) {
-    *ss << '\n' << indent;
+    out->Append("\n", indent);
   }
-  *ss << ']';
+  out->push_back(']');
   return true;
 }
 
@@ -146,29 +159,29 @@ std::string VariantToJson(const Variant& variant) {
 }
 
 std::string VariantToJson(const Variant& variant, bool prettyPrint) {
-  std::stringstream ss;
-  if (!VariantToJson(variant, prettyPrint, "", &ss)) {
+  StringBuilder out;
+  if (!VariantToJson(variant, prettyPrint, "", &out)) {
     return "";
   }
-  return ss.str();
+  return out.ToString();
 }
 
 // Converts an std::map<Variant, Variant> to Json
 std::string StdMapToJson(const std::map<Variant, Variant>& map) {
-  std::stringstream ss;
-  if (!StdMapToJson(map, false, "", &ss)) {
+  StringBuilder out;
+  if (!StdMapToJson(map, false, "", &out)) {
     return "";
   }
-  return ss.str();
+  return out.ToString();
 }
 
 // Converts an std::vector<Variant> to Json
 std::string StdVectorToJson(const std::vector<Variant>& vector) {
-  std::stringstream ss;
-  if (!StdVectorToJson(vector, false, "", &ss)) {
+  StringBuilder out;
+  if (!StdVectorToJson(vector, false, "", &out)) {
     return "";
   }
-  return ss.str();
+  return out.ToString();
 }
 
 Variant FlexbufferVectorToVariant(const flexbuffers::Vector& vector) {
@@ -285,6 +298,12 @@ bool VariantToFlexbuffer(const Variant& variant, flexbuffers::Builder* fbb) {
       }
       break;
     }
+    case Variant::kTypeHashMap: {
+      if (!VariantMapToFlexbuffer(variant.hash_map(), fbb)) {
+        return false;
+      }
+      break;
+    }
     case Variant::kTypeStaticBlob:
     case Variant::kTypeMutableBlob: {
       BASE_LOG(ERROR) << ("Variants containing blobs are not supported.");
@@ -294,8 +313,11 @@ bool VariantToFlexbuffer(const Variant& variant, flexbuffers::Builder* fbb) {
   return true;
 }
 
-bool VariantMapToFlexbuffer(const std::map<Variant, Variant>& map,
-                            flexbuffers::Builder* fbb) {
+// Works on both std::map<Variant, Variant> and VariantHashMap; the builder
+// sorts the keys of a map itself.
+template <typename MapType>
+static bool MapEntriesToFlexbuffer(const MapType& map,
+                                   flexbuffers::Builder* fbb) {
   auto start = fbb->StartMap();
   for (auto iter = map.begin(); iter != map.end(); ++iter) {
     // Flexbuffers only supports string keys, return false if the key is not a
@@ -318,6 +340,16 @@ bool VariantMapToFlexbuffer(const std::map<Variant, Variant>& map,
   return true;
 }
 
+bool VariantMapToFlexbuffer(const std::map<Variant, Variant>& map,
+                            flexbuffers::Builder* fbb) {
+  return MapEntriesToFlexbuffer(map, fbb);
+}
+
+bool VariantMapToFlexbuffer(const VariantHashMap& map,
+                            flexbuffers::Builder* fbb) {
+  return MapEntriesToFlexbuffer(map, fbb);
+}
+
 bool VariantVectorToFlexbuffer(const std::vector<Variant>& vector,
                                flexbuffers::Builder* fbb) {
   auto start = fbb->StartVector();
@@ -51,6 +51,11 @@ bool VariantToFlexbuffer(const Variant& variant, flexbuffers::Builder* fbb);
 bool VariantMapToFlexbuffer(const std::map<Variant, Variant>& map,
                             flexbuffers::Builder* fbb);
 
+// Convert from a variant hash map to a Flexbuffer using the given flexbuffer
+// Builder. Returns true on success, false otherwise.
+bool VariantMapToFlexbuffer(const VariantHashMap& map,
+                            flexbuffers::Builder* fbb);
+
 // Convert from a variant to a Flexbuffer using the given flexbuffer Builder.
 // Returns true on success, false otherwise.
 bool VariantVectorToFlexbuffer(const std::vector<Variant>& vector,
@@ -0,0 +1,144 @@
+#include "variant_view.h"
+
+#include <string.h>
+
+#include "variant_util.h"
+
+namespace FOREVER {
+
+namespace {
+
+// Binary search over the sorted keys of `map`. FlexBuffers stores map keys
+// ordered by strcmp.
+bool FindKey(const flexbuffers::Map& map, const char* key, size_t* index) {
+  flexbuffers::TypedVector keys = map.Keys();
+  size_t low = 0;
+  size_t high = keys.size();
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    int cmp = strcmp(keys[mid].AsKey(), key);
+    if (cmp == 0) {
+      *index = mid;
+      return true;
+    }
+    if (cmp < 0) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+bool VariantView::Verify(const uint8_t* data, size_t size) {
+  return flexbuffers::VerifyBuffer(data, size);
+}
+
+Variant::Type VariantView::type() const {
+  switch (ref_.GetType()) {
+    case flexbuffers::FBT_NULL:
+      return Variant::kTypeNull;
+    case flexbuffers::FBT_BOOL:
+      return Variant::kTypeBool;
+    case flexbuffers::FBT_INT:
+    case flexbuffers::FBT_INDIRECT_INT:
+    case flexbuffers::FBT_UINT:
+    case flexbuffers::FBT_INDIRECT_UINT:
+      return Variant::kTypeInt64;
+    case flexbuffers::FBT_FLOAT:
+    case flexbuffers::FBT_INDIRECT_FLOAT:
+      return Variant::kTypeDouble;
+    case flexbuffers::FBT_STRING:
+    case flexbuffers::FBT_KEY:
+      return Variant::kTypeStaticString;
+    case flexbuffers::FBT_MAP:
+      return Variant::kTypeMap;
+    case flexbuffers::FBT_BLOB:
+      return Variant::kTypeStaticBlob;
+    case flexbuffers::FBT_VECTOR_BOOL:
+    case flexbuffers::FBT_VECTOR_FLOAT2:
+    case flexbuffers::FBT_VECTOR_FLOAT3:
+    case flexbuffers::FBT_VECTOR_FLOAT4:
+    case flexbuffers::FBT_VECTOR_FLOAT:
+    case flexbuffers::FBT_VECTOR_INT2:
+    case flexbuffers::FBT_VECTOR_INT3:
+    case flexbuffers::FBT_VECTOR_INT4:
+    case flexbuffers::FBT_VECTOR_INT:
+    case flexbuffers::FBT_VECTOR_KEY:
+    case flexbuffers::FBT_VECTOR_STRING_DEPRECATED:
+    case flexbuffers::FBT_VECTOR_UINT2:
+    case flexbuffers::FBT_VECTOR_UINT3:
+    case flexbuffers::FBT_VECTOR_UINT4:
+    case flexbuffers::FBT_VECTOR_UINT:
+    case flexbuffers::FBT_VECTOR:
+      return Variant::kTypeVector;
+  }
+  return Variant::kTypeNull;
+}
+
+const char* VariantView::string_value() const {
+  if (ref_.IsString()) return ref_.AsString().c_str();
+  if (ref_.IsKey()) return ref_.AsKey();
+  return "";
+}
+
+size_t VariantView::string_size() const {
+  if (ref_.IsString()) return ref_.AsString().size();
+  if (ref_.IsKey()) return strlen(ref_.AsKey());
+  return 0;
+}
+
+const uint8_t* VariantView::blob_data() const {
+  return ref_.IsBlob() ? ref_.AsBlob().data() : nullptr;
+}
+
+size_t VariantView::blob_size() const {
+  return ref_.IsBlob() ? ref_.AsBlob().size() : 0;
+}
+
+size_t VariantView::size() const {
+  if (ref_.IsMap()) return ref_.AsMap().size();
+  if (ref_.IsUntypedVector()) return ref_.AsVector().size();
+  if (ref_.IsTypedVector()) return ref_.AsTypedVector().size();
+  if (ref_.IsFixedTypedVector()) return ref_.AsFixedTypedVector().size();
+  return 0;
+}
+
+VariantView VariantView::operator[](size_t index) const {
+  if (index >= size() || ref_.IsMap()) return VariantView();
+  if (ref_.IsUntypedVector()) return VariantView(ref_.AsVector()[index]);
+  if (ref_.IsTypedVector()) return VariantView(ref_.AsTypedVector()[index]);
+  return VariantView(ref_.AsFixedTypedVector()[index]);
+}
+
+VariantView VariantView::operator[](const char* key) const {
+  if (!ref_.IsMap()) return VariantView();
+  flexbuffers::Map map = ref_.AsMap();
+  size_t index;
+  if (!FindKey(map, key, &index)) return VariantView();
+  return VariantView(map.Values()[index]);
+}
+
+bool VariantView::contains(const char* key) const {
+  size_t index;
+  return ref_.IsMap() && FindKey(ref_.AsMap(), key, &index);
+}
+
+VariantView VariantView::key_at(size_t index) const {
+  if (!ref_.IsMap() || index >= ref_.AsMap().size()) return VariantView();
+  return VariantView(ref_.AsMap().Keys()[index]);
+}
+
+VariantView VariantView::value_at(size_t index) const {
+  if (!ref_.IsMap() || index >= ref_.AsMap().size()) return VariantView();
+  return VariantView(ref_.AsMap().Values()[index]);
+}
+
+Variant VariantView::ToVariant() const {
+  return UTIL::FlexbufferToVariant(ref_);
+}
+
+// NOLINTNEXTLINE - allow namespace overridden
+}  // namespace FOREVER
@@ -0,0 +1,123 @@
+#ifndef VARIANT_VIEW_H_
+#define VARIANT_VIEW_H_
+
+#include <stdint.h>
+
+#include <string>
+
+#include "variant.h"
+#include "flatbuffers/flexbuffers.h"
+
+namespace FOREVER {
+
+/// @brief Read-only view of a FlexBuffer value offering the accessors of
+/// Variant.
+///
+/// Unlike FlexbufferToVariant(), nothing is copied: type checks, scalar reads,
+/// vector indexing and map lookups go straight to the underlying buffer. The
+/// view, and any string or blob pointer obtained from it, is only valid as
+/// long as that buffer is, which makes it suitable for mmap'd files.
+///
+/// Strings are reported as kTypeStaticString and blobs as kTypeStaticBlob,
+/// since the view points to data it does not own. Typed and fixed-size
+/// FlexBuffer vectors are reported as kTypeVector.
+///
+/// As with Variant, calling an accessor that does not match type() is a
+/// programming error; the result is then FlexBuffers' own best-effort
+/// conversion.
+class VariantView {
+ public:
+  /// @brief Construct a view of type Null.
+  VariantView() = default;
+
+  /// @brief Construct a view of the given FlexBuffer value.
+  explicit VariantView(const flexbuffers::Reference& ref) : ref_(ref) {}
+
+  /// @brief Get a view of the root of a finished FlexBuffer.
+  ///
+  /// The buffer is not verified; use Verify() first for untrusted data.
+  static VariantView FromBuffer(const uint8_t* data, size_t size) {
+    return VariantView(flexbuffers::GetRoot(data, size));
+  }
+
+  /// @brief Check that `data` is a well-formed FlexBuffer that can be read
+  /// through a view without reading out of bounds.
+  static bool Verify(const uint8_t* data, size_t size);
+
+  /// @brief Get the type this view would have as a Variant.
+  Variant::Type type() const;
+
+  bool is_null() const { return type() == Variant::kTypeNull; }
+  bool is_int64() const { return type() == Variant::kTypeInt64; }
+  bool is_double() const { return type() == Variant::kTypeDouble; }
+  bool is_bool() const { return type() == Variant::kTypeBool; }
+  bool is_string() const { return type() == Variant::kTypeStaticString; }
+  bool is_vector() const { return type() == Variant::kTypeVector; }
+  bool is_map() const { return type() == Variant::kTypeMap; }
+  bool is_blob() const { return type() == Variant::kTypeStaticBlob; }
+  bool is_numeric() const { return is_int64() || is_double(); }
+  bool is_fundamental_type() const {
+    return is_int64() || is_double() || is_string() || is_bool() || is_null();
+  }
+  bool is_container_type() const { return is_vector() || is_map(); }
+
+  int64_t int64_value() const { return ref_.AsInt64(); }
+
+  double double_value() const { return ref_.AsDouble(); }
+
+  bool bool_value() const { return ref_.AsBool(); }
+
+  /// @brief Get the string value, NUL-terminated inside the buffer. Returns
+  /// an empty string if this is not a string.
+  const char* string_value() const;
+
+  /// @brief Get the length of string_value() in bytes.
+  size_t string_size() const;
+
+  /// @brief Get a pointer to the blob data inside the buffer, or nullptr if
+  /// this is not a blob.
+  const uint8_t* blob_data() const;
+
+  /// @brief Get the size of the blob in bytes.
+  size_t blob_size() const;
+
+  /// @brief Get the number of elements of a vector or entries of a map, or 0
+  /// for any other type.
+  size_t size() const;
+
+  /// @brief Get the vector element at `index`. Returns a Null view if this is
+  /// not a vector or `index` is out of range.
+  VariantView operator[](size_t index) const;
+
+  /// @brief Look up `key` in a map by binary search over the buffer's sorted
+  /// keys. Returns a Null view if this is not a map or the key is absent; use
+  /// contains() to tell an absent key from a null value.
+  VariantView operator[](const char* key) const;
+  VariantView operator[](const std::string& key) const {
+    return (*this)[key.c_str()];
+  }
+
+  /// @brief Whether this is a map containing `key`.
+  bool contains(const char* key) const;
+
+  /// @brief Get the key of the map entry at `index`, in key order.
+  VariantView key_at(size_t index) const;
+
+  /// @brief Get the value of the map entry at `index`, in key order.
+  VariantView value_at(size_t index) const;
+
+  /// @brief Copy the viewed value into an owning Variant, as
+  /// FlexbufferToVariant() does.
+  Variant ToVariant() const;
+
+  /// @brief Get the underlying FlexBuffer reference.
+  const flexbuffers::Reference& reference() const { return ref_; }
+
+ private:
+  flexbuffers::Reference ref_;
+};
+
+// NOLINTNEXTLINE - allow namespace overridden
+}  // namespace FOREVER
+
+#endif  // VARIANT_VIEW_H_